@@ -23,6 +23,8 @@ void octopus_define_problem(
     std::string rot_dir_str = "";
     std::string mom_cons_str = "";
 
+    bool silo_output = false;
+
     octopus::config_reader reader("octopus.3d_torus");
 
     reader
@@ -34,6 +36,9 @@ void octopus_define_problem(
         ("kappa", kappa, 1.0)
         ("X_in", X_in, 0.5)
         ("kick_mode", kick_mode, 0) 
+        ("diagnostics_interval", diagnostics_interval, 0)
+        ("probe_points", probe_points, 0)
+        ("silo_output", silo_output, false)
     ;
 
     if (rot_dir_str == "clockwise")
@@ -68,6 +73,12 @@ void octopus_define_problem(
            % X_in.get())
         << ( boost::format("kick_mode                     = %i\n")
            % kick_mode.get())
+        << ( boost::format("diagnostics_interval          = %i\n")
+           % diagnostics_interval.get())
+        << ( boost::format("probe_points                  = %i\n")
+           % probe_points.get())
+        << ( boost::format("silo_output                   = %i\n")
+           % silo_output)
         << "\n";
 
     // FIXME: Move this into core code.
@@ -97,7 +108,13 @@ void octopus_define_problem(
     sci.predict_dt = cfl_predict_dt(max_dt_growth, temporal_prediction_limiter);
 
     sci.refine_policy = refine_by_geometry();
-    sci.distribute = slice_distribution();
+
+    // The slice distribution does not know about node costs; refine replaces
+    // whatever is installed with a cost-partitioned curve.
+    if (octopus::config().rebalance_on_refine)
+        sci.distribute = octopus::space_filling_curve_distribution();
+    else
+        sci.distribute = slice_distribution();
 
 /*
     octopus::multi_writer mw;
@@ -125,16 +142,99 @@ void octopus_define_problem(
         sci.output = octopus::single_variable_silo_writer(0, "rho");
     #endif
 */
-    sci.output = octopus::fstream_writer(
-        output_equatorial_plane(octopus::z_axis)
-      , "slice_z_L%06u_S%06u.dat");
+    // Binary slices of the equatorial plane; octopus_slice_to_text converts
+    // them to the text format written by output_equatorial_plane.
+    octopus::slice_writer slices(octopus::z_axis, 1e-7
+                               , "slice_z_L%06u_S%06u.bin");
+
+    #if defined(OCTOPUS_HAVE_SILO)
+        if (silo_output)
+        {
+            // Density, energy and the entropy tracer, written from one pass
+            // over the tree.
+            std::vector<boost::uint64_t> indices;
+            std::vector<std::string> names;
+
+            indices.push_back(0); names.push_back("rho");
+            indices.push_back(4); names.push_back("total_energy");
+            indices.push_back(5); names.push_back("tau");
+
+            octopus::multi_writer mw;
+
+            mw.add_writer(octopus::silo_writer(indices, names));
+            mw.add_writer(slices);
+
+            sci.output = mw;
+            return;
+        }
+    #else
+        OCTOPUS_ASSERT_MSG(!silo_output,
+            "silo_output requires octopus to be built with Silo");
+    #endif
+
+    sci.output = slices;
 }
 
+/// Statistics of one timestep, written by stepper::report.
+struct step_report
+{
+    boost::uint64_t step;
+    double time;
+    double dt;
+    double cfl_dt;
+    double walltime;
+    bool output;
+};
+
 struct stepper 
 {
   private:
     double period_;
 
+    void report(
+        step_report const& r
+      , std::ostream& dt_file
+      , std::ostream& speed_file
+        ) const
+    {
+        char const* fmt = "STEP %06u : ORBITS %.7g%|33t| += %.7g%|49t| : "
+                          "SPEED %.7g%|71t| [orbits/hour], "
+                          "%.7g %|99t| [steps/second]";
+
+        double const orbital_speed = ((r.dt / period_) / (r.walltime / 3600));
+
+        double const step_speed = (1 / r.walltime);
+
+        std::cout <<
+            ( boost::format(fmt)
+            % r.step
+            % (r.time / period_)
+            % (r.dt / period_)
+            % orbital_speed 
+            % step_speed
+            );
+
+        if (r.output)
+            std::cout << " : OUTPUT";
+
+        std::cout << "\n";
+
+        // Record timestep size.
+        dt_file << ( boost::format("%i %e %e %e %i\n")
+                   % r.step 
+                   % (r.time / period_) 
+                   % (r.dt / period_) 
+                   % (r.cfl_dt / period_)
+                   % r.output); 
+
+        // Record speed. 
+        speed_file << ( boost::format("%i %e %e %i\n")
+                      % r.step 
+                      % orbital_speed
+                      % step_speed 
+                      % r.output); 
+    }
+
   public:
     stepper() : period_(0.0) {}
 
@@ -196,32 +296,50 @@ struct stepper
 
         std::ofstream dt_file("dt.csv");
         std::ofstream speed_file("speed.csv");
+        std::ofstream diagnostics_file("diagnostics.csv");
  
         dt_file    << "# step, time [orbits], dt [orbits], dt cfl [orbits], "
                       "output?\n";
         speed_file << "# step, orbital speed [orbits/hours], "
                       "step speed [steps/second], output?\n";
+        diagnostics_file << "# step, time [orbits], "
+                            "dt cfl of last flux sweep [orbits], mass, "
+                            "energy, max density, mass flow off, "
+                            "energy flow off\n";
+
+        boost::scoped_ptr<octopus::probe_series> probes;
+
+        if (0 != probe_points)
+        {
+            boost::uint64_t const n = probe_points.get();
+            double const R_inner = X_in * R_outer;
+
+            std::vector<octopus::array<double, 3> > points(n);
+
+            // Put each probe at the center of one of n equal spans.
+            for (boost::uint64_t p = 0; p < n; ++p)
+            {
+                points[p][0] = R_inner + (R_outer - R_inner) * (p + 0.5) / n;
+                points[p][1] = 0.0;
+                points[p][2] = 0.0;
+            }
+
+            probes.reset(new octopus::probe_series(points, "probe.csv"));
+        }
  
         ///////////////////////////////////////////////////////////////////////
         // Crude, temporary stepper.
    
-        if (octopus::config().load_checkpoint) 
-        {
-            // IMPLEMENT: Futurize w/ continutation.
-            octopus::dt_prediction prediction
-                = root.apply_leaf(octopus::science().predict_dt);
-   
-            OCTOPUS_ASSERT(0.0 < prediction.next_dt);
-            OCTOPUS_ASSERT(0.0 < prediction.future_dt);
+        // Upper bound on the size of the next timestep. The CFL timestep is
+        // computed during each step (see octree_server::step_with_cfl).
+        double max_dt = 0.0;
 
-            double next_dt = std::min(prediction.next_dt, root.get_dt() * 1.25);
-
-            root.post_dt(next_dt);
-        }
+        if (octopus::config().load_checkpoint) 
+            max_dt = root.get_dt() * 1.25;
         else
-            root.post_dt(root.apply_leaf(octopus::science().initial_dt));
+            max_dt = root.apply_leaf(octopus::science().initial_dt);
 
-//        root.post_dt(initial_cfl_factor*0.001);
+//        max_dt = initial_cfl_factor*0.001;
         double next_output_time = octopus::config().output_frequency * period_;
 
         hpx::reset_active_counters();
@@ -230,19 +348,38 @@ struct stepper
    
         bool last_step = false;
 
+        // The statistics of the last step are written while the next one
+        // runs.
+        boost::optional<step_report> last_report;
+
         while (!last_step)
         {
             hpx::util::high_resolution_timer local_clock;
 
             boost::uint64_t const this_step = root.get_step();
-            double const this_dt = root.get_dt();
             double const this_time = root.get_time();
 
-            if (  ((this_time + this_dt) / period_)
-               >= octopus::config().temporal_domain)
-                last_step = true;
+            bool const end_of_domain =
+                   ((this_time + max_dt) / period_)
+                >= octopus::config().temporal_domain;
 
-            root.step();
+            if (end_of_domain)
+                max_dt = octopus::config().temporal_domain * period_
+                       - this_time;
+
+            OCTOPUS_ASSERT(0.0 < max_dt);
+
+            hpx::future<double> cfl_dt_f
+                = root.step_with_cfl_async(cfl_factor, max_dt);
+
+            if (last_report)
+                report(*last_report, dt_file, speed_file);
+
+            double const cfl_dt = cfl_dt_f.move();
+            double const this_dt = root.get_dt();
+
+            if (end_of_domain && (this_dt >= max_dt))
+                last_step = true;
    
             bool output_and_refine = false;
 
@@ -271,72 +408,43 @@ struct stepper
 
                 //root.refine();
             }
-  
-            // IMPLEMENT: Futurize w/ continutation.
-            octopus::dt_prediction prediction
-                = root.apply_leaf(octopus::science().predict_dt);
- 
-//            octopus::dt_prediction prediction(0.001, 0.001);
-   
-            OCTOPUS_ASSERT(0.0 < prediction.next_dt);
-            OCTOPUS_ASSERT(0.0 < prediction.future_dt);
-
-            double next_dt = std::min(prediction.next_dt, root.get_dt() * 1.25);
-
-            if (!last_step && (  ((root.get_time() + next_dt) / period_)
-                              >= octopus::config().temporal_domain))
-            {
-                double t = octopus::config().temporal_domain * period_ - root.get_time();
-                OCTOPUS_ASSERT(t <= next_dt);
-                next_dt = t;
-//                std::cout << (boost::format("TIME: %.17e\n") % root.get_time());
-            }
 
-            root.post_dt(next_dt);
+            max_dt = this_dt * 1.25;
 
-            ///////////////////////////////////////////////////////////////////
-            // I/O of stats
-            char const* fmt = "STEP %06u : ORBITS %.7g%|33t| += %.7g%|49t| : "
-                              "SPEED %.7g%|71t| [orbits/hour], "
-                              "%.7g %|99t| [steps/second]";
+            step_report const r =
+                { this_step
+                , this_time
+                , this_dt
+                , cfl_dt
+                , local_clock.elapsed()
+                , output_and_refine };
 
-            double const orbital_speed =
-                ((this_dt / period_) / (local_clock.elapsed() / 3600));
+            last_report = r;
 
-            double const step_speed = (1 / local_clock.elapsed());
-
-            std::cout <<
-                ( boost::format(fmt)
-                % this_step
-                % (this_time / period_)
-                % (this_dt / period_)
-                % orbital_speed 
-                % step_speed
-                );
- 
-            //if (output_and_refine)
-            //    std::cout << ": OUTPUT & REFINE";
-            if (output_and_refine)
-                std::cout << " : OUTPUT";
+            if (  (0 != diagnostics_interval)
+               && (0 == (root.get_step() % diagnostics_interval)))
+            {
+                diagnostics const d = compute_diagnostics(root);
+
+                diagnostics_file <<
+                    ( boost::format("%i %e %e %e %e %e %e %e\n")
+                    % root.get_step()
+                    % (root.get_time() / period_)
+                    % (d.cfl_dt / period_)
+                    % d.mass
+                    % d.energy
+                    % d.max_density
+                    % rho(d.flow_off)
+                    % total_energy(d.flow_off));
+            }
 
-            std::cout << "\n";
- 
-            // Record timestep size.
-            dt_file << ( boost::format("%i %e %e %e %i\n")
-                       % this_step 
-                       % (this_time / period_) 
-                       % (this_dt / period_) 
-                       % (prediction.next_dt / period_)
-                       % output_and_refine); 
-
-            // Record speed. 
-            speed_file << ( boost::format("%i %e %e %i\n")
-                          % this_step 
-                          % orbital_speed
-                          % step_speed 
-                          % output_and_refine); 
+            if (probes)
+                (*probes)(root);
         }
 
+        if (last_report)
+            report(*last_report, dt_file, speed_file);
+
         double solve_walltime = global_clock.elapsed();
 
         std::cout << "\n"
@@ -344,7 +452,27 @@ struct stepper
                   << "SOLVE WALLTIME  " << solve_walltime << " [seconds]\n" 
                   << "TOTAL WALLTIME  "
                   << (refine_walltime + solve_walltime)
-                  << " [seconds]\n"; 
+                  << " [seconds]\n"
+                  << "FLUX SCRATCH    "
+                  << octopus::local_flux_scratch_pool().peak_leased()
+                  << " [buffers leased at once on locality "
+                  << hpx::get_locality_id() << "]\n"
+                  << "BUFFER POOL     "
+                  << octopus::local_buffer_pool().hits() << " hits, "
+                  << octopus::local_buffer_pool().misses() << " misses, "
+                  << octopus::local_buffer_pool().free_bytes()
+                  << " bytes free [on locality "
+                  << hpx::get_locality_id() << "]\n"; 
+
+        if (octopus::config().asynchronous_output)
+        {
+            // Finish the last output, and throw if any of it failed.
+            octopus::local_io_pipeline().drain();
+
+            std::cout << "OUTPUT QUEUE    ";
+            octopus::local_io_pipeline().report(std::cout);
+            std::cout << " [on locality " << hpx::get_locality_id() << "]\n";
+        }
     }
 
     template <typename Archive>
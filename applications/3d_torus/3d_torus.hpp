@@ -19,10 +19,16 @@
 #include <octopus/engine/ini.hpp>
 #include <octopus/octree/octree_reduce.hpp>
 #include <octopus/octree/octree_apply_leaf.hpp>
+#include <octopus/octree/fused_reduce.hpp>
+#include <octopus/science/cfl_dt_from_flux_sweep.hpp>
 #include <octopus/math.hpp>
+#include <octopus/buffer_pool.hpp>
 #include <octopus/global_variable.hpp>
 #include <octopus/io/multi_writer.hpp>
 #include <octopus/io/fstream.hpp>
+#include <octopus/io/slice.hpp>
+#include <octopus/io/probe.hpp>
+#include <octopus/io/io_pipeline.hpp>
 
 #if defined(OCTOPUS_HAVE_SILO)
     #include <octopus/io/silo.hpp>
@@ -30,6 +36,8 @@
 
 #include <boost/format.hpp>
 #include <boost/atomic.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/optional.hpp>
 #include <boost/math/constants/constants.hpp>
 
 #include <hpx/include/plain_actions.hpp>
@@ -95,6 +103,16 @@ OCTOPUS_GLOBAL_VARIABLE((double), X_in);
 /// Mode of the perturbation.
 OCTOPUS_GLOBAL_VARIABLE((boost::uint64_t), kick_mode);
 
+/// Number of timesteps between diagnostics (see compute_diagnostics). Each
+/// one is an extra reduction over the whole tree, so they are off (0) by
+/// default.
+OCTOPUS_GLOBAL_VARIABLE((boost::uint64_t), diagnostics_interval);
+
+/// Number of points, evenly spaced along the X axis between the inner and
+/// outer radius of the torus, at which the state is recorded after every
+/// timestep (see octopus::probe_series). 0 disables the probes.
+OCTOPUS_GLOBAL_VARIABLE((boost::uint64_t), probe_points);
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Mass density
 double&       rho(octopus::state& u)       { return u[0]; }
@@ -871,9 +889,9 @@ struct cfl_initial_dt : octopus::trivial_serialization
     double operator()(octopus::octree_server& root) const
     {
         return initial_cfl_factor 
-             * root.reduce<double>(cfl_treewise_compute_dt()
-                                 , octopus::minimum_functor()
-                                 , std::numeric_limits<double>::max());
+             * root.reduce_typed<double>(cfl_treewise_compute_dt()
+                                       , octopus::minimum_functor()
+                                       , std::numeric_limits<double>::max());
     }
 };
 
@@ -905,9 +923,10 @@ struct cfl_predict_dt
 
         OCTOPUS_ASSERT(0 == root.get_level());
 
-        double next_dt = root.reduce<double>(cfl_treewise_compute_dt()
-                                           , octopus::minimum_functor()
-                                           , std::numeric_limits<double>::max());
+        double next_dt = root.reduce_typed<double>(
+            cfl_treewise_compute_dt()
+          , octopus::minimum_functor()
+          , std::numeric_limits<double>::max());
 
         return octopus::dt_prediction(next_dt, fudge_factor_ * next_dt); 
     }
@@ -1259,9 +1278,138 @@ struct one_functor : octopus::trivial_serialization
 
 boost::uint64_t count_nodes(octopus::octree_server& U)
 {
-    return U.reduce<boost::uint64_t>(one_functor(), add_functor(), 0);
+    return U.reduce_typed<boost::uint64_t>(one_functor(), add_functor(), 0);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Diagnostics. Zones that are covered by a finer level are skipped, so that
+// each point of the domain is counted once.
+
+struct sum_functor : octopus::trivial_serialization
+{
+    double operator()(double a, double b) const
+    {
+        return a + b;
+    } 
+};
+
+struct sum_state_functor : octopus::trivial_serialization
+{
+    octopus::state operator()(
+        octopus::state const& a
+      , octopus::state const& b
+        ) const
+    {
+        octopus::state r(a);
+        r += b;
+        return r;
+    } 
+};
+
+struct zone_mass : octopus::trivial_serialization
+{
+    double operator()(
+        octopus::octree_server& U
+      , boost::uint64_t i
+      , boost::uint64_t j
+      , boost::uint64_t k
+        ) const
+    {
+        if (U.zone_is_refined(i, j, k))
+            return 0.0;
+
+        double const dx = U.get_dx();
+        return rho(U(i, j, k)) * dx * dx * dx;
+    } 
+};
+
+struct zone_energy : octopus::trivial_serialization
+{
+    double operator()(
+        octopus::octree_server& U
+      , boost::uint64_t i
+      , boost::uint64_t j
+      , boost::uint64_t k
+        ) const
+    {
+        if (U.zone_is_refined(i, j, k))
+            return 0.0;
+
+        double const dx = U.get_dx();
+        return total_energy(U(i, j, k)) * dx * dx * dx;
+    } 
+};
+
+struct zone_density : octopus::trivial_serialization
+{
+    double operator()(
+        octopus::octree_server& U
+      , boost::uint64_t i
+      , boost::uint64_t j
+      , boost::uint64_t k
+        ) const
+    {
+        if (U.zone_is_refined(i, j, k))
+            return 0.0;
+
+        return rho(U(i, j, k));
+    } 
+};
+
+/// Only the root's faces are on the boundary of the problem space.
+struct root_flow_off : octopus::trivial_serialization
+{
+    octopus::state operator()(octopus::octree_server& U) const
+    {
+        if (0 != U.get_level())
+            return octopus::state();
+
+        return U.get_flow_off();
+    } 
+};
+
+struct diagnostics
+{
+    double cfl_dt;
+    double mass;
+    double energy;
+    double max_density;
+    octopus::state flow_off;
+};
+
+/// Computes the CFL timestep of the last flux sweep, the total mass and
+/// energy, the largest density and the flow off with one traversal of the
+/// tree and one sweep over the zones of each node.
+inline diagnostics compute_diagnostics(octopus::octree_server& root)
+{ // {{{
+    OCTOPUS_ASSERT(0 == root.get_level());
+
+    using octopus::make_nodal_reduction;
+    using octopus::make_zonal_reduction;
+
+    std::pair<double, std::pair<double, std::pair<double
+      , std::pair<double, octopus::state> > > > const r =
+        octopus::reduce_fused(root, octopus::fuse(
+            make_nodal_reduction(
+                octopus::node_cfl_dt_from_flux_sweep(cfl_factor)
+              , octopus::minimum_functor()
+              , (std::numeric_limits<double>::max)())
+          , make_zonal_reduction(zone_mass(), sum_functor(), 0.0)
+          , make_zonal_reduction(zone_energy(), sum_functor(), 0.0)
+          , make_zonal_reduction(zone_density()
+                               , octopus::maximum_functor(), 0.0)
+          , make_nodal_reduction(root_flow_off(), sum_state_functor()
+                               , octopus::state())));
+
+    diagnostics d;
+    d.cfl_dt      = r.first;
+    d.mass        = r.second.first;
+    d.energy      = r.second.second.first;
+    d.max_density = r.second.second.second.first;
+    d.flow_off    = r.second.second.second.second;
+    return d;
+} // }}}
+
 struct slice_distribution : octopus::trivial_serialization
 {
     hpx::id_type operator()(
@@ -524,6 +524,7 @@ void octopus_define_problem(
 {
     double max_dt_growth = 0.0; 
     double temporal_prediction_limiter = 0.0; 
+    double cfl_factor = 0.0; 
 
     std::string direction_str = "";
 
@@ -532,6 +533,7 @@ void octopus_define_problem(
     reader
         ("max_dt_growth", max_dt_growth, 1.25)
         ("temporal_prediction_limiter", temporal_prediction_limiter, 0.5)
+        ("cfl_factor", cfl_factor, 0.4)
         ("kappa", KAPPA, 1.0)
         ("wave_direction", direction_str, "plus_x")
     ;
@@ -565,6 +567,8 @@ void octopus_define_problem(
            % max_dt_growth)
         << ( boost::format("temporal_prediction_limiter = %i\n")
            % temporal_prediction_limiter)
+        << ( boost::format("cfl_factor                  = %lf\n")
+           % cfl_factor)
         << ( boost::format("kappa                       = %lf\n")
            % KAPPA)
         << ( boost::format("wave_direction              = %s\n")
@@ -614,24 +618,37 @@ struct stepper : octopus::trivial_serialization
     
         // FIXME: Proper support for adding commandline options.     
         double max_dt_growth = 0.0; 
-        double temporal_prediction_limiter = 0.0; 
+        double cfl_factor = 0.0; 
  
         octopus::config_reader reader("octopus.sod_shock_tube");
     
         reader
             ("max_dt_growth", max_dt_growth, 1.25)
-            ("temporal_prediction_limiter", temporal_prediction_limiter, 0.5)
+            ("cfl_factor", cfl_factor, 0.4)
         ;
    
-        root.post_dt(root.apply_leaf(octopus::science().initial_timestep));
+        // Upper bound on the size of the next timestep. The CFL timestep is
+        // computed by the steps themselves (see octree_server::step_with_cfl),
+        // and its reduction overlaps with the start of the next step.
+        double max_dt = root.apply_leaf(octopus::science().initial_timestep);
         double next_output_time = octopus::config().output_frequency;
     
         while (root.get_time() < octopus::config().temporal_domain)
         {
-            std::cout << ( boost::format("STEP %06u : TIME %.6e += %.6e\n")
-                         % root.get_step() % root.get_time() % root.get_dt());
-    
-            root.step();
+            boost::uint64_t const this_step = root.get_step();
+            double const this_time = root.get_time();
+
+            hpx::future<double> cfl_dt_f
+                = root.step_with_cfl_async(cfl_factor, max_dt);
+
+            double const cfl_dt = cfl_dt_f.move();
+            double const this_dt = root.get_dt();
+
+            OCTOPUS_ASSERT(0.0 < this_dt);
+
+            std::cout << ( boost::format("STEP %06u : TIME %.6e += %.6e "
+                                         "(CFL %.6e)\n")
+                         % this_step % this_time % this_dt % cfl_dt);
     
             if (root.get_time() >= next_output_time)
             {   
@@ -640,14 +657,7 @@ struct stepper : octopus::trivial_serialization
                 next_output_time += octopus::config().output_frequency; 
             }
     
-            // IMPLEMENT: Futurize w/ continutation.
-            octopus::timestep_prediction prediction
-                = root.apply_leaf(octopus::science().predict_timestep);
-    
-            OCTOPUS_ASSERT(0.0 < prediction.next_dt);
-            OCTOPUS_ASSERT(0.0 < prediction.future_dt);
-    
-            root.post_dt(prediction.next_dt);
+            max_dt = this_dt * max_dt_growth;
     
             // Update kappa.
             // FIXME: Distributed.
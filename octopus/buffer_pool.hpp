@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_7AE79A7D_DC93_41DF_AFC9_D0245AF1C4B1)
+#define OCTOPUS_7AE79A7D_DC93_41DF_AFC9_D0245AF1C4B1
+
+#include <hpx/lcos/local/spinlock.hpp>
+
+#include <octopus/config.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <limits>
+#include <new>
+#include <vector>
+
+namespace octopus
+{
+
+/// Size-class pool for the large, short-lived buffers that are allocated
+/// every sub step (ghost zones, child state, child fluxes and the buffers
+/// that incoming parcels are deserialized into). Freed blocks are kept on a
+/// free list per size class and handed out again, so that once the sizes
+/// that a timestep needs have been seen, stepping does not call malloc.
+///
+/// Blocks of at least min_block_size bytes are pooled. Each power of two is
+/// split into four size classes, so at most a fifth of a block is wasted.
+/// Smaller and larger requests go straight to operator new.
+struct OCTOPUS_EXPORT buffer_pool : boost::noncopyable
+{
+    static std::size_t const min_block_size = 4096;
+
+    static std::size_t const octaves = 20;
+
+    static std::size_t const number_of_size_classes = 4 * octaves;
+
+    /// Upper bound on the number of free blocks kept per size class; blocks
+    /// that are freed while the free list is full are released.
+    static std::size_t const max_free_blocks = 256;
+
+  private:
+    typedef hpx::lcos::local::spinlock mutex_type;
+
+    struct size_class
+    {
+        mutex_type mtx;
+        std::vector<void*> free;
+        boost::uint64_t hits;
+        boost::uint64_t misses;
+
+        size_class() : mtx(), free(), hits(0), misses(0) {}
+    };
+
+    size_class classes_[number_of_size_classes];
+
+  public:
+    buffer_pool() {}
+
+    ~buffer_pool()
+    {
+        trim();
+    }
+
+    /// Returns the size class of a block of \a bytes bytes, or
+    /// number_of_size_classes if it is not pooled.
+    static std::size_t size_class_of(std::size_t bytes)
+    { // {{{
+        if (bytes < min_block_size)
+            return number_of_size_classes;
+
+        std::size_t base = min_block_size;
+        std::size_t c = 0;
+
+        while (base < bytes / 2 + (bytes % 2))
+        {
+            base *= 2;
+            c += 4;
+        }
+
+        // Now base < bytes <= 2 * base, except for bytes == min_block_size.
+        std::size_t const quarter = base / 4;
+        c += (bytes - base + quarter - 1) / quarter;
+
+        if (number_of_size_classes <= c)
+            return number_of_size_classes;
+
+        return c;
+    } // }}}
+
+    /// Returns the number of bytes in a block of size class \a c.
+    static std::size_t block_size(std::size_t c)
+    {
+        std::size_t const base = min_block_size << (c / 4);
+        return base + (c % 4) * (base / 4);
+    }
+
+    void* allocate(std::size_t bytes);
+
+    void deallocate(void* p, std::size_t bytes);
+
+    /// Releases every free block.
+    void trim();
+
+    /// Returns the number of bytes held in free blocks.
+    std::size_t free_bytes();
+
+    /// Returns the number of pooled allocations that reused a block.
+    boost::uint64_t hits();
+
+    /// Returns the number of pooled allocations that had to call operator new.
+    boost::uint64_t misses();
+};
+
+/// Returns the buffer pool for this locality. The pool is never destroyed, so
+/// buffers may be freed during static destruction.
+OCTOPUS_EXPORT buffer_pool& local_buffer_pool();
+
+/// Standard allocator which takes its blocks from local_buffer_pool().
+template <typename T>
+struct pooled_allocator
+{
+    typedef T value_type;
+    typedef T* pointer;
+    typedef T const* const_pointer;
+    typedef T& reference;
+    typedef T const& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef pooled_allocator<U> other;
+    };
+
+    pooled_allocator() {}
+
+    template <typename U>
+    pooled_allocator(pooled_allocator<U> const&) {}
+
+    pointer address(reference r) const
+    {
+        return &r;
+    }
+
+    const_pointer address(const_reference r) const
+    {
+        return &r;
+    }
+
+    pointer allocate(size_type n, void const* = 0)
+    {
+        if (max_size() < n)
+            throw std::bad_alloc();
+
+        return static_cast<pointer>
+            (local_buffer_pool().allocate(n * sizeof(T)));
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        local_buffer_pool().deallocate(p, n * sizeof(T));
+    }
+
+    size_type max_size() const
+    {
+        return (std::numeric_limits<size_type>::max)() / sizeof(T);
+    }
+
+    void construct(pointer p, T const& t)
+    {
+        ::new (static_cast<void*>(p)) T(t);
+    }
+
+    void destroy(pointer p)
+    {
+        p->~T();
+    }
+};
+
+template <typename T, typename U>
+inline bool operator==(pooled_allocator<T> const&, pooled_allocator<U> const&)
+{
+    return true;
+}
+
+template <typename T, typename U>
+inline bool operator!=(pooled_allocator<T> const&, pooled_allocator<U> const&)
+{
+    return false;
+}
+
+}
+
+#endif // OCTOPUS_7AE79A7D_DC93_41DF_AFC9_D0245AF1C4B1
@@ -62,33 +62,48 @@ inline std::vector<hpx::id_type> const& localities()
 ///        load-balancer.
 ///
 /// Remote Operations:   Possibly.
-/// Concurrency Control: 1 atomic read and 1 atomic write to \a engine_server's
-///                      round_robin_.
+/// Concurrency Control: None; placement is decided by science().distribute.
 /// Synchrony Gurantee:  Asynchronous.
 inline hpx::future<hpx::id_type> create_octree_async(
     octree_init_data const& init
-  , boost::shared_ptr<vector4d<double> > const& parent_U
+  , boost::shared_ptr<vector4d<double> > const& parent_octant
     )
 {
     OCTOPUS_ASSERT_MSG(engine_ptr != 0, "engine_ptr is NULL");
-    return engine_ptr->create_octree_async(init, parent_U);
+    return engine_ptr->create_octree_async(init, parent_octant);
 }
 
 /// \brief Asynchronously create a new octree node using the distributed
 ///        load-balancer.
 ///
 /// Remote Operations:   Possibly.
-/// Concurrency Control: 1 atomic read and 1 atomic write to \a engine_server's
-///                      round_robin_.
+/// Concurrency Control: None; placement is decided by science().distribute.
 /// Synchrony Gurantee:  Synchronous.
 inline hpx::id_type create_octree(
     octree_init_data const& init
-  , boost::shared_ptr<vector4d<double> > const& parent_U
+  , boost::shared_ptr<vector4d<double> > const& parent_octant
     )
 {
-    return create_octree_async(init, parent_U).get();
+    return create_octree_async(init, parent_octant).get();
 } 
 
+/// \brief Create several new octree nodes using the distributed
+///        load-balancer. The nodes are grouped by the locality that they are
+///        placed on, and each locality receives a single creation request.
+///        Returns the gids in the order of \a inits.
+///
+/// Remote Operations:   Possibly, one per destination locality.
+/// Concurrency Control: None; placement is decided by science().distribute.
+/// Synchrony Gurantee:  Synchronous.
+inline std::vector<hpx::id_type> create_octrees(
+    std::vector<octree_init_data> const& inits
+  , std::vector<boost::shared_ptr<vector4d<double> > > const& parent_octants
+    )
+{
+    OCTOPUS_ASSERT_MSG(engine_ptr != 0, "engine_ptr is NULL");
+    return engine_ptr->create_octrees(inits, parent_octants);
+}
+
 OCTOPUS_EXPORT std::vector<hpx::future<void> > call_everywhere(
     hpx::util::function<void()> const& f
     );
@@ -16,9 +16,8 @@
 #include <octopus/science/science_table.hpp>
 #include <octopus/assert.hpp>
 
-#include <boost/atomic.hpp>
-
 #include <iostream>
+#include <vector>
 
 // TODO: Add I/O abstraction and services.
 
@@ -36,8 +35,6 @@ struct OCTOPUS_EXPORT engine_server
     config_data config_;
     science_table science_;
 
-    // TODO: Replace with modular distribution.
-    boost::atomic<boost::uint64_t> round_robin_;
     std::vector<hpx::id_type> localities_;
 
     std::fstream checkpoint_file_;
@@ -48,7 +45,6 @@ struct OCTOPUS_EXPORT engine_server
     engine_server()
       : config_()
       , science_()
-      , round_robin_(0)
       , localities_()
       , checkpoint_file_()
     {
@@ -83,7 +79,12 @@ struct OCTOPUS_EXPORT engine_server
 
     hpx::future<hpx::id_type> create_octree_async(
         octree_init_data const& init
-      , boost::shared_ptr<vector4d<double> > const& parent_U
+      , boost::shared_ptr<vector4d<double> > const& parent_octant
+        );
+
+    std::vector<hpx::id_type> create_octrees(
+        std::vector<octree_init_data> const& inits
+      , std::vector<boost::shared_ptr<vector4d<double> > > const& parent_octants
         );
 
     std::vector<hpx::future<void> > call_everywhere(
@@ -15,7 +15,7 @@
 
 #include <iostream>
 
-#define OCTOPUS_CONFIG_DATA_VERSION 0x02
+#define OCTOPUS_CONFIG_DATA_VERSION 0x03
 
 // TODO: This is specific to the euler code, make it more general after SC.
 // TODO: Rename.
@@ -34,6 +34,11 @@ struct config_data
     ///< Order of (TVD) Runge Kutta used..
     boost::uint16_t runge_kutta_order;
 
+    ///< If true, use the low-storage (2N-register) SSP Runge Kutta scheme of
+    ///  order runge_kutta_order instead of TVD Runge Kutta. The state at the
+    ///  beginning of each timestep does not have to be kept.
+    bool low_storage_runge_kutta;
+
     ///< Reflection control for the Z-axis. TODO: error handling if no
     ///  reflection function is found.
     bool reflect_on_z;
@@ -61,12 +66,61 @@ struct config_data
     std::string checkpoint_file;
     bool load_checkpoint;
 
+    ///< Number of timesteps that per-node phase timings are averaged over.
+    boost::uint64_t cost_window;
+
+    ///< If true, octree_server::refine re-partitions the space-filling curve
+    ///  with the measured node costs (see rebalance in load_balance.hpp)
+    ///  before each level of new children is created, and installs it as
+    ///  science().distribute.
+    bool rebalance_on_refine;
+
+    ///< If true, octree_server::step runs the stages of each timestep as a
+    ///  per-node dataflow graph on each locality (see batched_step.hpp)
+    ///  instead of recursing through the tree.
+    bool batched_stepping;
+
+    ///< If false, timesteps do not exchange ghost zones after their last sub
+    ///  step. The exchange before the first sub step of the next timestep
+    ///  makes the ghost zones current again; octree_server::refine exchanges
+    ///  them itself before it interpolates new children. Applications that
+    ///  read ghost zones between timesteps must leave this on.
+    bool final_ghost_zone_exchange;
+
+    ///< If true, the ghost zones are runge_kutta_order times as wide as the
+    ///  reconstruction needs, and grid_node_length grows by the same amount
+    ///  so that the interior keeps its size (see src/driver.cpp). They are
+    ///  only exchanged before the first sub step of each timestep (and after
+    ///  the last one, with final_ghost_zone_exchange), and each sub step
+    ///  updates the part of them that is still valid. Saves communication at
+    ///  the cost of memory and of computing the halos; best with a large
+    ///  grid_node_length.
+    bool wide_halos;
+
+    ///< If true, octree_server::populate creates the new children of all the
+    ///  nodes on each locality together, with one creation request per
+    ///  destination locality, instead of recursing through the tree and
+    ///  creating one child at a time. octree_server::link then rebuilds the
+    ///  sibling links of each node from the topology index instead of tying
+    ///  them with actions between the nodes.
+    bool bulk_child_creation;
+
+    ///< If true, writers that support it copy the nodes and write them on a
+    ///  dedicated I/O thread (see io_pipeline.hpp), and output returns as
+    ///  soon as the copies have been queued.
+    bool asynchronous_output;
+
+    ///< Number of jobs that the I/O thread of each locality queues before
+    ///  output has to wait for it.
+    boost::uint64_t output_queue_length;
+
     template <typename Archive>
     void serialize(Archive& ar, const unsigned int version)
     {
         ar & levels_of_refinement;
 
         ar & runge_kutta_order;
+        ar & low_storage_runge_kutta;
         ar & reflect_on_z;
 
         ar & spatial_domain;
@@ -79,6 +133,16 @@ struct config_data
 
         ar & checkpoint_file;
         ar & load_checkpoint;
+
+        ar & cost_window;
+        ar & rebalance_on_refine;
+        ar & batched_stepping;
+        ar & final_ghost_zone_exchange;
+        ar & wide_halos;
+        ar & bulk_child_creation;
+
+        ar & asynchronous_output;
+        ar & output_queue_length;
     }
 };
 
@@ -82,10 +82,6 @@ struct OCTOPUS_EXPORT fstream_writer : writer_base
 
     void stop_write();
 
-    void begin_epoch(octree_server& e, double time);
-
-    void end_epoch(octree_server& e);
-
     // IMPLEMENT: Do actual I/O in a separate OS-thread.
     void operator()(octree_server& e);
 
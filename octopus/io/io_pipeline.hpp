@@ -0,0 +1,180 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_7265981A_CF0B_420A_8070_96DBCC690C93)
+#define OCTOPUS_7265981A_CF0B_420A_8070_96DBCC690C93
+
+#include <octopus/config.hpp>
+#include <octopus/array.hpp>
+#include <octopus/vector4d.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <deque>
+#include <iosfwd>
+#include <vector>
+
+namespace octopus
+{
+
+struct OCTOPUS_EXPORT octree_server;
+
+/// A copy of everything that the writers need from a node, so that the node
+/// can keep stepping while the copy is written.
+struct node_snapshot
+{
+    boost::uint64_t level;
+    array<boost::uint64_t, 3> location;
+    boost::uint64_t step;
+    double time;
+    double dx;
+
+    ///< The face coordinates of the interior on each axis; there is one more
+    ///  face than there are cells.
+    std::vector<double> x_faces;
+    std::vector<double> y_faces;
+    std::vector<double> z_faces;
+
+    ///< The interior of U_, without ghost zones.
+    boost::shared_ptr<vector4d<double> > U;
+
+    node_snapshot()
+      : level(0)
+      , location()
+      , step(0)
+      , time(0.0)
+      , dx(0.0)
+      , x_faces()
+      , y_faces()
+      , z_faces()
+      , U()
+    {}
+};
+
+/// Copies the interior of \a e.
+OCTOPUS_EXPORT node_snapshot take_node_snapshot(octree_server& e);
+
+/// A dedicated OS-thread which runs I/O jobs in FIFO order, so that writers
+/// do not block the HPX worker threads.
+///
+/// The queue is bounded. When it is full, submit suspends the calling HPX
+/// thread until the I/O thread catches up (backpressure); the number of times
+/// that happened is counted. There is one I/O thread per locality because
+/// the jobs of a writer have to run in order (e.g. a file must be opened
+/// before it is written to) and Silo is not thread-safe.
+///
+/// If a job throws, the I/O thread keeps going, and the exception is thrown
+/// to whoever calls submit or drain next.
+struct OCTOPUS_EXPORT io_pipeline : boost::noncopyable
+{
+    typedef boost::function<void()> job;
+
+  private:
+    mutable boost::mutex mtx_;
+    boost::condition_variable not_empty_;
+    boost::condition_variable not_full_;
+    boost::condition_variable idle_;
+
+    std::deque<job> queue_;
+    std::size_t capacity_;
+    bool busy_;
+    bool stopping_;
+
+    boost::scoped_ptr<boost::thread> thread_;
+
+    boost::uint64_t submitted_;
+    boost::uint64_t completed_;
+    boost::uint64_t backpressure_stalls_;
+    std::size_t max_queue_depth_;
+
+    ///< The first exception thrown by a job that has not been rethrown yet.
+    boost::exception_ptr error_;
+
+    void run();
+
+    /// Rethrows error_, if it is set, and clears it. mtx_ must be locked.
+    void rethrow_locked(boost::mutex::scoped_lock& l);
+
+  public:
+    io_pipeline(std::size_t capacity);
+
+    /// Finishes the queued jobs and joins the I/O thread.
+    ~io_pipeline();
+
+    /// Queues \a j, starting the I/O thread if necessary. Blocks while the
+    /// queue is full. Throws the exception of a job that failed since the
+    /// last submit or drain, if any, instead of queueing \a j.
+    void submit(job const& j);
+
+    /// Blocks until every job that has been submitted has finished, then
+    /// throws the exception of a job that failed, if any.
+    void drain();
+
+    /// Like drain, but writes the exception of a failed job to std::cerr
+    /// instead of throwing it, for use in destructors.
+    void drain_and_report();
+
+    /// Writes the queue statistics (capacity, maximum depth, backpressure
+    /// stalls and jobs completed) to \a os on one line.
+    void report(std::ostream& os) const;
+
+    std::size_t capacity() const
+    {
+        boost::mutex::scoped_lock l(mtx_);
+        return capacity_;
+    }
+
+    /// Number of jobs that are queued (not counting a running job).
+    std::size_t queue_depth() const
+    {
+        boost::mutex::scoped_lock l(mtx_);
+        return queue_.size();
+    }
+
+    /// The largest queue depth seen so far.
+    std::size_t max_queue_depth() const
+    {
+        boost::mutex::scoped_lock l(mtx_);
+        return max_queue_depth_;
+    }
+
+    /// Number of submits that had to wait for space in the queue.
+    boost::uint64_t backpressure_stalls() const
+    {
+        boost::mutex::scoped_lock l(mtx_);
+        return backpressure_stalls_;
+    }
+
+    boost::uint64_t submitted() const
+    {
+        boost::mutex::scoped_lock l(mtx_);
+        return submitted_;
+    }
+
+    boost::uint64_t completed() const
+    {
+        boost::mutex::scoped_lock l(mtx_);
+        return completed_;
+    }
+};
+
+/// Returns the I/O pipeline of this locality. Its capacity is set from
+/// config().output_queue_length when it is first used.
+OCTOPUS_EXPORT io_pipeline& local_io_pipeline();
+
+}
+
+#endif // OCTOPUS_7265981A_CF0B_420A_8070_96DBCC690C93
+
@@ -49,19 +49,22 @@ struct multi_writer : writer_base
         writers_.push_back(w);  
     }
 
-    void begin_epoch(octree_server& e, double time)
+    // The epoch is started on every locality once (see
+    // writer_base::begin_epoch), and each locality starts all of our writers.
+    void start_write(boost::uint64_t step, double time)
     {
         for (boost::uint64_t i = 0; i < writers_.size(); ++i)
-            writers_[i].begin_epoch(e, time);
+            writers_[i].start_write(step, time);
     }
 
-    void end_epoch(octree_server& e)
+    void stop_write()
     {
         for (boost::uint64_t i = 0; i < writers_.size(); ++i)
-            writers_[i].end_epoch(e);
+            writers_[i].stop_write();
     }
 
-    // IMPLEMENT: Do actual I/O in a separate OS-thread.
+    // Writers that support asynchronous_output copy the node and queue the
+    // actual I/O on the io_pipeline of this locality themselves.
     void operator()(octree_server& e)
     {
         for (boost::uint64_t i = 0; i < writers_.size(); ++i)
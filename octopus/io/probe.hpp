@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_6BA80E75_BD71_441F_BDE5_BCCEC2FB5D49)
+#define OCTOPUS_6BA80E75_BD71_441F_BDE5_BCCEC2FB5D49
+
+#include <octopus/octree/octree_server.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace octopus
+{
+
+/// Records the state at a fixed set of points as a time series. Each call
+/// appends one line to a text file:
+///
+///     step time p0.f0 p0.f1 ... p1.f0 p1.f1 ...
+///
+/// The points are sampled with octree_server::probe, which only visits the
+/// nodes on the paths from the root to the points, so this is cheap enough
+/// to call after every timestep. It is meant to be called by the stepper
+/// functor that the application runs on the root (see apply_leaf); it is not
+/// a writer_base and is not serializable.
+struct OCTOPUS_EXPORT probe_series : boost::noncopyable
+{
+  private:
+    std::vector<array<double, 3> > points_;
+    std::ofstream file_;
+
+    void write(
+        boost::uint64_t step
+      , double time
+      , std::vector<state> const& samples
+        );
+
+  public:
+    probe_series(
+        std::vector<array<double, 3> > const& points
+      , std::string const& file_name
+        );
+
+    std::vector<array<double, 3> > const& points() const
+    {
+        return points_;
+    }
+
+    /// Samples the tree rooted at \a root and appends a line to the file.
+    void operator()(octree_server& root);
+};
+
+}
+
+#endif // OCTOPUS_6BA80E75_BD71_441F_BDE5_BCCEC2FB5D49
+
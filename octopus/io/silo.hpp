@@ -9,7 +9,9 @@
 #if !defined(OCTOPUS_3BF02C42_6BDB_4469_B6D1_8B8F393C63A5)
 #define OCTOPUS_3BF02C42_6BDB_4469_B6D1_8B8F393C63A5
 
+#include <octopus/assert.hpp>
 #include <octopus/io/writer.hpp>
+#include <octopus/io/io_pipeline.hpp>
 
 #include <hpx/util/base_object.hpp>
 
@@ -18,6 +20,7 @@
 #include <boost/serialization/version.hpp>
 
 #include <string>
+#include <vector>
 
 #include <silo.h>
 
@@ -29,7 +32,11 @@
 namespace octopus
 { 
 
-struct OCTOPUS_EXPORT single_variable_silo_writer : writer_base
+/// Writes one or more components of the state to Silo files, one file per
+/// locality per epoch. Each node's mesh is written once, with one quadvar per
+/// component on it, and each level gets one multimesh plus one multivar per
+/// component when the file is merged.
+struct OCTOPUS_EXPORT silo_writer : writer_base
 {
   private:
     typedef hpx::lcos::local::mutex mutex_type;
@@ -40,8 +47,8 @@ struct OCTOPUS_EXPORT single_variable_silo_writer : writer_base
     std::vector<std::string> directory_names_;
     boost::uint64_t step_;
     double time_;
-    boost::uint64_t variable_index_;
-    std::string variable_name_;
+    std::vector<boost::uint64_t> variable_indices_;
+    std::vector<std::string> variable_names_;
     std::string file_name_;
     bool merged_;
 
@@ -55,34 +62,53 @@ struct OCTOPUS_EXPORT single_variable_silo_writer : writer_base
 
     void merge_locked(mutex_type::scoped_lock& l);
 
+    // The *_unlocked functions do the actual work. They are either called
+    // with mtx_ held, or on the I/O thread (see io_pipeline.hpp) if output is
+    // asynchronous, which is the only thread that touches the file then.
+    // When io_thread is false, Silo calls are made on an HPX thread with a
+    // medium stack.
+    void start_write_unlocked(
+        boost::uint64_t step
+      , double time
+      , boost::uint32_t locality_id
+      , bool io_thread
+        );
+
+    void stop_write_unlocked(bool io_thread);
+
+    void merge_unlocked(bool io_thread);
+
+    void write_unlocked(node_snapshot const& s);
+
   public:
-    single_variable_silo_writer()
+    silo_writer()
       : mtx_()
       , file_()
       , directory_names_()
       , step_(0)
       , time_(0.0)
-      , variable_index_()
-      , variable_name_()
+      , variable_indices_()
+      , variable_names_()
       , file_name_()
       , merged_(false)
     {}
 
-    single_variable_silo_writer(
-        single_variable_silo_writer const& other
+    silo_writer(
+        silo_writer const& other
         )
       : mtx_()
       , file_()
       , directory_names_(other.directory_names_)
       , step_(other.step_)
       , time_(other.time_)
-      , variable_index_(other.variable_index_)
-      , variable_name_(other.variable_name_)
+      , variable_indices_(other.variable_indices_)
+      , variable_names_(other.variable_names_)
       , file_name_(other.file_name_)
       , merged_(false)
     {}
  
-    single_variable_silo_writer(
+    /// Writes the single component \a variable_index as \a variable_name.
+    silo_writer(
         boost::uint64_t variable_index
       , std::string const& variable_name 
                                      // These should be sufficient default
@@ -94,49 +120,50 @@ struct OCTOPUS_EXPORT single_variable_silo_writer : writer_base
       , directory_names_()
       , step_(0)
       , time_(0.0)
-      , variable_index_(variable_index)
-      , variable_name_(variable_name)
+      , variable_indices_(1, variable_index)
+      , variable_names_(1, variable_name)
       , file_name_(file_name)
       , merged_(false)
     {}
 
-    ~single_variable_silo_writer()
-    {
-        mutex_type::scoped_lock l(mtx_);
-        merge_locked(l);
-        stop_write_locked(l);
-    }
-
-    void start_write(boost::uint64_t step, double time)
+    /// Writes the components \a variable_indices, naming them
+    /// \a variable_names (which must be the same length).
+    silo_writer(
+        std::vector<boost::uint64_t> const& variable_indices
+      , std::vector<std::string> const& variable_names
+      , std::string const& file_name = "U_L%06u_S%06u.silo"
+        )
+      : mtx_()
+      , file_(0)
+      , directory_names_()
+      , step_(0)
+      , time_(0.0)
+      , variable_indices_(variable_indices)
+      , variable_names_(variable_names)
+      , file_name_(file_name)
+      , merged_(false)
     {
-        mutex_type::scoped_lock l(mtx_);
-        start_write_locked(step, time, l);
+        OCTOPUS_ASSERT(variable_indices_.size() == variable_names_.size());
     }
 
-    void stop_write()
-    {
-        mutex_type::scoped_lock l(mtx_);
-        stop_write_locked(l);
-    }
+    ~silo_writer();
 
-    void begin_epoch(octree_server& e, double time);
+    void start_write(boost::uint64_t step, double time);
 
-    void end_epoch(octree_server& e);
+    void stop_write();
 
-    void merge()
-    {
-        mutex_type::scoped_lock l(mtx_);
-        merge_locked(l);
-    }
+    void merge();
 
-    // IMPLEMENT: Do actual I/O in a separate OS-thread.
+    /// Copies the interior of \a e and writes it. If asynchronous_output is
+    /// on, the write is queued on the I/O thread and this returns as soon as
+    /// the copy has been made.
     void operator()(octree_server& e);
 
     writer_base* clone() const
     {
-        return new single_variable_silo_writer(variable_index_
-                                             , variable_name_
-                                             , file_name_);
+        return new silo_writer(variable_indices_
+                             , variable_names_
+                             , file_name_);
     } 
 
     template <typename Archive>
@@ -145,18 +172,20 @@ struct OCTOPUS_EXPORT single_variable_silo_writer : writer_base
         ar & hpx::util::base_object_nonvirt<writer_base>(*this);
         ar & step_;
         ar & time_;
-        ar & variable_index_;
-        ar & variable_name_;
+        ar & variable_indices_;
+        ar & variable_names_;
         ar & file_name_;
     }
 };
 
+// The single variable writer is the special case of silo_writer with one
+// component; the name is kept for existing code.
+typedef silo_writer single_variable_silo_writer;
+
 }
 
-BOOST_CLASS_EXPORT_GUID(octopus::single_variable_silo_writer
-                      , "single_variable_silo_writer")
-BOOST_CLASS_TRACKING(octopus::single_variable_silo_writer
-                   , boost::serialization::track_never)
+BOOST_CLASS_EXPORT_GUID(octopus::silo_writer, "silo_writer")
+BOOST_CLASS_TRACKING(octopus::silo_writer, boost::serialization::track_never)
 
 #endif // OCTOPUS_3BF02C42_6BDB_4469_B6D1_8B8F393C63A5
 
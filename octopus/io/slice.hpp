@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_5EC605A5_DBF9_4621_A1F4_4EF7309BCBD2)
+#define OCTOPUS_5EC605A5_DBF9_4621_A1F4_4EF7309BCBD2
+
+#include <octopus/axis.hpp>
+#include <octopus/io/writer.hpp>
+#include <octopus/io/io_pipeline.hpp>
+#include <octopus/io/slice_format.hpp>
+
+#include <hpx/util/base_object.hpp>
+
+#include <boost/serialization/export.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace octopus
+{
+
+/// Writes the cells of each node that are on a plane perpendicular to an
+/// axis in the binary slice format (see slice_format.hpp), one file per
+/// locality per epoch. The octopus_slice_to_text tool converts the files to
+/// the text format of the 3d_torus equatorial plane output.
+///
+/// Each node packs its records into a buffer of its own, without locking.
+/// The buffers are collected and written to the file in blocks of
+/// block_size bytes; if asynchronous_output is on, that is done by the I/O
+/// thread of the locality.
+struct OCTOPUS_EXPORT slice_writer : writer_base
+{
+    enum { block_size = 1 << 20 };
+
+  private:
+    typedef hpx::lcos::local::mutex mutex_type;
+
+    mutex_type mtx_;
+    std::ofstream file_;
+    std::vector<char> block_;
+    axis axis_;
+    double eps_;
+    std::string file_name_;
+
+    // Called with mtx_ held, or on the I/O thread if output is asynchronous.
+    void start_write_unlocked(
+        boost::uint64_t step
+      , double time
+      , boost::uint32_t locality_id
+        );
+
+    void stop_write_unlocked();
+
+    void flush_unlocked();
+
+    void write_unlocked(boost::shared_ptr<std::vector<char> > const& records);
+
+  public:
+    slice_writer()
+      : mtx_()
+      , file_()
+      , block_()
+      , axis_(z_axis)
+      , eps_(0.0)
+      , file_name_()
+    {}
+
+    slice_writer(
+        slice_writer const& other
+        )
+      : mtx_()
+      , file_()
+      , block_()
+      , axis_(other.axis_)
+      , eps_(other.eps_)
+      , file_name_(other.file_name_)
+    {}
+
+    slice_writer(
+        axis a
+      , double eps
+      , std::string const& file_name = "slice_L%06u_S%06u.bin"
+        )
+      : mtx_()
+      , file_()
+      , block_()
+      , axis_(a)
+      , eps_(eps)
+      , file_name_(file_name)
+    {}
+
+    ~slice_writer();
+
+    void start_write(boost::uint64_t step, double time);
+
+    void stop_write();
+
+    void operator()(octree_server& e);
+
+    writer_base* clone() const
+    {
+        return new slice_writer(axis_, eps_, file_name_);
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int)
+    {
+        ar & hpx::util::base_object_nonvirt<writer_base>(*this);
+        ar & axis_;
+        ar & eps_;
+        ar & file_name_;
+    }
+};
+
+}
+
+BOOST_CLASS_EXPORT_GUID(octopus::slice_writer, "slice_writer")
+BOOST_CLASS_TRACKING(octopus::slice_writer, boost::serialization::track_never)
+
+#endif // OCTOPUS_5EC605A5_DBF9_4621_A1F4_4EF7309BCBD2
+
@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_5867AE0E_6C30_477A_8FD4_E97A11FAA30D)
+#define OCTOPUS_5867AE0E_6C30_477A_8FD4_E97A11FAA30D
+
+// The binary slice format written by slice_writer. Like snapshot_format.hpp,
+// this only depends on Boost and the standard library.
+//
+// A slice file is a file_header followed by records, in no particular order,
+// until the end of the file. Each record is record_size(state_size) bytes:
+//
+//     double x, y, z        the cell center
+//     uint64 level          the level of the node the cell is in
+//     double U[state_size]
+//
+// All values are in the byte order of the writer, which is recorded in the
+// header.
+
+#include <boost/cstdint.hpp>
+
+namespace octopus { namespace slice
+{
+
+char const magic[8] = { 'O', 'C', 'T', 'O', 'S', 'L', 'C', 'E' };
+
+boost::uint64_t const format_version = 1;
+
+/// Written as a native integer; a reader on a machine with a different byte
+/// order sees it reversed.
+boost::uint64_t const byte_order_mark = 0x0102030405060708ULL;
+
+struct file_header
+{
+    char magic[8];
+    boost::uint64_t version;
+    boost::uint64_t byte_order;
+
+    boost::uint64_t locality_id;
+    boost::uint64_t step;
+    double time;
+
+    ///< The slice is the plane perpendicular to axis through eps.
+    boost::uint64_t axis;
+    double eps;
+
+    boost::uint64_t state_size;
+};
+
+inline boost::uint64_t record_size(boost::uint64_t state_size)
+{
+    return (4 + state_size) * 8;
+}
+
+}}
+
+#endif // OCTOPUS_5867AE0E_6C30_477A_8FD4_E97A11FAA30D
+
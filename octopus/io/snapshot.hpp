@@ -0,0 +1,107 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_096B304A_7D69_4169_B905_D60F80BC2373)
+#define OCTOPUS_096B304A_7D69_4169_B905_D60F80BC2373
+
+#include <octopus/io/writer.hpp>
+#include <octopus/io/io_pipeline.hpp>
+#include <octopus/io/snapshot_format.hpp>
+
+#include <hpx/util/base_object.hpp>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/serialization/export.hpp>
+
+#include <string>
+
+namespace octopus
+{
+
+/// Writes the native binary snapshot format (see snapshot_format.hpp), one
+/// file per locality per epoch. The files can be read with
+/// snapshot::reader or the octopus_snapshot tool, and do not need Silo.
+struct OCTOPUS_EXPORT snapshot_writer : writer_base
+{
+  private:
+    typedef hpx::lcos::local::mutex mutex_type;
+
+    mutex_type mtx_;
+    boost::scoped_ptr<snapshot::file_writer> file_;
+    std::string file_name_;
+    std::string science_name_;
+
+    // Called with mtx_ held, or on the I/O thread if output is asynchronous.
+    void start_write_unlocked(
+        boost::uint64_t step
+      , double time
+      , boost::uint32_t locality_id
+        );
+
+    void stop_write_unlocked();
+
+    void write_unlocked(node_snapshot const& s);
+
+  public:
+    snapshot_writer()
+      : mtx_()
+      , file_()
+      , file_name_()
+      , science_name_()
+    {}
+
+    snapshot_writer(
+        snapshot_writer const& other
+        )
+      : mtx_()
+      , file_()
+      , file_name_(other.file_name_)
+      , science_name_(other.science_name_)
+    {}
+
+    /// \a science_name is recorded in the header of each file, to tell
+    /// snapshots of different problems apart.
+    snapshot_writer(
+        std::string const& science_name
+      , std::string const& file_name = "U_L%06u_S%06u.snap"
+        )
+      : mtx_()
+      , file_()
+      , file_name_(file_name)
+      , science_name_(science_name)
+    {}
+
+    ~snapshot_writer();
+
+    void start_write(boost::uint64_t step, double time);
+
+    void stop_write();
+
+    void operator()(octree_server& e);
+
+    writer_base* clone() const
+    {
+        return new snapshot_writer(science_name_, file_name_);
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int)
+    {
+        ar & hpx::util::base_object_nonvirt<writer_base>(*this);
+        ar & file_name_;
+        ar & science_name_;
+    }
+};
+
+}
+
+BOOST_CLASS_EXPORT_GUID(octopus::snapshot_writer, "snapshot_writer")
+BOOST_CLASS_TRACKING(octopus::snapshot_writer
+                   , boost::serialization::track_never)
+
+#endif // OCTOPUS_096B304A_7D69_4169_B905_D60F80BC2373
+
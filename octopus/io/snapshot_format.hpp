@@ -0,0 +1,232 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_C472B850_03AF_4547_ABB9_C814341D97BF)
+#define OCTOPUS_C472B850_03AF_4547_ABB9_C814341D97BF
+
+// The native snapshot format. This header (and snapshot_reader.hpp) only
+// depends on Boost and the standard library, so that tools can read snapshots
+// without HPX.
+//
+// A snapshot file holds the nodes of one locality for one epoch:
+//
+//     file_header
+//     node blocks, each starting on a block_alignment boundary
+//     index_entry[node_count], sorted by (level, location)
+//     file_footer
+//
+// A node block with interior edge length n (grid_node_length minus the ghost
+// zones) is:
+//
+//     double x_faces[face_stride(n)]
+//     double y_faces[face_stride(n)]
+//     double z_faces[face_stride(n)]
+//     double U[n * n * n * state_size]
+//
+// Only the first n + 1 faces of each axis are used; the padding keeps U
+// aligned to 64 bytes. Component v of the cell (i, j, k) is
+// U[((k * n + j) * n + i) * state_size + v], which is the layout of
+// vector4d. All values are in the byte order of the writer, which is recorded
+// in the header.
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace octopus { namespace snapshot
+{
+
+char const magic[8] = { 'O', 'C', 'T', 'O', 'S', 'N', 'A', 'P' };
+
+boost::uint64_t const format_version = 1;
+
+/// Written as a native integer; a reader on a machine with a different byte
+/// order sees it reversed.
+boost::uint64_t const byte_order_mark = 0x0102030405060708ULL;
+
+/// Node blocks start on page boundaries, so that a block can be mapped on
+/// its own.
+boost::uint64_t const block_alignment = 4096;
+
+inline boost::uint64_t align(boost::uint64_t offset, boost::uint64_t to)
+{
+    return (offset + to - 1) / to * to;
+}
+
+/// Number of doubles stored for the faces of one axis.
+inline boost::uint64_t face_stride(boost::uint64_t n)
+{
+    return align(n + 1, 8);
+}
+
+/// Size of a node block in bytes.
+inline boost::uint64_t block_size(
+    boost::uint64_t n
+  , boost::uint64_t state_size
+    )
+{
+    return (3 * face_stride(n) + n * n * n * state_size) * sizeof(double);
+}
+
+struct file_header
+{
+    char magic[8];
+    boost::uint64_t version;
+    boost::uint64_t byte_order;
+
+    boost::uint64_t locality_id;
+    boost::uint64_t step;
+    double time;
+
+    ///< Configuration the snapshot was written with.
+    boost::uint64_t grid_node_length;
+    boost::uint64_t ghost_zone_length;
+    boost::uint64_t interior_length;
+    boost::uint64_t state_size;
+    boost::uint64_t levels_of_refinement;
+    double spatial_domain;
+
+    ///< Identifies the science (problem) that wrote the snapshot; NUL padded.
+    char science[64];
+};
+
+/// Where a node's block is in the file.
+struct index_entry
+{
+    boost::uint64_t level;
+    boost::uint64_t location[3];
+    boost::uint64_t offset;
+    boost::uint64_t step;
+    double time;
+    double dx;
+
+    friend bool operator<(index_entry const& a, index_entry const& b)
+    {
+        if (a.level != b.level)
+            return a.level < b.level;
+        return std::lexicographical_compare(a.location, a.location + 3
+                                          , b.location, b.location + 3);
+    }
+};
+
+struct file_footer
+{
+    boost::uint64_t index_offset;
+    boost::uint64_t node_count;
+    char magic[8];
+};
+
+/// Writes one snapshot file. Not thread-safe.
+struct file_writer : boost::noncopyable
+{
+  private:
+    std::ofstream file_;
+    file_header header_;
+    std::vector<index_entry> index_;
+    boost::uint64_t end_;
+
+    void write_at(boost::uint64_t offset, void const* p, boost::uint64_t size)
+    {
+        file_.seekp(offset);
+        file_.write(static_cast<char const*>(p), size);
+
+        if (!file_)
+            throw std::runtime_error("snapshot: write failed");
+    }
+
+  public:
+    /// Creates \a file_name. The magic, version and byte order fields of
+    /// \a header are filled in.
+    file_writer(std::string const& file_name, file_header const& header)
+      : file_(file_name.c_str(), std::ios::binary | std::ios::trunc)
+      , header_(header)
+      , index_()
+      , end_(0)
+    {
+        if (!file_)
+            throw std::runtime_error("snapshot: cannot create " + file_name);
+
+        std::memcpy(header_.magic, magic, sizeof(magic));
+        header_.version = format_version;
+        header_.byte_order = byte_order_mark;
+
+        write_at(0, &header_, sizeof(header_));
+        end_ = sizeof(header_);
+    }
+
+    ~file_writer()
+    {
+        if (file_.is_open())
+        {
+            try { close(); } catch (...) {}
+        }
+    }
+
+    file_header const& header() const
+    {
+        return header_;
+    }
+
+    /// Appends a node block. Each face array has interior_length + 1 values,
+    /// and \a U has the layout described at the top of this file. The offset
+    /// field of \a e is set here.
+    void write_node(
+        index_entry e
+      , double const* x_faces
+      , double const* y_faces
+      , double const* z_faces
+      , double const* U
+        )
+    { // {{{
+        boost::uint64_t const n = header_.interior_length;
+        boost::uint64_t const stride = face_stride(n) * sizeof(double);
+
+        e.offset = align(end_, block_alignment);
+
+        write_at(e.offset, x_faces, (n + 1) * sizeof(double));
+        write_at(e.offset + stride, y_faces, (n + 1) * sizeof(double));
+        write_at(e.offset + 2 * stride, z_faces, (n + 1) * sizeof(double));
+        write_at(e.offset + 3 * stride, U
+               , n * n * n * header_.state_size * sizeof(double));
+
+        end_ = e.offset + block_size(n, header_.state_size);
+
+        index_.push_back(e);
+    } // }}}
+
+    /// Writes the index and the footer, and closes the file.
+    void close()
+    { // {{{
+        std::sort(index_.begin(), index_.end());
+
+        file_footer f;
+        f.index_offset = align(end_, sizeof(double));
+        f.node_count = index_.size();
+        std::memcpy(f.magic, magic, sizeof(magic));
+
+        if (!index_.empty())
+            write_at(f.index_offset, &index_[0]
+                   , index_.size() * sizeof(index_entry));
+
+        write_at(f.index_offset + index_.size() * sizeof(index_entry)
+               , &f, sizeof(f));
+
+        file_.close();
+        index_.clear();
+    } // }}}
+};
+
+}}
+
+#endif // OCTOPUS_C472B850_03AF_4547_ABB9_C814341D97BF
+
@@ -0,0 +1,247 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_96307D8B_3F88_4732_B0BC_F5B19BE7A617)
+#define OCTOPUS_96307D8B_3F88_4732_B0BC_F5B19BE7A617
+
+// Reads the snapshots written by snapshot_writer (see snapshot_format.hpp for
+// the layout). The file is mapped into memory, so opening a snapshot only
+// touches the header, the footer and the index; the data of a node is read
+// from disk when it is first accessed.
+
+#include <octopus/io/snapshot_format.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace octopus { namespace snapshot
+{
+
+/// The data of one node, pointing into the mapped file.
+struct node_view
+{
+  private:
+    index_entry const* entry_;
+    double const* faces_;
+    double const* U_;
+    boost::uint64_t n_;
+    boost::uint64_t state_size_;
+
+  public:
+    node_view(
+        index_entry const& entry
+      , char const* base
+      , file_header const& header
+        )
+      : entry_(&entry)
+      , faces_(reinterpret_cast<double const*>(base + entry.offset))
+      , U_(faces_ + 3 * face_stride(header.interior_length))
+      , n_(header.interior_length)
+      , state_size_(header.state_size)
+    {}
+
+    index_entry const& entry() const
+    {
+        return *entry_;
+    }
+
+    /// Edge length of the interior, in cells.
+    boost::uint64_t length() const
+    {
+        return n_;
+    }
+
+    /// n + 1 face coordinates on \a axis (0, 1 or 2).
+    double const* faces(boost::uint64_t axis) const
+    {
+        return faces_ + axis * face_stride(n_);
+    }
+
+    /// Component \a v of the interior cell (i, j, k).
+    double operator()(
+        boost::uint64_t i
+      , boost::uint64_t j
+      , boost::uint64_t k
+      , boost::uint64_t v
+        ) const
+    {
+        return U_[((k * n_ + j) * n_ + i) * state_size_ + v];
+    }
+
+    /// The state of the interior, laid out as described in
+    /// snapshot_format.hpp.
+    double const* data() const
+    {
+        return U_;
+    }
+};
+
+struct reader : boost::noncopyable
+{
+  private:
+    int fd_;
+    char const* base_;
+    boost::uint64_t size_;
+    file_header const* header_;
+    index_entry const* index_;
+    boost::uint64_t node_count_;
+
+    void fail(std::string const& file_name, std::string const& what)
+    {
+        close();
+        throw std::runtime_error("snapshot: " + file_name + ": " + what);
+    }
+
+    void close()
+    {
+        if (base_)
+            ::munmap(const_cast<char*>(base_), size_);
+        if (fd_ >= 0)
+            ::close(fd_);
+
+        fd_ = -1;
+        base_ = 0;
+        size_ = 0;
+    }
+
+  public:
+    /// Maps \a file_name and checks its header and footer. Throws
+    /// std::runtime_error if the file is not a snapshot that this reader
+    /// understands.
+    reader(std::string const& file_name)
+      : fd_(-1)
+      , base_(0)
+      , size_(0)
+      , header_(0)
+      , index_(0)
+      , node_count_(0)
+    { // {{{
+        fd_ = ::open(file_name.c_str(), O_RDONLY);
+
+        if (fd_ < 0)
+            fail(file_name, "cannot open");
+
+        struct stat st;
+
+        if (::fstat(fd_, &st) != 0)
+            fail(file_name, "cannot stat");
+
+        size_ = st.st_size;
+
+        if (size_ < sizeof(file_header) + sizeof(file_footer))
+            fail(file_name, "too short");
+
+        void* p = ::mmap(0, size_, PROT_READ, MAP_SHARED, fd_, 0);
+
+        if (p == MAP_FAILED)
+            fail(file_name, "cannot map");
+
+        base_ = static_cast<char const*>(p);
+        header_ = reinterpret_cast<file_header const*>(base_);
+
+        if (std::memcmp(header_->magic, magic, sizeof(magic)) != 0)
+            fail(file_name, "not a snapshot");
+
+        if (header_->byte_order != byte_order_mark)
+            fail(file_name, "written with a different byte order");
+
+        if (header_->version != format_version)
+            fail(file_name, "unsupported format version");
+
+        file_footer const* f = reinterpret_cast<file_footer const*>
+            (base_ + size_ - sizeof(file_footer));
+
+        // A snapshot without a footer was not closed.
+        if (std::memcmp(f->magic, magic, sizeof(magic)) != 0)
+            fail(file_name, "incomplete snapshot");
+
+        if (f->index_offset + f->node_count * sizeof(index_entry)
+          > size_ - sizeof(file_footer))
+            fail(file_name, "corrupt index");
+
+        index_ = reinterpret_cast<index_entry const*>
+            (base_ + f->index_offset);
+        node_count_ = f->node_count;
+
+        boost::uint64_t const bs = block_size(header_->interior_length
+                                            , header_->state_size);
+
+        for (boost::uint64_t i = 0; i < node_count_; ++i)
+            if (index_[i].offset + bs > f->index_offset)
+                fail(file_name, "corrupt index");
+    } // }}}
+
+    ~reader()
+    {
+        close();
+    }
+
+    file_header const& header() const
+    {
+        return *header_;
+    }
+
+    boost::uint64_t size() const
+    {
+        return node_count_;
+    }
+
+    /// The index, sorted by (level, location).
+    index_entry const* begin() const
+    {
+        return index_;
+    }
+
+    index_entry const* end() const
+    {
+        return index_ + node_count_;
+    }
+
+    node_view node(index_entry const& e) const
+    {
+        return node_view(e, base_, *header_);
+    }
+
+    /// Returns the index entry of the node on \a level at \a location, or 0
+    /// if it is not in this file.
+    index_entry const* find(
+        boost::uint64_t level
+      , boost::uint64_t x
+      , boost::uint64_t y
+      , boost::uint64_t z
+        ) const
+    { // {{{
+        index_entry key;
+        std::memset(&key, 0, sizeof(key));
+        key.level = level;
+        key.location[0] = x;
+        key.location[1] = y;
+        key.location[2] = z;
+
+        index_entry const* it = std::lower_bound(begin(), end(), key);
+
+        if (it == end() || key < *it)
+            return 0;
+
+        return it;
+    } // }}}
+};
+
+}}
+
+#endif // OCTOPUS_96307D8B_3F88_4732_B0BC_F5B19BE7A617
+
@@ -14,30 +14,155 @@
 #include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/version.hpp>
 
-#define OCTOPUS_WRITER_BASE_VERSION 0x01
+#define OCTOPUS_WRITER_BASE_VERSION 0x02
 
 namespace octopus
 {
 
+/// Selects the nodes that a writer writes. By default every node is written.
+/// The conditions can be combined; a node is written if it meets all of
+/// them.
+struct output_filter
+{
+    ///< Only write nodes that are not fully refined, i.e. that have at least
+    ///  one zone which is not covered by a child.
+    bool leaves_only;
+
+    ///< Only write nodes on levels less than or equal to this.
+    boost::uint64_t max_level;
+
+    ///< Only write nodes whose interior intersects [lower, upper].
+    bool clip;
+    array<double, 3> lower;
+    array<double, 3> upper;
+
+    output_filter()
+      : leaves_only(false)
+      , max_level(boost::uint64_t(-1))
+      , clip(false)
+      , lower()
+      , upper()
+    {}
+
+    static output_filter leaves()
+    {
+        output_filter f;
+        f.leaves_only = true;
+        return f;
+    }
+
+    static output_filter up_to_level(boost::uint64_t level)
+    {
+        output_filter f;
+        f.max_level = level;
+        return f;
+    }
+
+    static output_filter intersecting(
+        array<double, 3> const& lower
+      , array<double, 3> const& upper
+        )
+    {
+        output_filter f;
+        f.clip = true;
+        f.lower = lower;
+        f.upper = upper;
+        return f;
+    }
+
+    bool operator()(octree_server& e) const
+    { // {{{
+        if (e.get_level() > max_level)
+            return false;
+
+        if (leaves_only && (8 == e.number_of_children()))
+            return false;
+
+        if (clip)
+        {
+            array<double, 3> const& l = e.get_bounds_lower();
+            array<double, 3> const& u = e.get_bounds_upper();
+
+            for (boost::uint64_t d = 0; d < 3; ++d)
+                if (u[d] < lower[d] || upper[d] < l[d])
+                    return false;
+        }
+
+        return true;
+    } // }}}
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int)
+    {
+        ar & leaves_only;
+        ar & max_level;
+        ar & clip;
+        ar & lower;
+        ar & upper;
+    }
+};
+
 struct OCTOPUS_EXPORT writer_base
 {
+  private:
+    output_filter filter_;
+
+  public:
+    writer_base() : filter_() {}
+
     virtual ~writer_base() {}
 
+    output_filter const& get_filter() const
+    {
+        return filter_;
+    }
+
+    void set_filter(output_filter const& f)
+    {
+        filter_ = f;
+    }
+
+    /// Copies the writer, including its filter.
+    writer_base* copy() const
+    {
+        writer_base* w = clone();
+        w->filter_ = filter_;
+        return w;
+    }
+
+    /// Opens the output of the calling locality for the epoch of \a step.
+    virtual void start_write(
+        boost::uint64_t step
+      , double time
+        )
+    { }
+
+    /// Closes the output of the calling locality.
+    virtual void stop_write() { }
+
+    /// Calls start_write on science().output on every locality, and waits
+    /// for them to finish.
     // FIXME: Would be nice to get rid of the "time" parameter.
     virtual void begin_epoch(
         octree_server& e
       , double time
-        )
-    { }
+        );
 
-    virtual void end_epoch(octree_server& e) { }
+    /// Calls stop_write on science().output on every locality, and waits for
+    /// them to finish.
+    virtual void end_epoch(octree_server& e);
 
     virtual void operator()(octree_server& e) = 0;
 
     virtual writer_base* clone() const = 0;
 
     template <typename Archive>
-    void serialize(Archive& ar, const unsigned int) {}
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        // Version 1 writers had no filter.
+        if (version >= 2)
+            ar & filter_;
+    }
 };
 
 // FIXME: Move support.
@@ -54,7 +179,7 @@ struct writer
     {}
 
     writer(writer_base const& other)
-      : ptr_(other.clone())
+      : ptr_(other.copy())
     {}
 
     writer& operator=(writer const& other)
@@ -65,7 +190,7 @@ struct writer
 
     writer& operator=(writer_base const& other)
     {
-        ptr_.reset(other.clone());
+        ptr_.reset(other.copy());
         return *this;
     }
 
@@ -82,6 +207,19 @@ struct writer
         ptr_->end_epoch(e);
     }
 
+    void start_write(
+        boost::uint64_t step
+      , double time
+        ) const
+    {
+        ptr_->start_write(step, time);
+    }
+
+    void stop_write() const
+    {
+        ptr_->stop_write();
+    }
+
     template <typename Derived>
     Derived* cast() const
     {
@@ -90,7 +228,8 @@ struct writer
 
     void operator()(octree_server& e) const
     {
-        (*ptr_)(e);
+        if (ptr_->get_filter()(e))
+            (*ptr_)(e);
     }
 
     template<class Archive>
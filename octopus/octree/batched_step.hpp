@@ -0,0 +1,47 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_9B6C164E_2525_4E10_B3C8_C33C29C128D4)
+#define OCTOPUS_9B6C164E_2525_4E10_B3C8_C33C29C128D4
+
+#include <octopus/config.hpp>
+
+// Batched stepping: instead of one step_kernel thread per node, which stays
+// alive (and mostly suspended) for the whole timestep, each locality runs the
+// timestep of each of its nodes as a dataflow graph of stages (see the stages
+// of octree_server). The stages that depend on other nodes (ghost zones and
+// injection) return futures, and the rest of the node's step is attached to
+// them as a continuation. No thread blocks waiting for another node, there
+// are no per-stage or per-level barriers, and a node runs ahead into its next
+// stage as soon as its own dependencies are met.
+
+namespace octopus
+{
+
+/// \brief Take a timestep of size \a dt on every node resident on this
+///        locality, running the stages of the step as a per-node dataflow
+///        graph.
+///
+/// Every other locality must be stepped concurrently.
+///
+/// Remote Operations:   Yes (ghost zones and injection).
+/// Concurrency Control: Same as octree_server::step.
+/// Synchrony Gurantee:  Synchronous.
+OCTOPUS_EXPORT void step_local_nodes_batched(double dt);
+
+/// \brief Take a timestep of size \a dt on every node in the simulation with
+///        step_local_nodes_batched.
+///
+/// Remote Operations:   Yes.
+/// Concurrency Control: Same as octree_server::step.
+/// Synchrony Gurantee:  Synchronous.
+OCTOPUS_EXPORT void step_batched(double dt);
+
+}
+
+#endif // OCTOPUS_9B6C164E_2525_4E10_B3C8_C33C29C128D4
+
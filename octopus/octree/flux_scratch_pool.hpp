@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_2DDBEFBD_92A7_4BD9_BCB1_03CFAD443885)
+#define OCTOPUS_2DDBEFBD_92A7_4BD9_BCB1_03CFAD443885
+
+#include <hpx/lcos/local/mutex.hpp>
+
+#include <octopus/assert.hpp>
+#include <octopus/config.hpp>
+#include <octopus/vector4d.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+namespace octopus
+{
+
+/// The fluxes of a sub step on each axis. They are only needed while they
+/// are computed and summed into the flux differentials (flux_stage), which
+/// never waits on another node, so they are leased for that section only.
+struct OCTOPUS_EXPORT flux_scratch : boost::noncopyable
+{
+    vector4d<double> FX; ///< Flux (X-axis).
+    vector4d<double> FY; ///< Flux (Y-axis).
+    vector4d<double> FZ; ///< Flux (Z-axis).
+
+    flux_scratch(boost::uint64_t gnx)
+      : FX(gnx), FY(gnx), FZ(gnx)
+    {}
+};
+
+/// What a node keeps of the fluxes of a sub step between flux_stage and
+/// update_stage: the flux differential, and the fluxes on the planes that
+/// the fluxes of our children are injected into and that our own fluxes are
+/// sent to our parent from. Those are the planes at bw, gnx / 2 and gnx - bw
+/// on each axis; see flux_plane.
+struct OCTOPUS_EXPORT flux_differentials : boost::noncopyable
+{
+    vector4d<double> D;  ///< Flux differential.
+    vector4d<double> FX; ///< Flux (X-axis), 3 x gnx x gnx.
+    vector4d<double> FY; ///< Flux (Y-axis), gnx x 3 x gnx.
+    vector4d<double> FZ; ///< Flux (Z-axis), gnx x gnx x 3.
+
+    flux_differentials(boost::uint64_t gnx)
+      : D(gnx), FX(3, gnx, gnx), FY(gnx, 3, gnx), FZ(gnx, gnx, 3)
+    {}
+};
+
+/// Returns the index into the planes of flux_differentials of the face
+/// index \a i, which has to be bw, gnx / 2 or gnx - bw.
+inline boost::uint64_t flux_plane(
+    boost::uint64_t i
+  , boost::uint64_t bw
+  , boost::uint64_t gnx
+    )
+{
+    if (i == bw)
+        return 0;
+    else if (i == gnx / 2)
+        return 1;
+
+    OCTOPUS_ASSERT(i == gnx - bw);
+    return 2;
+}
+
+/// Pool of flux_scratch buffers shared by the octree_servers that are resident
+/// on this locality. A lease only covers the computation of a node's fluxes
+/// and their differentials, which does not wait for other nodes, so the
+/// number of buffers follows the number of flux computations that run at
+/// once (about the number of worker threads) rather than the number of nodes.
+struct OCTOPUS_EXPORT flux_scratch_pool : boost::noncopyable
+{
+  private:
+    typedef hpx::lcos::local::mutex mutex_type;
+
+    mutable mutex_type mtx_;
+    std::vector<boost::shared_ptr<flux_scratch> > free_;
+    std::size_t allocated_;
+    std::size_t leased_;
+    std::size_t peak_leased_;
+
+  public:
+    flux_scratch_pool()
+      : mtx_(), free_(), allocated_(0), leased_(0), peak_leased_(0)
+    {}
+
+    /// Returns a free buffer, allocating one if there are none.
+    boost::shared_ptr<flux_scratch> acquire();
+
+    /// Returns \a s to the pool and resets it.
+    void release(boost::shared_ptr<flux_scratch>& s);
+
+    /// Returns the number of buffers that have been allocated.
+    std::size_t allocated() const
+    {
+        mutex_type::scoped_lock l(mtx_);
+        return allocated_;
+    }
+
+    /// Returns the number of buffers that are not leased.
+    std::size_t available() const
+    {
+        mutex_type::scoped_lock l(mtx_);
+        return free_.size();
+    }
+
+    /// Returns the largest number of buffers that have been leased at the
+    /// same time.
+    std::size_t peak_leased() const
+    {
+        mutex_type::scoped_lock l(mtx_);
+        return peak_leased_;
+    }
+};
+
+/// Returns the flux scratch pool for this locality.
+OCTOPUS_EXPORT flux_scratch_pool& local_flux_scratch_pool();
+
+/// Leases a buffer from a flux_scratch_pool for the lifetime of the lease, so
+/// that it is given back if a kernel throws.
+struct flux_scratch_lease : boost::noncopyable
+{
+  private:
+    flux_scratch_pool& pool_;
+    boost::shared_ptr<flux_scratch> scratch_;
+
+  public:
+    explicit flux_scratch_lease(flux_scratch_pool& pool)
+      : pool_(pool), scratch_(pool.acquire())
+    {}
+
+    ~flux_scratch_lease()
+    {
+        pool_.release(scratch_);
+    }
+
+    flux_scratch& operator*() const
+    {
+        return *scratch_;
+    }
+
+    flux_scratch* operator->() const
+    {
+        return scratch_.get();
+    }
+};
+
+}
+
+#endif // OCTOPUS_2DDBEFBD_92A7_4BD9_BCB1_03CFAD443885
@@ -0,0 +1,418 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_B3E85C17_29D4_4A6F_9C02_7F1D6E4A83B5)
+#define OCTOPUS_B3E85C17_29D4_4A6F_9C02_7F1D6E4A83B5
+
+#include <octopus/engine/engine_interface.hpp>
+#include <octopus/octree/octree_reduce.hpp>
+
+#include <boost/serialization/utility.hpp>
+
+#include <utility>
+
+// Fused reductions compute several global quantities in a single traversal of
+// the octree, with a single sweep over the cells of each node. Each quantity
+// is described by a (map, combine, initial) triple:
+//
+//     * nodal_reduction - map is called once per node:
+//           T map(octree_server& U)
+//     * zonal_reduction - map is called once per interior cell:
+//           T map(octree_server& U, uint64_t i, uint64_t j, uint64_t k)
+//
+// In both cases combine has the signature T combine(T const&, T const&), and
+// initial should be an identity of combine. Triples are composed with fuse(),
+// which produces nested std::pairs of results:
+//
+//     fuse(a, b)       -> std::pair<A, B>
+//     fuse(a, b, c)    -> std::pair<A, std::pair<B, C> >
+//     fuse(a, b, c, d) -> std::pair<A, std::pair<B, std::pair<C, D> > >
+//     fuse(a, b, c, d, e)
+//         -> std::pair<A, std::pair<B, std::pair<C, std::pair<D, E> > > >
+//
+// Everything here is built on top of octree_server::reduce_typed, so all the
+// functors must be serializable.
+
+namespace octopus
+{
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename Map, typename Combine, typename T>
+struct nodal_reduction
+{
+    typedef T result_type;
+
+    Map map;
+    Combine combine;
+    T initial;
+
+    nodal_reduction() : map(), combine(), initial() {}
+
+    nodal_reduction(Map const& m, Combine const& c, T const& i)
+      : map(m), combine(c), initial(i)
+    {}
+
+    bool zonal() const
+    {
+        return false;
+    }
+
+    void node(octree_server& U, T& result) const
+    {
+        result = combine(result, map(U));
+    }
+
+    void zone(
+        octree_server&
+      , boost::uint64_t
+      , boost::uint64_t
+      , boost::uint64_t
+      , T&
+        ) const
+    {}
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        ar & map;
+        ar & combine;
+        ar & initial;
+    }
+};
+
+template <typename Map, typename Combine, typename T>
+inline nodal_reduction<Map, Combine, T> make_nodal_reduction(
+    Map const& m
+  , Combine const& c
+  , T const& i
+    )
+{
+    return nodal_reduction<Map, Combine, T>(m, c, i);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename Map, typename Combine, typename T>
+struct zonal_reduction
+{
+    typedef T result_type;
+
+    Map map;
+    Combine combine;
+    T initial;
+
+    zonal_reduction() : map(), combine(), initial() {}
+
+    zonal_reduction(Map const& m, Combine const& c, T const& i)
+      : map(m), combine(c), initial(i)
+    {}
+
+    bool zonal() const
+    {
+        return true;
+    }
+
+    void node(octree_server&, T&) const {}
+
+    void zone(
+        octree_server& U
+      , boost::uint64_t i
+      , boost::uint64_t j
+      , boost::uint64_t k
+      , T& result
+        ) const
+    {
+        result = combine(result, map(U, i, j, k));
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        ar & map;
+        ar & combine;
+        ar & initial;
+    }
+};
+
+template <typename Map, typename Combine, typename T>
+inline zonal_reduction<Map, Combine, T> make_zonal_reduction(
+    Map const& m
+  , Combine const& c
+  , T const& i
+    )
+{
+    return zonal_reduction<Map, Combine, T>(m, c, i);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename A, typename B>
+struct fused_reduction
+{
+    typedef std::pair<
+        typename A::result_type
+      , typename B::result_type
+    > result_type;
+
+    A a;
+    B b;
+
+    fused_reduction() : a(), b() {}
+
+    fused_reduction(A const& a_, B const& b_) : a(a_), b(b_) {}
+
+    bool zonal() const
+    {
+        return a.zonal() || b.zonal();
+    }
+
+    result_type initial_value() const
+    {
+        return result_type(initial_of(a), initial_of(b));
+    }
+
+    void node(octree_server& U, result_type& result) const
+    {
+        a.node(U, result.first);
+        b.node(U, result.second);
+    }
+
+    void zone(
+        octree_server& U
+      , boost::uint64_t i
+      , boost::uint64_t j
+      , boost::uint64_t k
+      , result_type& result
+        ) const
+    {
+        a.zone(U, i, j, k, result.first);
+        b.zone(U, i, j, k, result.second);
+    }
+
+    result_type combine_values(
+        result_type const& x
+      , result_type const& y
+        ) const
+    {
+        return result_type(combine_of(a, x.first, y.first)
+                         , combine_of(b, x.second, y.second));
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        ar & a;
+        ar & b;
+    }
+
+  private:
+    template <typename R>
+    static typename R::result_type initial_of(R const& r)
+    {
+        return r.initial;
+    }
+
+    template <typename X, typename Y>
+    static typename fused_reduction<X, Y>::result_type
+    initial_of(fused_reduction<X, Y> const& r)
+    {
+        return r.initial_value();
+    }
+
+    template <typename R>
+    static typename R::result_type combine_of(
+        R const& r
+      , typename R::result_type const& x
+      , typename R::result_type const& y
+        )
+    {
+        return r.combine(x, y);
+    }
+
+    template <typename X, typename Y>
+    static typename fused_reduction<X, Y>::result_type combine_of(
+        fused_reduction<X, Y> const& r
+      , typename fused_reduction<X, Y>::result_type const& x
+      , typename fused_reduction<X, Y>::result_type const& y
+        )
+    {
+        return r.combine_values(x, y);
+    }
+};
+
+template <typename A, typename B>
+inline fused_reduction<A, B> fuse(
+    A const& a
+  , B const& b
+    )
+{
+    return fused_reduction<A, B>(a, b);
+}
+
+template <typename A, typename B, typename C>
+inline fused_reduction<A, fused_reduction<B, C> > fuse(
+    A const& a
+  , B const& b
+  , C const& c
+    )
+{
+    return fuse(a, fuse(b, c));
+}
+
+template <typename A, typename B, typename C, typename D>
+inline fused_reduction<A, fused_reduction<B, fused_reduction<C, D> > > fuse(
+    A const& a
+  , B const& b
+  , C const& c
+  , D const& d
+    )
+{
+    return fuse(a, fuse(b, c, d));
+}
+
+template <typename A, typename B, typename C, typename D, typename E>
+inline fused_reduction<
+    A, fused_reduction<B, fused_reduction<C, fused_reduction<D, E> > >
+> fuse(
+    A const& a
+  , B const& b
+  , C const& c
+  , D const& d
+  , E const& e
+    )
+{
+    return fuse(a, fuse(b, c, d, e));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Adaptors which turn a fused reduction into the (map, reducer) pair expected
+// by octree_server::reduce_typed.
+
+/// Computes the partial result of a single node: one call to node() and one
+/// sweep over the interior cells (if any of the reductions is zonal).
+template <typename A, typename B>
+struct fused_reduction_map
+{
+    typedef typename fused_reduction<A, B>::result_type result_type;
+
+    fused_reduction<A, B> r;
+
+    fused_reduction_map() : r() {}
+
+    fused_reduction_map(fused_reduction<A, B> const& r_) : r(r_) {}
+
+    result_type operator()(octree_server& U) const
+    { // {{{
+        result_type result = r.initial_value();
+
+        r.node(U, result);
+
+        if (!r.zonal())
+            return result;
+
+        boost::uint64_t const bw = science().ghost_zone_length;
+        boost::uint64_t const gnx = config().grid_node_length;
+
+        for (boost::uint64_t i = bw; i < (gnx - bw); ++i)
+            for (boost::uint64_t j = bw; j < (gnx - bw); ++j)
+                for (boost::uint64_t k = bw; k < (gnx - bw); ++k)
+                    r.zone(U, i, j, k, result);
+
+        return result;
+    } // }}}
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        ar & r;
+    }
+};
+
+template <typename A, typename B>
+struct fused_reduction_combine
+{
+    typedef typename fused_reduction<A, B>::result_type result_type;
+
+    fused_reduction<A, B> r;
+
+    fused_reduction_combine() : r() {}
+
+    fused_reduction_combine(fused_reduction<A, B> const& r_) : r(r_) {}
+
+    result_type operator()(
+        result_type const& x
+      , result_type const& y
+        ) const
+    {
+        return r.combine_values(x, y);
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        ar & r;
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Compute all the quantities in \a r in one traversal of the tree
+///        rooted at \a root.
+///
+/// Remote Operations:   Yes.
+/// Concurrency Control: Same as octree_server::reduce_typed.
+/// Synchrony Gurantee:  Asynchronous.
+template <typename A, typename B>
+inline hpx::future<typename fused_reduction<A, B>::result_type>
+reduce_fused_async(
+    octree_client const& root
+  , fused_reduction<A, B> const& r
+    )
+{
+    typedef typename fused_reduction<A, B>::result_type result_type;
+    return root.reduce_typed_async<result_type>
+        ( fused_reduction_map<A, B>(r)
+        , fused_reduction_combine<A, B>(r)
+        , r.initial_value());
+}
+
+/// \brief Compute all the quantities in \a r in one traversal of the tree
+///        rooted at \a root.
+///
+/// Remote Operations:   Yes.
+/// Concurrency Control: Same as octree_server::reduce_typed.
+/// Synchrony Gurantee:  Synchronous.
+template <typename A, typename B>
+inline typename fused_reduction<A, B>::result_type reduce_fused(
+    octree_client const& root
+  , fused_reduction<A, B> const& r
+    )
+{
+    return reduce_fused_async(root, r).get();
+}
+
+/// \brief Compute all the quantities in \a r in one traversal of the tree
+///        rooted at \a root. Intended for use from functors passed to
+///        apply_leaf, which receive the root octree_server.
+///
+/// Remote Operations:   Yes.
+/// Concurrency Control: Same as octree_server::reduce_typed.
+/// Synchrony Gurantee:  Synchronous.
+template <typename A, typename B>
+inline typename fused_reduction<A, B>::result_type reduce_fused(
+    octree_server& root
+  , fused_reduction<A, B> const& r
+    )
+{
+    typedef typename fused_reduction<A, B>::result_type result_type;
+    return root.reduce_typed<result_type>
+        ( fused_reduction_map<A, B>(r)
+        , fused_reduction_combine<A, B>(r)
+        , r.initial_value());
+}
+
+}
+
+#endif // OCTOPUS_B3E85C17_29D4_4A6F_9C02_7F1D6E4A83B5
+
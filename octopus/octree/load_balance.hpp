@@ -0,0 +1,302 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_1F6C3A2D_84E7_4B59_A0D8_5E27C9B14F63)
+#define OCTOPUS_1F6C3A2D_84E7_4B59_A0D8_5E27C9B14F63
+
+#include <hpx/hpx_fwd.hpp>
+#include <hpx/lcos/future_wait.hpp>
+
+#include <octopus/engine/engine_interface.hpp>
+#include <octopus/octree/octree_reduce.hpp>
+#include <octopus/octree/node_cost.hpp>
+#include <octopus/science/space_filling_curve_distribution.hpp>
+#include <octopus/trivial_serialization.hpp>
+
+#include <boost/serialization/vector.hpp>
+
+#include <vector>
+
+namespace octopus
+{
+
+///////////////////////////////////////////////////////////////////////////////
+/// Measured load of the octree, binned by locality and by level. Seconds are
+/// per timestep (see node_cost).
+struct load_histogram
+{
+    std::vector<double>          locality_seconds;
+    std::vector<boost::uint64_t> locality_nodes;
+
+    std::vector<double>          level_seconds;
+    std::vector<boost::uint64_t> level_nodes;
+
+    /// Per phase totals over the whole tree.
+    array<double, number_of_cost_phases> phase_seconds;
+
+    load_histogram()
+      : locality_seconds()
+      , locality_nodes()
+      , level_seconds()
+      , level_nodes()
+      , phase_seconds()
+    {}
+
+    void add(
+        boost::uint64_t locality
+      , boost::uint64_t level
+      , node_cost const& c
+        )
+    { // {{{
+        if (locality_seconds.size() <= locality)
+        {
+            locality_seconds.resize(locality + 1, 0.0);
+            locality_nodes.resize(locality + 1, 0);
+        }
+
+        if (level_seconds.size() <= level)
+        {
+            level_seconds.resize(level + 1, 0.0);
+            level_nodes.resize(level + 1, 0);
+        }
+
+        double const total = c.total();
+
+        locality_seconds[locality] += total;
+        ++locality_nodes[locality];
+
+        level_seconds[level] += total;
+        ++level_nodes[level];
+
+        for (boost::uint64_t i = 0; i < number_of_cost_phases; ++i)
+            phase_seconds[i] += c.seconds[i];
+    } // }}}
+
+    /// Ratio of the busiest locality's load to the mean load. 1.0 is perfect.
+    double imbalance() const
+    { // {{{
+        if (locality_seconds.empty())
+            return 1.0;
+
+        double sum = 0.0;
+        double max = 0.0;
+
+        for (boost::uint64_t i = 0; i < locality_seconds.size(); ++i)
+        {
+            sum += locality_seconds[i];
+            max = (std::max)(max, locality_seconds[i]);
+        }
+
+        if (0.0 >= sum)
+            return 1.0;
+
+        return max / (sum / double(locality_seconds.size()));
+    } // }}}
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        ar & locality_seconds;
+        ar & locality_nodes;
+        ar & level_seconds;
+        ar & level_nodes;
+        ar & phase_seconds;
+    }
+};
+
+struct measure_node_load : trivial_serialization
+{
+    load_histogram operator()(octree_server& e) const
+    {
+        load_histogram h;
+        h.add(hpx::get_locality_id(), e.get_level(), e.get_cost());
+        return h;
+    }
+};
+
+struct merge_load_histograms : trivial_serialization
+{
+    load_histogram operator()(
+        load_histogram const& a
+      , load_histogram const& b
+        ) const
+    { // {{{
+        load_histogram r(a);
+
+        if (r.locality_seconds.size() < b.locality_seconds.size())
+        {
+            r.locality_seconds.resize(b.locality_seconds.size(), 0.0);
+            r.locality_nodes.resize(b.locality_nodes.size(), 0);
+        }
+
+        if (r.level_seconds.size() < b.level_seconds.size())
+        {
+            r.level_seconds.resize(b.level_seconds.size(), 0.0);
+            r.level_nodes.resize(b.level_nodes.size(), 0);
+        }
+
+        for (boost::uint64_t i = 0; i < b.locality_seconds.size(); ++i)
+        {
+            r.locality_seconds[i] += b.locality_seconds[i];
+            r.locality_nodes[i] += b.locality_nodes[i];
+        }
+
+        for (boost::uint64_t i = 0; i < b.level_seconds.size(); ++i)
+        {
+            r.level_seconds[i] += b.level_seconds[i];
+            r.level_nodes[i] += b.level_nodes[i];
+        }
+
+        for (boost::uint64_t i = 0; i < number_of_cost_phases; ++i)
+            r.phase_seconds[i] += b.phase_seconds[i];
+
+        return r;
+    } // }}}
+};
+
+/// \brief Compute the per-locality and per-level load histogram of the tree
+///        rooted at \a root.
+///
+/// Remote Operations:   Yes.
+/// Concurrency Control: Locks mtx_ of every node briefly.
+/// Synchrony Gurantee:  Asynchronous.
+inline hpx::future<load_histogram> measure_load_async(
+    octree_client const& root
+    )
+{
+    return root.reduce_async<load_histogram>
+        (measure_node_load(), merge_load_histograms(), load_histogram());
+}
+
+inline load_histogram measure_load(
+    octree_client const& root
+    )
+{
+    return measure_load_async(root).get();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+struct gather_node_costs : trivial_serialization
+{
+    std::vector<space_filling_curve_node> operator()(octree_server& e) const
+    {
+        node_cost const c = e.get_cost();
+
+        std::vector<space_filling_curve_node> v;
+        v.push_back(space_filling_curve_node(e.get_level(), e.get_location()
+                                           , c.samples ? c.total() : 0.0));
+        return v;
+    }
+};
+
+struct concatenate_node_costs : trivial_serialization
+{
+    std::vector<space_filling_curve_node> operator()(
+        std::vector<space_filling_curve_node> const& a
+      , std::vector<space_filling_curve_node> const& b
+        ) const
+    {
+        std::vector<space_filling_curve_node> r;
+        r.reserve(a.size() + b.size());
+        r.insert(r.end(), a.begin(), a.end());
+        r.insert(r.end(), b.begin(), b.end());
+        return r;
+    }
+};
+
+struct install_distribution
+{
+  private:
+    space_filling_curve_distribution distribution_;
+
+  public:
+    install_distribution() : distribution_() {}
+
+    install_distribution(space_filling_curve_distribution const& d)
+      : distribution_(d)
+    {}
+
+    void operator()() const
+    {
+        science().distribute = distribution_;
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        ar & distribution_;
+    }
+};
+
+/// \brief Re-partition the space-filling curve using the measured cost of
+///        every node in the tree rooted at \a root, and install the result
+///        as science().distribute on every locality. Nodes that are created
+///        afterwards (e.g. by refine()) are placed using the new partition;
+///        existing nodes do not move.
+///
+/// Nodes that have not stepped yet are given the mean measured cost of their
+/// level (or of the whole tree, if their level has no measurements), so that
+/// measured and unmeasured nodes are in the same units.
+///
+/// This must not be called concurrently with refinement. If
+/// config().rebalance_on_refine is set, octree_server::refine calls this
+/// between marking and populating each level.
+///
+/// Remote Operations:   Yes.
+/// Concurrency Control: Locks mtx_ of every node briefly.
+/// Synchrony Gurantee:  Synchronous.
+inline void rebalance(
+    octree_client const& root
+  , space_filling_curve curve = hilbert_curve
+    )
+{ // {{{
+    std::vector<space_filling_curve_node> nodes
+        = root.reduce<std::vector<space_filling_curve_node> >
+            (gather_node_costs(), concatenate_node_costs());
+
+    std::vector<double> level_sum;
+    std::vector<boost::uint64_t> level_count;
+
+    double sum = 0.0;
+    boost::uint64_t count = 0;
+
+    for (boost::uint64_t i = 0; i < nodes.size(); ++i)
+    {
+        if (level_sum.size() <= nodes[i].level)
+        {
+            level_sum.resize(nodes[i].level + 1, 0.0);
+            level_count.resize(nodes[i].level + 1, 0);
+        }
+
+        if (0.0 < nodes[i].cost)
+        {
+            level_sum[nodes[i].level] += nodes[i].cost;
+            ++level_count[nodes[i].level];
+            sum += nodes[i].cost;
+            ++count;
+        }
+    }
+
+    double const mean = count ? (sum / double(count)) : 1.0;
+
+    // One extra level, for the children that refine() is about to create.
+    std::vector<double> weights(level_sum.size() + 1, mean);
+
+    for (boost::uint64_t l = 0; l < level_sum.size(); ++l)
+        if (level_count[l])
+            weights[l] = level_sum[l] / double(level_count[l]);
+
+    space_filling_curve_distribution dist(curve, weights);
+    dist.partition(nodes, localities().size());
+
+    hpx::wait(call_everywhere(install_distribution(dist)));
+} // }}}
+
+}
+
+#endif // OCTOPUS_1F6C3A2D_84E7_4B59_A0D8_5E27C9B14F63
+
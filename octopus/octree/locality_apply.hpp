@@ -0,0 +1,215 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_3D35B98F_88F8_485D_B863_47B03B6A5E6C)
+#define OCTOPUS_3D35B98F_88F8_485D_B863_47B03B6A5E6C
+
+#include <hpx/lcos/future_wait.hpp>
+#include <hpx/async.hpp>
+
+#include <octopus/engine/engine_interface.hpp>
+#include <octopus/octree/octree_server.hpp>
+#include <octopus/octree/octree_registry.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#include <vector>
+
+// Tree-wide operations that do not follow the shape of the octree. The
+// operation is fanned out to every locality once, with a binary tree over the
+// localities, and each locality then runs it on the nodes in its
+// octree_registry in parallel. This costs O(localities) remote actions instead
+// of one per node, and no locality has to wait for its nodes to be discovered
+// hop by hop through their ancestors.
+//
+// These visit every registered node on every locality, so they assume that
+// there is only one octree (octree_client::create_root checks this). Nodes
+// that are created while an operation is in flight may or may not be visited.
+// octree_server::apply and apply_typed use them when they are invoked on the
+// root, and so does output.
+
+namespace octopus
+{
+
+namespace detail
+{
+
+template <typename F>
+inline void apply_to_node(F const& f, octree_server* e)
+{
+    f(*e);
+}
+
+/// Apply \a f to the nodes resident on this locality that are on \a level (or
+/// on all levels).
+template <typename F>
+inline void apply_local_nodes(
+    F const& f
+  , boost::uint64_t level
+    )
+{ // {{{
+    std::vector<octree_server*> const nodes
+        = local_octree_registry().nodes(level);
+
+    std::vector<hpx::future<void> > recursion_is_parallelism;
+    recursion_is_parallelism.reserve(nodes.size());
+
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+        recursion_is_parallelism.push_back(hpx::async(boost::bind(
+            &apply_to_node<F>, boost::cref(f), nodes[i])));
+
+    hpx::wait(recursion_is_parallelism);
+} // }}}
+
+template <typename F>
+void apply_by_locality_recurse(
+    F const& f
+  , boost::uint64_t level
+  , boost::uint64_t first
+  , boost::uint64_t last
+    );
+
+template <typename F>
+struct apply_by_locality_recurse_action
+  : hpx::actions::make_action<
+        void (*)( F const&, boost::uint64_t
+                , boost::uint64_t, boost::uint64_t)
+      , &apply_by_locality_recurse<F>
+      , apply_by_locality_recurse_action<F>
+    >
+{};
+
+/// Called on localities()[first]; applies to the localities in [first, last).
+/// The localities after first are split into two halves, each of which is
+/// delegated to its first locality.
+template <typename F>
+inline void apply_by_locality_recurse(
+    F const& f
+  , boost::uint64_t level
+  , boost::uint64_t first
+  , boost::uint64_t last
+    )
+{ // {{{
+    OCTOPUS_ASSERT(first < last);
+    OCTOPUS_ASSERT(last <= localities().size());
+
+    typedef apply_by_locality_recurse_action<F> action_type;
+
+    std::vector<hpx::future<void> > subtrees;
+    subtrees.reserve(2);
+
+    boost::uint64_t const begin = first + 1;
+    boost::uint64_t const middle = begin + (last - begin) / 2;
+
+    if (begin < middle)
+        subtrees.push_back(hpx::async<action_type>
+            (localities()[begin], f, level, begin, middle));
+
+    if (middle < last)
+        subtrees.push_back(hpx::async<action_type>
+            (localities()[middle], f, level, middle, last));
+
+    apply_local_nodes(f, level);
+
+    hpx::wait(subtrees);
+} // }}}
+
+}
+
+/// \brief Apply \a f to every octree_server in the simulation that is on
+///        \a level (or on any level, if \a level is all_levels).
+///
+/// \a f has the signature void(octree_server&). The order in which nodes are
+/// visited is unspecified; all the nodes on a locality may run concurrently.
+///
+/// Remote Operations:   Yes, O(localities).
+/// Concurrency Control: Locks the octree_registry of each locality briefly.
+/// Synchrony Gurantee:  Asynchronous.
+template <typename F>
+inline hpx::future<void> apply_by_locality_async(
+    F const& f
+  , boost::uint64_t level = all_levels
+    )
+{
+    typedef detail::apply_by_locality_recurse_action<F> action_type;
+
+    OCTOPUS_ASSERT_MSG(!localities().empty(),
+                       "no localities supporting Octopus available");
+
+    return hpx::async<action_type>(localities()[0], f, level
+                                 , 0, localities().size());
+}
+
+/// \brief Apply \a f to every octree_server in the simulation that is on
+///        \a level (or on any level, if \a level is all_levels).
+///
+/// Remote Operations:   Yes, O(localities).
+/// Concurrency Control: Locks the octree_registry of each locality briefly.
+/// Synchrony Gurantee:  Synchronous.
+template <typename F>
+inline void apply_by_locality(
+    F const& f
+  , boost::uint64_t level = all_levels
+    )
+{
+    apply_by_locality_async(f, level).get();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+struct step_node
+{
+  private:
+    double dt_;
+
+  public:
+    step_node() : dt_(0.0) {}
+
+    step_node(double dt) : dt_(dt) {}
+
+    void operator()(octree_server& e) const
+    {
+        e.step_node(dt_);
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        ar & dt_;
+    }
+};
+
+/// \brief Take a timestep of size \a dt on every node in the simulation.
+///
+/// Equivalent to octree_server::step, but instead of walking the tree each
+/// locality starts the step kernels of all its nodes directly.
+///
+/// Remote Operations:   Yes, O(localities).
+/// Concurrency Control: Same as octree_server::step.
+/// Synchrony Gurantee:  Asynchronous.
+inline hpx::future<void> step_by_locality_async(
+    double dt
+    )
+{
+    return apply_by_locality_async(step_node(dt));
+}
+
+inline void step_by_locality(
+    double dt
+    )
+{
+    step_by_locality_async(dt).get();
+}
+
+}
+
+HPX_REGISTER_ACTION_DECLARATION_TEMPLATE(
+    (template <typename F>),
+    (octopus::detail::apply_by_locality_recurse_action<F>))
+
+#endif // OCTOPUS_3D35B98F_88F8_485D_B863_47B03B6A5E6C
+
@@ -0,0 +1,181 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_E9A27D35_1B6C_4F48_8D03_62C5A0F1B7E9)
+#define OCTOPUS_E9A27D35_1B6C_4F48_8D03_62C5A0F1B7E9
+
+#include <hpx/lcos/future_wait.hpp>
+#include <hpx/async.hpp>
+
+#include <octopus/engine/engine_interface.hpp>
+#include <octopus/octree/octree_server.hpp>
+#include <octopus/octree/octree_registry.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#include <vector>
+
+// Reductions over every octree_server in the simulation that do not follow
+// the shape of the octree. Each locality first reduces the nodes in its
+// octree_registry, and the per-locality partials are then combined with a
+// binary tree over the localities. The number of remote messages is
+// O(localities) instead of O(nodes), and the depth is O(log(localities)).
+//
+// These visit every registered node on every locality, so they assume that
+// there is only one octree (octree_client::create_root checks this).
+// octree_server::reduce and reduce_typed use them when they are invoked on
+// the root.
+
+namespace octopus
+{
+
+namespace detail
+{
+
+template <typename T, typename F>
+inline T invoke_on_node(F const& f, octree_server* e)
+{
+    return f(*e);
+}
+
+/// Reduce the nodes resident on this locality.
+template <typename T, typename F, typename Reducer>
+inline T reduce_local_nodes(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial
+    )
+{ // {{{
+    std::vector<octree_server*> const nodes = local_octree_registry().nodes();
+
+    std::vector<hpx::future<T> > partials;
+    partials.reserve(nodes.size());
+
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+        partials.push_back(hpx::async(boost::bind(
+            &invoke_on_node<T, F>, boost::cref(f), nodes[i])));
+
+    T result = initial;
+
+    for (std::size_t i = 0; i < partials.size(); ++i)
+        result = reducer(result, partials[i].get());
+
+    return result;
+} // }}}
+
+template <typename T, typename F, typename Reducer>
+T reduce_by_locality_recurse(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial
+  , boost::uint64_t first
+  , boost::uint64_t last
+    );
+
+template <typename T, typename F, typename Reducer>
+struct reduce_by_locality_recurse_action
+  : hpx::actions::make_action<
+        T (*)( F const&, Reducer const&, T const&
+             , boost::uint64_t, boost::uint64_t)
+      , &reduce_by_locality_recurse<T, F, Reducer>
+      , reduce_by_locality_recurse_action<T, F, Reducer>
+    >
+{};
+
+/// Called on localities()[first]; reduces the localities in [first, last).
+/// The localities after first are split into two halves, each of which is
+/// delegated to its first locality.
+template <typename T, typename F, typename Reducer>
+inline T reduce_by_locality_recurse(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial
+  , boost::uint64_t first
+  , boost::uint64_t last
+    )
+{ // {{{
+    OCTOPUS_ASSERT(first < last);
+    OCTOPUS_ASSERT(last <= localities().size());
+
+    typedef reduce_by_locality_recurse_action<T, F, Reducer> action_type;
+
+    std::vector<hpx::future<T> > subtrees;
+    subtrees.reserve(2);
+
+    boost::uint64_t const begin = first + 1;
+    boost::uint64_t const middle = begin + (last - begin) / 2;
+
+    if (begin < middle)
+        subtrees.push_back(hpx::async<action_type>
+            (localities()[begin], f, reducer, initial, begin, middle));
+
+    if (middle < last)
+        subtrees.push_back(hpx::async<action_type>
+            (localities()[middle], f, reducer, initial, middle, last));
+
+    T result = reduce_local_nodes<T>(f, reducer, initial);
+
+    for (std::size_t i = 0; i < subtrees.size(); ++i)
+        result = reducer(result, subtrees[i].get());
+
+    return result;
+} // }}}
+
+}
+
+/// \brief Reduce every octree_server in the simulation, combining nodes on the
+///        same locality locally before any communication happens.
+///
+/// \a f has the signature T(octree_server&) and \a reducer has the signature
+/// T(T const&, T const&); \a initial should be an identity of \a reducer. The
+/// order in which nodes are combined is unspecified.
+///
+/// Remote Operations:   Yes, O(localities).
+/// Concurrency Control: Locks the octree_registry of each locality briefly.
+/// Synchrony Gurantee:  Asynchronous.
+template <typename T, typename F, typename Reducer>
+inline hpx::future<T> reduce_by_locality_async(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial = T()
+    )
+{
+    typedef detail::reduce_by_locality_recurse_action<T, F, Reducer>
+        action_type;
+
+    OCTOPUS_ASSERT_MSG(!localities().empty(),
+                       "no localities supporting Octopus available");
+
+    return hpx::async<action_type>(localities()[0], f, reducer, initial
+                                 , 0, localities().size());
+}
+
+/// \brief Reduce every octree_server in the simulation, combining nodes on the
+///        same locality locally before any communication happens.
+///
+/// Remote Operations:   Yes, O(localities).
+/// Concurrency Control: Locks the octree_registry of each locality briefly.
+/// Synchrony Gurantee:  Synchronous.
+template <typename T, typename F, typename Reducer>
+inline T reduce_by_locality(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial = T()
+    )
+{
+    return reduce_by_locality_async<T>(f, reducer, initial).get();
+}
+
+}
+
+HPX_REGISTER_ACTION_DECLARATION_TEMPLATE(
+    (template <typename T, typename F, typename Reducer>),
+    (octopus::detail::reduce_by_locality_recurse_action<T, F, Reducer>))
+
+#endif // OCTOPUS_E9A27D35_1B6C_4F48_8D03_62C5A0F1B7E9
+
@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_7E2D4B91_C3A8_4F06_B5D1_96E0A4F38C2B)
+#define OCTOPUS_7E2D4B91_C3A8_4F06_B5D1_96E0A4F38C2B
+
+#include <octopus/assert.hpp>
+#include <octopus/array.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <vector>
+
+namespace octopus
+{
+
+/// The parts of a timestep that are timed separately.
+enum cost_phase
+{
+    flux_phase          = 0, ///< compute_flux and sum_differentials.
+    differential_phase  = 1, ///< sum_flow_off and add_differentials.
+    ghost_zone_phase    = 2, ///< communicate_ghost_zones, including waiting.
+    injection_phase     = 3, ///< Child -> parent state and flux injection.
+    invalid_cost_phase  = 4
+};
+
+boost::uint64_t const number_of_cost_phases = 4;
+
+/// Wall-clock seconds per timestep spent by a node in each phase, averaged
+/// over the steps in the node's timing window.
+struct node_cost
+{
+    array<double, number_of_cost_phases> seconds;
+
+    ///< Number of steps that the averages are taken over. 0 if the node has
+    ///  not stepped yet.
+    boost::uint64_t samples;
+
+    node_cost() : seconds(), samples(0) {}
+
+    double total() const
+    {
+        double sum = 0.0;
+        for (boost::uint64_t i = 0; i < number_of_cost_phases; ++i)
+            sum += seconds[i];
+        return sum;
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        ar & seconds;
+        ar & samples;
+    }
+};
+
+/// Sliding window of per-step phase timings. Time is accumulated into the
+/// current step with add() and moved into the window by commit(), which drops
+/// the oldest step once the window is full.
+struct phase_timings
+{
+  private:
+    std::vector<array<double, number_of_cost_phases> > window_;
+    boost::uint64_t head_;
+    boost::uint64_t count_;
+
+    array<double, number_of_cost_phases> current_;
+
+  public:
+    phase_timings(boost::uint64_t length = 1)
+      : window_(length == 0 ? 1 : length)
+      , head_(0)
+      , count_(0)
+      , current_()
+    {}
+
+    void add(cost_phase p, double seconds)
+    {
+        OCTOPUS_ASSERT(invalid_cost_phase > p);
+        current_[p] += seconds;
+    }
+
+    void commit()
+    { // {{{
+        window_[head_] = current_;
+        head_ = (head_ + 1) % window_.size();
+
+        if (count_ < window_.size())
+            ++count_;
+
+        for (boost::uint64_t i = 0; i < number_of_cost_phases; ++i)
+            current_[i] = 0.0;
+    } // }}}
+
+    node_cost average() const
+    { // {{{
+        node_cost c;
+        c.samples = count_;
+
+        if (0 == count_)
+            return c;
+
+        // The oldest entries are overwritten first, so the first count_
+        // entries are exactly the ones that are live until the window fills.
+        for (boost::uint64_t s = 0; s < count_; ++s)
+            for (boost::uint64_t i = 0; i < number_of_cost_phases; ++i)
+                c.seconds[i] += window_[s][i];
+
+        for (boost::uint64_t i = 0; i < number_of_cost_phases; ++i)
+            c.seconds[i] /= double(count_);
+
+        return c;
+    } // }}}
+};
+
+}
+
+#endif // OCTOPUS_7E2D4B91_C3A8_4F06_B5D1_96E0A4F38C2B
+
@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_9D3E1B47_6A2C_4F85_B8E0_C47A2F91D536)
+#define OCTOPUS_9D3E1B47_6A2C_4F85_B8E0_C47A2F91D536
+
+#include <hpx/lcos/future_wait.hpp>
+#include <hpx/async.hpp>
+
+#include <octopus/engine/engine_interface.hpp>
+#include <octopus/octree/octree_server.hpp>
+#include <octopus/octree/locality_apply.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+namespace octopus
+{
+
+template <typename F>
+inline void octree_server::apply_typed(
+    F const& f
+    )
+{
+    // The whole tree is visited per locality, without walking it.
+    if (0 == level_)
+    {
+        apply_by_locality(f);
+        return;
+    }
+
+    std::vector<hpx::future<void> > recursion_is_parallelism;
+    
+    recursion_is_parallelism.reserve(8);
+    
+    for (boost::uint64_t i = 0; i < 8; ++i)
+        if (hpx::invalid_id != children_[i])
+            recursion_is_parallelism.push_back
+                (children_[i].template apply_typed_async<F>(f)); 
+    
+    // Invoke the kernel on ourselves ...
+    f(*this);
+
+    // ... and block while our children compute.
+    hpx::wait(recursion_is_parallelism); 
+}
+
+template <typename F>
+inline void octree_client::apply_typed(
+    F const& f
+    ) const
+{
+    apply_typed_async<F>(f).get();
+}
+
+template <typename F>
+inline hpx::future<void> octree_client::apply_typed_async(
+    F const& f
+    ) const
+{
+    ensure_real();
+    typedef octopus::octree_server::apply_typed_action<F> action_type;
+    return hpx::async<action_type>(gid_, f); 
+}
+
+template <typename F>
+inline void octree_server::apply_zonal_plane_kernel(
+    F const& f
+  , boost::uint64_t i
+  , bool leaf_only
+    )
+{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    for (boost::uint64_t j = bw; j < (gnx - bw); ++j)
+        for (boost::uint64_t k = bw; k < (gnx - bw); ++k)
+        {
+            if (leaf_only && zone_is_refined(i, j, k))
+                continue;
+
+            f(*this, i, j, k);
+        }
+}
+
+template <typename F>
+inline void octree_server::apply_zonal_kernel(
+    F const& f
+  , bool leaf_only
+    )
+{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    // A fully refined node has no leaf zones.
+    if (leaf_only && (8 == number_of_children()))
+        return;
+
+    std::vector<hpx::future<void> > planes;
+    planes.reserve(gnx - 2 * bw);
+
+    // Do all the planes but one in other threads ...
+    for (boost::uint64_t i = bw + 1; i < (gnx - bw); ++i)
+        planes.push_back(hpx::async(boost::bind(
+            &octree_server::template apply_zonal_plane_kernel<F>
+          , this, boost::cref(f), i, leaf_only)));
+
+    // ... and do one here.
+    apply_zonal_plane_kernel(f, bw, leaf_only);
+
+    hpx::wait(planes);
+}
+
+template <typename F>
+inline void octree_server::apply_zonal(
+    F const& f
+    )
+{
+    std::vector<hpx::future<void> > recursion_is_parallelism;
+    
+    recursion_is_parallelism.reserve(8);
+    
+    for (boost::uint64_t i = 0; i < 8; ++i)
+        if (hpx::invalid_id != children_[i])
+            recursion_is_parallelism.push_back
+                (children_[i].template apply_zonal_async<F>(f)); 
+    
+    // Invoke the kernel on ourselves ...
+    apply_zonal_kernel(f, false);
+
+    // ... and block while our children compute.
+    hpx::wait(recursion_is_parallelism); 
+}
+
+template <typename F>
+inline void octree_server::apply_zonal_leaf(
+    F const& f
+    )
+{
+    std::vector<hpx::future<void> > recursion_is_parallelism;
+    
+    recursion_is_parallelism.reserve(8);
+    
+    for (boost::uint64_t i = 0; i < 8; ++i)
+        if (hpx::invalid_id != children_[i])
+            recursion_is_parallelism.push_back
+                (children_[i].template apply_zonal_leaf_async<F>(f)); 
+    
+    // Invoke the kernel on ourselves ...
+    apply_zonal_kernel(f, true);
+
+    // ... and block while our children compute.
+    hpx::wait(recursion_is_parallelism); 
+}
+
+template <typename F>
+inline void octree_client::apply_zonal(
+    F const& f
+    ) const
+{
+    apply_zonal_async<F>(f).get();
+}
+
+template <typename F>
+inline hpx::future<void> octree_client::apply_zonal_async(
+    F const& f
+    ) const
+{
+    ensure_real();
+    typedef octopus::octree_server::apply_zonal_action<F> action_type;
+    return hpx::async<action_type>(gid_, f); 
+}
+
+template <typename F>
+inline void octree_client::apply_zonal_leaf(
+    F const& f
+    ) const
+{
+    apply_zonal_leaf_async<F>(f).get();
+}
+
+template <typename F>
+inline hpx::future<void> octree_client::apply_zonal_leaf_async(
+    F const& f
+    ) const
+{
+    ensure_real();
+    typedef octopus::octree_server::apply_zonal_leaf_action<F> action_type;
+    return hpx::async<action_type>(gid_, f); 
+}
+
+}
+
+HPX_REGISTER_ACTION_DECLARATION_TEMPLATE(
+    (template <typename F>),
+    (octopus::octree_server::apply_typed_action<F>))
+
+HPX_REGISTER_ACTION_DECLARATION_TEMPLATE(
+    (template <typename F>),
+    (octopus::octree_server::apply_zonal_action<F>))
+
+HPX_REGISTER_ACTION_DECLARATION_TEMPLATE(
+    (template <typename F>),
+    (octopus::octree_server::apply_zonal_leaf_action<F>))
+
+#endif // OCTOPUS_9D3E1B47_6A2C_4F85_B8E0_C47A2F91D536
@@ -48,11 +48,41 @@ inline hpx::future<T> octree_client::apply_leaf_async(
     return hpx::async<action_type>(gid_, f); 
 }
 
+template <typename T, typename F>
+inline T octree_server::apply_leaf_typed(
+    F const& f
+    ) 
+{
+    return f(*this);
+}
+
+template <typename T, typename F>
+inline T octree_client::apply_leaf_typed(
+    F const& f
+    ) const 
+{
+    return apply_leaf_typed_async<T, F>(f).get();
+}
+
+template <typename T, typename F>
+inline hpx::future<T> octree_client::apply_leaf_typed_async(
+    F const& f
+    ) const 
+{
+    ensure_real();
+    typedef octopus::octree_server::apply_leaf_typed_action<T, F> action_type;
+    return hpx::async<action_type>(gid_, f); 
+}
+
 }
 
 HPX_REGISTER_ACTION_DECLARATION_TEMPLATE(
     (template <typename T>),
     (octopus::octree_server::apply_leaf_action<T>))
 
+HPX_REGISTER_ACTION_DECLARATION_TEMPLATE(
+    (template <typename T, typename F>),
+    (octopus::octree_server::apply_leaf_typed_action<T, F>))
+
 #endif // OCTOPUS_3ECF87C0_9B92_4637_A0C1_ABADBAA8CDF9
 
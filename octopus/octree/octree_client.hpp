@@ -13,6 +13,7 @@
 #include <hpx/util/function.hpp>
 
 #include <octopus/octree/octree_init_data.hpp>
+#include <octopus/octree/node_cost.hpp>
 #include <octopus/child_index.hpp>
 #include <octopus/face.hpp>
 #include <octopus/axis.hpp>
@@ -20,6 +21,7 @@
 
 #include <boost/serialization/access.hpp>
 #include <boost/serialization/array.hpp>
+#include <boost/serialization/vector.hpp>
 
 namespace octopus
 {
@@ -634,6 +636,16 @@ struct OCTOPUS_EXPORT octree_client
     hpx::future<array<boost::uint64_t, 3> > get_location_async() const;
     // }}}
 
+    ///////////////////////////////////////////////////////////////////////////
+    // {{{ get_cost
+    node_cost get_cost() const
+    {
+        return get_cost_async().get();
+    }
+
+    hpx::future<node_cost> get_cost_async() const;
+    // }}}
+
     ///////////////////////////////////////////////////////////////////////////
     // {{{ Boundary forwarding code (implementation has moved to the server) 
   private:
@@ -705,6 +717,27 @@ struct OCTOPUS_EXPORT octree_client
         ) const;
     // }}}
 
+    ///////////////////////////////////////////////////////////////////////////
+    // {{{ receive_diagonal_ghost_zone
+    void receive_diagonal_ghost_zone(
+        boost::uint64_t step ///< For debugging purposes.
+      , boost::uint64_t phase 
+      , array<boost::int64_t, 3> const& direction ///< Of the caller.
+      , BOOST_RV_REF(vector4d<double>) zone
+        ) const
+    {
+        receive_diagonal_ghost_zone_async
+            (step, phase, direction, boost::move(zone)).get();
+    }
+
+    hpx::future<void> receive_diagonal_ghost_zone_async(
+        boost::uint64_t step ///< For debugging purposes.
+      , boost::uint64_t phase 
+      , array<boost::int64_t, 3> const& direction ///< Of the caller.
+      , BOOST_RV_REF(vector4d<double>) zone
+        ) const;
+    // }}}
+
     ///////////////////////////////////////////////////////////////////////////
     // {{{ child_to_parent_state_injection
     void child_to_parent_state_injection(
@@ -797,6 +830,67 @@ struct OCTOPUS_EXPORT octree_client
     hpx::future<void> step_async() const;
     // }}}
 
+    ///////////////////////////////////////////////////////////////////////////
+    // {{{ step_with_cfl
+    double step_with_cfl(
+        double cfl_factor
+      , double max_dt
+        ) const
+    {
+        return step_with_cfl_async(cfl_factor, max_dt).get();
+    }
+
+    hpx::future<double> step_with_cfl_async(
+        double cfl_factor
+      , double max_dt
+        ) const;
+    // }}}
+
+    ///////////////////////////////////////////////////////////////////////////
+    // {{{ receive_child_dt
+    void receive_child_dt(
+        boost::uint64_t step ///< For debugging purposes.
+      , child_index idx 
+      , double dt
+        ) const
+    {
+        receive_child_dt_async(step, idx, dt).get();
+    }
+
+    hpx::future<void> receive_child_dt_async(
+        boost::uint64_t step ///< For debugging purposes.
+      , child_index idx 
+      , double dt
+        ) const;
+
+    void receive_child_dt_push(
+        boost::uint64_t step ///< For debugging purposes.
+      , child_index idx 
+      , double dt
+        ) const;
+    // }}}
+
+    ///////////////////////////////////////////////////////////////////////////
+    // {{{ receive_step_dt
+    void receive_step_dt(
+        boost::uint64_t step ///< For debugging purposes.
+      , double dt
+        ) const
+    {
+        receive_step_dt_async(step, dt).get();
+    }
+
+    hpx::future<void> receive_step_dt_async(
+        boost::uint64_t step ///< For debugging purposes.
+      , double dt
+        ) const;
+
+    void receive_step_dt_push(
+        boost::uint64_t step ///< For debugging purposes.
+      , double dt
+        ) const;
+    // }}}
+
     ///////////////////////////////////////////////////////////////////////////
     // {{{ Refinement 
     void refine() const
@@ -922,6 +1016,112 @@ struct OCTOPUS_EXPORT octree_client
         ) const;
     // }}}
 
+    ///////////////////////////////////////////////////////////////////////////
+    // {{{ Typed variants of apply, apply_leaf, reduce and reduce_zonal -
+    // definitions are out-of-line in octree_apply.hpp, octree_apply_leaf.hpp
+    // and octree_reduce.hpp.
+    template <typename F>
+    void apply_typed(
+        F const& f
+        ) const;
+
+    template <typename F>
+    hpx::future<void> apply_typed_async(
+        F const& f
+        ) const;
+
+    template <typename T, typename F>
+    T apply_leaf_typed(
+        F const& f
+        ) const;
+
+    template <typename T, typename F>
+    hpx::future<T> apply_leaf_typed_async(
+        F const& f
+        ) const;
+
+    template <typename T, typename F, typename Reducer>
+    T reduce_typed(
+        F const& f
+      , Reducer const& reducer
+      , T const& initial = T()
+        ) const;
+
+    template <typename T, typename F, typename Reducer>
+    hpx::future<T> reduce_typed_async(
+        F const& f
+      , Reducer const& reducer
+      , T const& initial = T()
+        ) const;
+
+    template <typename T, typename F, typename Reducer>
+    T reduce_zonal_typed(
+        F const& f
+      , Reducer const& reducer
+      , T const& initial = T()
+        ) const;
+
+    template <typename T, typename F, typename Reducer>
+    hpx::future<T> reduce_zonal_typed_async(
+        F const& f
+      , Reducer const& reducer
+      , T const& initial = T()
+        ) const;
+    // }}}
+
+    ///////////////////////////////////////////////////////////////////////////
+    // {{{ Zonal and leaf variants of apply and reduce - definitions are
+    // out-of-line in octree_apply.hpp and octree_reduce.hpp. See
+    // octree_server for semantics.
+    template <typename F>
+    void apply_zonal(
+        F const& f
+        ) const;
+
+    template <typename F>
+    hpx::future<void> apply_zonal_async(
+        F const& f
+        ) const;
+
+    template <typename F>
+    void apply_zonal_leaf(
+        F const& f
+        ) const;
+
+    template <typename F>
+    hpx::future<void> apply_zonal_leaf_async(
+        F const& f
+        ) const;
+
+    template <typename T, typename F, typename Reducer>
+    T reduce_leaf(
+        F const& f
+      , Reducer const& reducer
+      , T const& initial = T()
+        ) const;
+
+    template <typename T, typename F, typename Reducer>
+    hpx::future<T> reduce_leaf_async(
+        F const& f
+      , Reducer const& reducer
+      , T const& initial = T()
+        ) const;
+
+    template <typename T, typename F, typename Reducer>
+    T reduce_zonal_leaf(
+        F const& f
+      , Reducer const& reducer
+      , T const& initial = T()
+        ) const;
+
+    template <typename T, typename F, typename Reducer>
+    hpx::future<T> reduce_zonal_leaf_async(
+        F const& f
+      , Reducer const& reducer
+      , T const& initial = T()
+        ) const;
+    // }}}
+
     ///////////////////////////////////////////////////////////////////////////
     // {{{ slice 
     void slice(
@@ -955,6 +1155,38 @@ struct OCTOPUS_EXPORT octree_client
         ) const;
     // }}}
 
+    ///////////////////////////////////////////////////////////////////////////
+    // {{{ region
+    void region(
+        slice_function const& f
+      , array<double, 3> const& lower
+      , array<double, 3> const& upper
+        ) const
+    {
+        region_async(f, lower, upper).get();
+    }
+
+    hpx::future<void> region_async(
+        slice_function const& f
+      , array<double, 3> const& lower
+      , array<double, 3> const& upper
+        ) const;
+    // }}}
+
+    ///////////////////////////////////////////////////////////////////////////
+    // {{{ probe
+    std::vector<state> probe(
+        std::vector<array<double, 3> > const& points
+        ) const
+    {
+        return probe_async(points).get();
+    }
+
+    hpx::future<std::vector<state> > probe_async(
+        std::vector<array<double, 3> > const& points
+        ) const;
+    // }}}
+
     ///////////////////////////////////////////////////////////////////////////
     // {{{ save/load 
     void save()
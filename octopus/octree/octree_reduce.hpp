@@ -13,6 +13,7 @@
 
 #include <octopus/engine/engine_interface.hpp>
 #include <octopus/octree/octree_server.hpp>
+#include <octopus/octree/locality_reduce.hpp>
 
 // Reimplement with when_all
 
@@ -29,6 +30,10 @@ inline T octree_server::reduce(
     // Make sure that we are initialized.
     //initialized_.wait();
 
+    // The whole tree is reduced per locality, without walking it.
+    if (0 == level_)
+        return reduce_by_locality<T>(f, reducer, initial);
+
     std::vector<hpx::future<T> > keep_alive;
     keep_alive.reserve(8);
 
@@ -150,6 +155,327 @@ inline hpx::future<T> octree_client::reduce_zonal_async(
     return hpx::async<action_type>(gid_, f, reducer, initial); 
 }
 
+template <typename T, typename F, typename Reducer>
+inline T octree_server::reduce_typed(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial
+    ) 
+{
+    // The whole tree is reduced per locality, without walking it.
+    if (0 == level_)
+        return reduce_by_locality<T>(f, reducer, initial);
+
+    std::vector<hpx::future<T> > keep_alive;
+    keep_alive.reserve(8);
+
+    std::vector<hpx::future<void> > recursion_is_parallelism;
+    recursion_is_parallelism.reserve(8);
+
+    T result = initial;
+
+    // Start recursively executing the ourself on our children.
+    for (boost::uint64_t i = 0; i < 8; ++i)
+        if (hpx::invalid_id != children_[i])
+        {
+            keep_alive.emplace_back
+                (children_[i].template reduce_typed_async<T>
+                    (f, reducer, initial));
+
+            // Reduce the results from our children.
+            recursion_is_parallelism.emplace_back(
+                keep_alive.back().then(boost::bind(
+                    &octree_server::template add_reduce_typed<T, Reducer>
+                  , this, boost::ref(result), boost::cref(reducer), _1))); 
+        }
+
+    T local_result = f(*this);
+
+    hpx::wait(recursion_is_parallelism);
+
+    return reducer(result, local_result);
+}
+
+template <typename T, typename F, typename Reducer>
+inline T octree_server::reduce_zonal_typed(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial
+    ) 
+{
+    std::vector<hpx::future<T> > keep_alive;
+    keep_alive.reserve(8);
+
+    std::vector<hpx::future<void> > recursion_is_parallelism;
+    recursion_is_parallelism.reserve(8);
+
+    T result = initial;
+
+    // Start recursively executing the ourself on our children.
+    for (boost::uint64_t i = 0; i < 8; ++i)
+        if (hpx::invalid_id != children_[i])
+        {
+            keep_alive.emplace_back
+                (children_[i].template reduce_zonal_typed_async<T>
+                    (f, reducer, initial)); 
+
+            // Reduce the results from our children.
+            recursion_is_parallelism.emplace_back(
+                keep_alive.back().then(boost::bind(
+                    &octree_server::template add_reduce_typed<T, Reducer>
+                  , this, boost::ref(result), boost::cref(reducer), _1))); 
+        }
+
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    vector4d<double>& U = *U_;
+
+    T local_result = initial;
+
+    // No type erasure here, so f and reducer can be inlined.
+    for (boost::uint64_t i = bw; i < (gnx - bw); ++i)
+        for (boost::uint64_t j = bw; j < (gnx - bw); ++j)
+            for (boost::uint64_t k = bw; k < (gnx - bw); ++k)
+                local_result = reducer(local_result, f(U(i, j, k))); 
+
+    hpx::wait(recursion_is_parallelism);
+
+    return reducer(result, local_result);
+}
+
+template <typename T, typename F, typename Reducer>
+inline T octree_client::reduce_typed(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial 
+    ) const
+{
+    return reduce_typed_async<T>(f, reducer, initial).get();
+}
+
+template <typename T, typename F, typename Reducer>
+inline hpx::future<T> octree_client::reduce_typed_async(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial 
+    ) const
+{
+    ensure_real();
+    typedef octopus::octree_server::reduce_typed_action<T, F, Reducer>
+        action_type;
+    return hpx::async<action_type>(gid_, f, reducer, initial); 
+}
+
+template <typename T, typename F, typename Reducer>
+inline T octree_client::reduce_zonal_typed(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial 
+    ) const 
+{
+    return reduce_zonal_typed_async<T>(f, reducer, initial).get();
+}
+
+template <typename T, typename F, typename Reducer>
+inline hpx::future<T> octree_client::reduce_zonal_typed_async(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial
+    ) const
+{
+    ensure_real();
+    typedef octopus::octree_server::reduce_zonal_typed_action<T, F, Reducer>
+        action_type;
+    return hpx::async<action_type>(gid_, f, reducer, initial); 
+}
+
+template <typename T, typename F, typename Reducer>
+inline T octree_server::reduce_leaf(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial
+    ) 
+{
+    std::vector<hpx::future<T> > keep_alive;
+    keep_alive.reserve(8);
+
+    std::vector<hpx::future<void> > recursion_is_parallelism;
+    recursion_is_parallelism.reserve(8);
+
+    T result = initial;
+
+    // Start recursively executing the ourself on our children.
+    for (boost::uint64_t i = 0; i < 8; ++i)
+        if (hpx::invalid_id != children_[i])
+        {
+            keep_alive.emplace_back
+                (children_[i].template reduce_leaf_async<T>
+                    (f, reducer, initial));
+
+            // Reduce the results from our children.
+            recursion_is_parallelism.emplace_back(
+                keep_alive.back().then(boost::bind(
+                    &octree_server::template add_reduce_typed<T, Reducer>
+                  , this, boost::ref(result), boost::cref(reducer), _1))); 
+        }
+
+    // We are only a leaf if we have no children.
+    if (!recursion_is_parallelism.empty())
+    {
+        hpx::wait(recursion_is_parallelism);
+        return result;
+    }
+
+    return reducer(result, f(*this));
+}
+
+template <typename T, typename F, typename Reducer>
+inline T octree_server::reduce_zonal_plane_kernel(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial
+  , boost::uint64_t i
+  , bool leaf_only
+    )
+{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    T result = initial;
+
+    for (boost::uint64_t j = bw; j < (gnx - bw); ++j)
+        for (boost::uint64_t k = bw; k < (gnx - bw); ++k)
+        {
+            if (leaf_only && zone_is_refined(i, j, k))
+                continue;
+
+            result = reducer(result, f(*this, i, j, k));
+        }
+
+    return result;
+}
+
+template <typename T, typename F, typename Reducer>
+inline T octree_server::reduce_zonal_kernel(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial
+  , bool leaf_only
+    )
+{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    // A fully refined node has no leaf zones.
+    if (leaf_only && (8 == number_of_children()))
+        return initial;
+
+    std::vector<hpx::future<T> > planes;
+    planes.reserve(gnx - 2 * bw);
+
+    // Do all the planes but one in other threads ...
+    for (boost::uint64_t i = bw + 1; i < (gnx - bw); ++i)
+        planes.push_back(hpx::async(boost::bind(
+            &octree_server::template reduce_zonal_plane_kernel<T, F, Reducer>
+          , this, boost::cref(f), boost::cref(reducer), boost::cref(initial)
+          , i, leaf_only)));
+
+    // ... and do one here.
+    T result = reduce_zonal_plane_kernel<T>
+        (f, reducer, initial, bw, leaf_only);
+
+    // Combine the planes in order, so that the result does not depend on
+    // scheduling. 
+    for (boost::uint64_t i = 0; i < planes.size(); ++i)
+        result = reducer(result, planes[i].get());
+
+    return result;
+}
+
+template <typename T, typename F, typename Reducer>
+inline T octree_server::reduce_zonal_leaf(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial
+    ) 
+{
+    std::vector<hpx::future<T> > keep_alive;
+    keep_alive.reserve(8);
+
+    std::vector<hpx::future<void> > recursion_is_parallelism;
+    recursion_is_parallelism.reserve(8);
+
+    T result = initial;
+
+    // Start recursively executing the ourself on our children.
+    for (boost::uint64_t i = 0; i < 8; ++i)
+        if (hpx::invalid_id != children_[i])
+        {
+            keep_alive.emplace_back
+                (children_[i].template reduce_zonal_leaf_async<T>
+                    (f, reducer, initial)); 
+
+            // Reduce the results from our children.
+            recursion_is_parallelism.emplace_back(
+                keep_alive.back().then(boost::bind(
+                    &octree_server::template add_reduce_typed<T, Reducer>
+                  , this, boost::ref(result), boost::cref(reducer), _1))); 
+        }
+
+    T local_result = reduce_zonal_kernel<T>(f, reducer, initial, true);
+
+    hpx::wait(recursion_is_parallelism);
+
+    return reducer(result, local_result);
+}
+
+template <typename T, typename F, typename Reducer>
+inline T octree_client::reduce_leaf(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial 
+    ) const
+{
+    return reduce_leaf_async<T>(f, reducer, initial).get();
+}
+
+template <typename T, typename F, typename Reducer>
+inline hpx::future<T> octree_client::reduce_leaf_async(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial 
+    ) const
+{
+    ensure_real();
+    typedef octopus::octree_server::reduce_leaf_action<T, F, Reducer>
+        action_type;
+    return hpx::async<action_type>(gid_, f, reducer, initial); 
+}
+
+template <typename T, typename F, typename Reducer>
+inline T octree_client::reduce_zonal_leaf(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial 
+    ) const 
+{
+    return reduce_zonal_leaf_async<T>(f, reducer, initial).get();
+}
+
+template <typename T, typename F, typename Reducer>
+inline hpx::future<T> octree_client::reduce_zonal_leaf_async(
+    F const& f
+  , Reducer const& reducer
+  , T const& initial
+    ) const
+{
+    ensure_real();
+    typedef octopus::octree_server::reduce_zonal_leaf_action<T, F, Reducer>
+        action_type;
+    return hpx::async<action_type>(gid_, f, reducer, initial); 
+}
+
 }
 
 HPX_REGISTER_ACTION_DECLARATION_TEMPLATE(
@@ -160,5 +486,21 @@ HPX_REGISTER_ACTION_DECLARATION_TEMPLATE(
     (template <typename T>),
     (octopus::octree_server::reduce_zonal_action<T>))
 
+HPX_REGISTER_ACTION_DECLARATION_TEMPLATE(
+    (template <typename T, typename F, typename Reducer>),
+    (octopus::octree_server::reduce_typed_action<T, F, Reducer>))
+
+HPX_REGISTER_ACTION_DECLARATION_TEMPLATE(
+    (template <typename T, typename F, typename Reducer>),
+    (octopus::octree_server::reduce_zonal_typed_action<T, F, Reducer>))
+
+HPX_REGISTER_ACTION_DECLARATION_TEMPLATE(
+    (template <typename T, typename F, typename Reducer>),
+    (octopus::octree_server::reduce_leaf_action<T, F, Reducer>))
+
+HPX_REGISTER_ACTION_DECLARATION_TEMPLATE(
+    (template <typename T, typename F, typename Reducer>),
+    (octopus::octree_server::reduce_zonal_leaf_action<T, F, Reducer>))
+
 #endif // OCTOPUS_CAB36801_B41D_4CED_A034_0BA437666DB3
 
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_4C8A1E6F_D27B_4093_A5E1_B80F3D92C7A4)
+#define OCTOPUS_4C8A1E6F_D27B_4093_A5E1_B80F3D92C7A4
+
+#include <hpx/lcos/local/mutex.hpp>
+
+#include <octopus/config.hpp>
+#include <octopus/assert.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <set>
+#include <vector>
+
+namespace octopus
+{
+
+struct OCTOPUS_EXPORT octree_server;
+
+/// Passed as the level to operations on the registry to select every level.
+boost::uint64_t const all_levels = boost::uint64_t(-1);
+
+/// Registry of the octree_servers that are resident on this locality, grouped
+/// by level. Nodes register themselves when they are constructed and
+/// unregister when they are destroyed. This lets operations that touch every
+/// node (e.g. reductions) work on all local nodes at once instead of recursing
+/// through the octree.
+///
+/// Pointers returned by nodes() are only valid as long as no node on this
+/// locality is destroyed; Octopus does not currently coarsen, so in practice
+/// this only rules out using them across a shutdown.
+struct OCTOPUS_EXPORT octree_registry : boost::noncopyable
+{
+  private:
+    typedef hpx::lcos::local::mutex mutex_type;
+
+    mutable mutex_type mtx_;
+    std::vector<std::set<octree_server*> > levels_;
+    std::size_t size_;
+
+  public:
+    octree_registry() : mtx_(), levels_(), size_(0) {}
+
+    void add(octree_server* e, boost::uint64_t level)
+    { // {{{
+        mutex_type::scoped_lock l(mtx_);
+
+        if (levels_.size() <= level)
+            levels_.resize(level + 1);
+
+        bool const inserted = levels_[level].insert(e).second;
+        OCTOPUS_ASSERT_MSG(inserted, "octree_server registered twice");
+
+        ++size_;
+    } // }}}
+
+    void remove(octree_server* e, boost::uint64_t level)
+    { // {{{
+        mutex_type::scoped_lock l(mtx_);
+
+        if (levels_.size() <= level)
+            return;
+
+        size_ -= levels_[level].erase(e);
+    } // }}}
+
+    /// Returns a snapshot of the nodes resident on this locality that are on
+    /// \a level (or on any level, if \a level is all_levels). When all
+    /// levels are requested, coarser nodes come first.
+    std::vector<octree_server*> nodes(boost::uint64_t level = all_levels) const
+    { // {{{
+        mutex_type::scoped_lock l(mtx_);
+
+        std::vector<octree_server*> v;
+
+        if (all_levels != level)
+        {
+            if (level < levels_.size())
+                v.assign(levels_[level].begin(), levels_[level].end());
+            return v;
+        }
+
+        v.reserve(size_);
+
+        for (std::size_t i = 0; i < levels_.size(); ++i)
+            v.insert(v.end(), levels_[i].begin(), levels_[i].end());
+
+        return v;
+    } // }}}
+
+    /// Returns one more than the finest level that has ever had a node on
+    /// this locality.
+    boost::uint64_t levels() const
+    {
+        mutex_type::scoped_lock l(mtx_);
+        return levels_.size();
+    }
+
+    std::size_t size() const
+    {
+        mutex_type::scoped_lock l(mtx_);
+        return size_;
+    }
+};
+
+/// Returns the registry for this locality.
+OCTOPUS_EXPORT octree_registry& local_octree_registry();
+
+}
+
+#endif // OCTOPUS_4C8A1E6F_D27B_4093_A5E1_B80F3D92C7A4
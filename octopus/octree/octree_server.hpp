@@ -15,16 +15,20 @@
 #include <hpx/runtime/components/server/managed_component_base.hpp>
 #include <hpx/lcos/local/mutex.hpp>
 #include <hpx/lcos/local/channel.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
 
 #include <octopus/array.hpp>
 #include <octopus/octree/octree_init_data.hpp>
 #include <octopus/octree/octree_client.hpp>
+#include <octopus/octree/node_cost.hpp>
+#include <octopus/octree/flux_scratch_pool.hpp>
 #include <octopus/atomic_bitset.hpp>
 
 #include <bitset>
+#include <vector>
+#include <utility>
 
-// TODO: apply_criteria, apply_zonal, apply_zonal_leaf, reduce_leaf,
-// reduce_zonal_leaf
+// TODO: apply_criteria
 // TODO: Get rid of unnecessary _kernel and _locked suffixes.
  
 namespace octopus
@@ -188,6 +192,29 @@ struct OCTOPUS_EXPORT flux_interpolation_data
     }
 };
 
+/// A node that we send edge or corner ghost zones to (wide halos only).
+struct OCTOPUS_EXPORT diagonal_interpolation_data
+{
+    octree_client subject;
+
+    ///< The direction of the subject from us, or, for nephews, from our
+    ///  child that does not exist.
+    array<boost::int64_t, 3> direction;
+
+    ///< For nephews, the offset of the subject minus twice ours.
+    array<boost::int64_t, 3> offset;
+
+    diagonal_interpolation_data() : subject(), direction(), offset() {}
+
+    diagonal_interpolation_data(
+        octree_client const& s
+      , array<boost::int64_t, 3> const& d
+      , array<boost::int64_t, 3> const& o
+        )
+      : subject(s), direction(d), offset(o)
+    {}
+};
+
 struct OCTOPUS_EXPORT octree_server
   : hpx::components::managed_component_base<octree_server>
 {
@@ -232,6 +259,12 @@ struct OCTOPUS_EXPORT octree_server
         hpx::lcos::local::channel<void>, 6
     > sibling_sync_dependencies;
 
+    // Indexed by diagonal_index(direction); only the edge and corner entries
+    // are used.
+    typedef array<
+        hpx::lcos::local::channel<vector4d<double> >, 27
+    > diagonal_state_dependencies;
+
     // IMPLEMENT: This should totally be in the science table, along with like
     // 3k other lines of stuff in octree_server.
     /// Bryce's math for the # of communications per step (for TVD RK):
@@ -243,6 +276,26 @@ struct OCTOPUS_EXPORT octree_server
     /// RK1, 2 GZ comms + 1 c->p flux + 1 c->p state = 4 comms
     /// RK2, 3 GZ comms + 2 c->p flux + 2 c->p state = 7 comms 
     /// RK3, 4 GZ comms + 3 c->p flux + 3 c->p state = 10 comms 
+    ///
+    /// Without config().final_ghost_zone_exchange, the GZ comm at the end of
+    /// each step is skipped (it is the same as the one at the start of the
+    /// next step, unless the tree is refined in between).
+    ///
+    /// With config().wide_halos, the ghost zones are runge_kutta_order times
+    /// as wide as the reconstruction needs (stencil_width()), and only the GZ
+    /// comms at the start (and end) of each step are done:
+    ///
+    /// RK3, 2 GZ comms + 3 c->p flux + 3 c->p state = 8 comms
+    ///
+    /// The GZ comm at the start of the step fills all of our ghost zones,
+    /// including the edges and corners (diagonal_ghost_zone_deps_). Sub step
+    /// phase then updates our interior plus update_extension(phase) zones of
+    /// them, which shrinks by stencil_width() each sub step, down to just the
+    /// interior in the last one. In between, only the ghost zones at the edge
+    /// of the domain are mapped again. At coarse/fine boundaries, the ghost
+    /// zones of the finer node are interpolated once per step and then
+    /// evolved by it. The c->p injections still happen every sub step, so
+    /// the coarser node stays conservative.
 
     // Queue for incoming ghost zones.
     // NOTE: Elements of this queue should be cleared but not removed until the
@@ -250,6 +303,10 @@ struct OCTOPUS_EXPORT octree_server
     // vector remain the same throughout the entire step. 
     std::vector<sibling_state_dependencies> ghost_zone_deps_;
 
+    // Queue for incoming edge and corner ghost zones (wide halos only); same
+    // layout as ghost_zone_deps_.
+    std::vector<diagonal_state_dependencies> diagonal_ghost_zone_deps_;
+
     // Queue for incoming state from our children.
     // NOTE: Elements of this queue should be cleared but not removed until the
     // end of each timestep. This is necessary to ensure that indices into this
@@ -276,6 +333,16 @@ struct OCTOPUS_EXPORT octree_server
                                        // neighbors.
     std::set<state_interpolation_data> nephews_;
     std::set<flux_interpolation_data> exterior_nephews_;
+
+    // Wide halos only, built by link_diagonals. The directions of our edges
+    // and corners that have a neighbor, which sends us their ghost zones;
+    // the nodes on our level that we send theirs to; and the nodes on our
+    // children's level next to one of our children that does not exist,
+    // which we interpolate them for.
+    std::vector<array<boost::int64_t, 3> > diagonal_directions_;
+    std::vector<diagonal_interpolation_data> diagonal_siblings_;
+    std::vector<diagonal_interpolation_data> diagonal_nephews_;
+
     boost::uint64_t level_;
     array<boost::uint64_t, 3> location_; 
 
@@ -292,6 +359,18 @@ struct OCTOPUS_EXPORT octree_server
     // might as well utilize this point of synchronization to reduce memory
     // usage. P.S., only used by the root of each timestep currently. 
     hpx::lcos::local::channel<double> dt_;
+
+    // Child -> parent reduction of the CFL timestep and parent -> child
+    // broadcast of the global CFL timestep (see step_with_cfl). Each value
+    // is consumed, and the channel reset, exactly once per step.
+    array<hpx::lcos::local::channel<double>, 8> children_dt_deps_;
+    hpx::lcos::local::channel<double> step_dt_dep_;
+
+    // The global CFL timestep of the next step. step_with_cfl starts its
+    // reduction at the end of each step, and the next step only waits for it
+    // before its first update. Not valid before the first step_with_cfl and
+    // after drop_next_cfl_dt.
+    hpx::future<double> next_cfl_dt_;
     
     double time_; ///< The current (physics?) time.
                   ///  NOTE: Confirmation needed from Dominic.
@@ -303,6 +382,12 @@ struct OCTOPUS_EXPORT octree_server
                                      ///  NOTE: Confirmation needed from
                                      ///  from Dominic.
 
+    ///< The physical extent of our interior, i.e. [x_face(bw),
+    ///  x_face(gnx - bw)) on the x-axis, and so on. Used to prune slices and
+    ///  region queries.
+    array<double, 3> bounds_lower_;
+    array<double, 3> bounds_upper_;
+
     // TODO: Rename step_.
     boost::uint64_t step_;
 
@@ -317,22 +402,30 @@ struct OCTOPUS_EXPORT octree_server
     // Data from previous timestep.
     boost::shared_ptr<vector4d<double> > U0_; 
 
-    // Scratch space for computations.
-    vector4d<double> FX_; ///< Flux (X-axis).
-    vector4d<double> FY_; ///< Flux (Y-axis).
-    vector4d<double> FZ_; ///< Flux (Z-axis).
+    // The flux differential and the flux planes of the current sub step.
+    // Created by begin_step_stage and dropped by end_step_stage; null outside
+    // of a step. The full fluxes are only held inside flux_stage, in a buffer
+    // leased from local_flux_scratch_pool().
+    boost::shared_ptr<flux_differentials> differentials_;
 
     boost::shared_ptr<state> FO_; ///< Flow off (stuff that
                                   ///  leaves the problem space).
 
     boost::shared_ptr<state> FO0_;
 
-    // Scratch space for computations.
-    vector4d<double> D_; ///< Flux differential.
-
     // Scratch space for computations.
     state DFO_; ///< Flow off differential. 
 
+    // Largest characteristic speed on the faces of each axis seen during the
+    // flux sweeps of the last timestep. Reset by begin_step_stage and load.
+    // Each entry is only written by the flux kernel of its axis, so the
+    // kernels do not contend.
+    array<double, 3> max_wave_speed_;
+
+    // Wall-clock time spent in each phase of the last few timesteps. Written
+    // by the thread running step_kernel; commit() and queries lock mtx_.
+    phase_timings timings_;
+
     ///////////////////////////////////////////////////////////////////////////
     // TODO: Migration.
 #if 0
@@ -412,15 +505,28 @@ struct OCTOPUS_EXPORT octree_server
     }
 
     ///////////////////////////////////////////////////////////////////////////
-    /// \brief Set the state of this node based on the state of its parent. 
+    /// \brief Set the state of this node based on the octant of the state of
+    ///        its parent that covers it (see send_child_octant).
     /// 
     /// Remote Operations:   No.
     /// Concurrency Control: Locks mtx_.
     /// Synchrony Gurantee:  Synchronous. 
     void parent_to_child_injection(
-        vector4d<double> const& pU
+        vector4d<double> const& parent_octant
         );
 
+    /// \brief Copies the part of our state that parent_to_child_injection
+    ///        reads for the child \a kid: the octant of the interior that the
+    ///        child covers plus a one cell border.
+    ///
+    /// Remote Operations:   No.
+    /// Concurrency Control: No; the caller must keep U_ from changing (both
+    ///                      callers run between timesteps).
+    /// Synchrony Gurantee:  Synchronous.
+    boost::shared_ptr<vector4d<double> > send_child_octant(
+        child_index kid
+        ) const;
+
     void initialize_queues();
 
     ///////////////////////////////////////////////////////////////////////////
@@ -474,13 +580,16 @@ struct OCTOPUS_EXPORT octree_server
       , octree_init_data const& init
         );
 
-    /// \brief Construct a child node.
+    /// \brief Construct a child node. \a parent_octant is produced by
+    ///        send_child_octant on the parent.
     octree_server(
         back_pointer_type back_ptr
       , octree_init_data const& init
-      , boost::shared_ptr<vector4d<double> > const& parent_U
+      , boost::shared_ptr<vector4d<double> > const& parent_octant
         );
 
+    ~octree_server();
+
     boost::uint64_t get_level() const
     {
         return level_;
@@ -501,6 +610,27 @@ struct OCTOPUS_EXPORT octree_server
         return dx_;
     }
 
+    /// Largest wave speed on the faces of each axis seen during the flux
+    /// sweeps of the last timestep (of the current one, during a step). Zero
+    /// if this node has not computed fluxes since it was created or loaded.
+    array<double, 3> get_max_wave_speed() const
+    {
+        return max_wave_speed_;
+    }
+
+    /// Largest wave speed of each axis at the centers of the interior zones,
+    /// for nodes that have no recorded wave speeds. Does not reconstruct,
+    /// so it is cheaper than a flux sweep, and not as tight.
+    array<double, 3> compute_max_wave_speed();
+
+    /// Everything that has left the problem space through the faces of this
+    /// node so far. Only meaningful for the root, whose faces are the
+    /// boundaries of the problem space.
+    state get_flow_off() const
+    {
+        return *FO_;
+    }
+
     double get_dt() const
     {
         return dt_.get();
@@ -612,6 +742,31 @@ struct OCTOPUS_EXPORT octree_server
 
     double z_face(boost::uint64_t i) const;
 
+    double face_coord(axis a, boost::uint64_t i) const;
+
+    array<double, 3> const& get_bounds_lower() const
+    {
+        return bounds_lower_;
+    }
+
+    array<double, 3> const& get_bounds_upper() const
+    {
+        return bounds_upper_;
+    }
+
+  private:
+    void compute_bounding_box();
+
+    /// Returns true if the octant that our \a kid child covers intersects
+    /// the box [\a lower, \a upper].
+    bool child_intersects(
+        child_index kid
+      , array<double, 3> const& lower
+      , array<double, 3> const& upper
+        ) const;
+
+  public:
+
     std::ostream& debug() const
     {
         return std::cout << get_oid() << ": ";
@@ -651,6 +806,12 @@ struct OCTOPUS_EXPORT octree_server
   private:
     void clear_refinement_marks_kernel();
 
+    /// \brief Returns the initialization data of the \a kid child of this
+    ///        node.
+    octree_init_data child_init_data(
+        child_index kid
+        ) const;
+
   public:
     ///////////////////////////////////////////////////////////////////////////
     /// \brief Create the \a kid child for this node.
@@ -846,6 +1007,23 @@ struct OCTOPUS_EXPORT octree_server
                                       get_location,
                                       get_location_action);
 
+    ///////////////////////////////////////////////////////////////////////////
+    /// \brief Returns the average wall-clock time per timestep spent by this
+    ///        node in each phase, over the last config().cost_window steps.
+    ///
+    /// Remote Operations:   No.
+    /// Concurrency Control: Locks mtx_.
+    /// Synchrony Gurantee:  Synchronous. 
+    node_cost get_cost() const
+    {
+        mutex_type::scoped_lock l(mtx_);
+        return timings_.average();
+    }
+
+    HPX_DEFINE_COMPONENT_CONST_ACTION(octree_server,
+                                      get_cost,
+                                      get_cost_action);
+
     ///////////////////////////////////////////////////////////////////////////
     // Ghost zone communication
     // NOTE: This was contained in enforce_boundaries in the original code.
@@ -853,13 +1031,64 @@ struct OCTOPUS_EXPORT octree_server
     // REVIEW: I think step 2.) can come before step 1.).
     /// 0.) Push ghost zone data to our siblings and determine which ghost zones
     ///     we will receive.
-    /// 1.) Wait for our ghost zones to be delivered by our siblings.
-    /// 2.) Push ghost zone data to our nephews.
+    /// 1.) Once our ghost zones have been delivered by our siblings ...
+    /// 2.) ... push ghost zone data to our nephews.
+    ///
+    /// Does not block; the returned future becomes ready once 2.) is done.
+    hpx::future<void> communicate_ghost_zones_async(
+        boost::uint64_t phase
+        );
+
     void communicate_ghost_zones(
+        boost::uint64_t phase
+        )
+    {
+        communicate_ghost_zones_async(phase).get();
+    }
+
+    /// \brief Exchange ghost zones between all the nodes of the subtree
+    ///        rooted at this node, outside of a timestep. \a phase selects
+    ///        the ghost zone queue to use, and must not be in use by a
+    ///        timestep.
+    ///
+    /// Remote Operations:   Yes.
+    /// Concurrency Control: Same as communicate_ghost_zones.
+    /// Synchrony Gurantee:  Synchronous.
+    void exchange_ghost_zones(
         boost::uint64_t phase
         );
 
+    HPX_DEFINE_COMPONENT_ACTION(octree_server,
+                                exchange_ghost_zones,
+                                exchange_ghost_zones_action);
+
   private:
+    typedef hpx::future<std::vector<hpx::future<void> > > dependencies_future;
+
+    /// Propagates the errors (if any) of a set of ready dependencies.
+    static void get_dependencies(
+        dependencies_future& dependencies
+        );
+
+    /// Returns a future which becomes ready once the actions that a stage sent
+    /// to other nodes are done, and which carries their errors, so that the
+    /// stage fails instead of its receivers hanging.
+    static hpx::future<void> when_all_sends(
+        std::vector<hpx::future<void> >& sends
+        );
+
+    /// Continuation of when_all_sends.
+    static void get_sends(
+        dependencies_future sends
+        );
+
+    /// Continuation of communicate_ghost_zones_async; returns the sends to
+    /// our nephews (see when_all_sends).
+    hpx::future<void> push_nephew_ghost_zones(
+        boost::uint64_t phase ///< Bound parameter.
+      , dependencies_future dependencies
+        );
+
     void add_ghost_zone(
         face f
       , BOOST_RV_REF(vector4d<double>) zone
@@ -873,6 +1102,47 @@ struct OCTOPUS_EXPORT octree_server
         add_ghost_zone(f, boost::move(zone_f.move()));
     }
 
+    /// Maps the ghost zones of our faces that are on the edge of the domain
+    /// (see map_ghost_zone), in the order x, y, z. With wide halos this
+    /// covers our edges and corners there too, so all of our other ghost
+    /// zones have to be current.
+    void map_physical_ghost_zones();
+
+    /// Part of communicate_ghost_zones_async with wide halos: sets up the
+    /// callbacks which add our edge and corner ghost zones when they arrive,
+    /// and sends ours to diagonal_siblings_.
+    void communicate_diagonal_ghost_zones(
+        boost::uint64_t phase
+      , std::vector<hpx::future<void> >& dependencies
+        );
+
+    void add_diagonal_ghost_zone(
+        array<boost::int64_t, 3> const& direction ///< Of the sender, from us.
+      , BOOST_RV_REF(vector4d<double>) zone
+        );
+
+    void add_diagonal_ghost_zone_callback(
+        array<boost::int64_t, 3> const& direction ///< Bound parameter.
+      , hpx::future<vector4d<double> > zone_f
+        )
+    {
+        add_diagonal_ghost_zone(direction, boost::move(zone_f.move()));
+    }
+
+    /// Produces the part of our interior that the node in \a direction from
+    /// us needs for its edge or corner ghost zone.
+    vector4d<double> send_diagonal_ghost_zone(
+        array<boost::int64_t, 3> const& direction
+        ) const;
+
+    /// Interpolates the edge or corner ghost zone of a node on our children's
+    /// level; \a direction and \a offset are those of its
+    /// diagonal_interpolation_data.
+    vector4d<double> send_interpolated_diagonal_ghost_zone(
+        array<boost::int64_t, 3> const& direction
+      , array<boost::int64_t, 3> const& offset
+        ) const;
+
   public:
     // FIXME: Rvalue reference kung-fo must be applied here.
     /// Called by our siblings.
@@ -905,6 +1175,18 @@ struct OCTOPUS_EXPORT octree_server
                                 receive_ghost_zone,
                                 receive_ghost_zone_action);
 
+    /// Called by the nodes across our edges and corners (wide halos only).
+    void receive_diagonal_ghost_zone(
+        boost::uint64_t step ///< For debugging purposes.
+      , boost::uint64_t phase
+      , array<boost::int64_t, 3> const& direction ///< Of the caller, from us.
+      , vector4d<double> const& zone
+        );
+
+    HPX_DEFINE_COMPONENT_ACTION(octree_server,
+                                receive_diagonal_ghost_zone,
+                                receive_diagonal_ghost_zone_action);
+
   private:
     vector4d<double> send_ghost_zone_locked(
         face f ///< Our direction, relative to the caller.
@@ -952,11 +1234,27 @@ struct OCTOPUS_EXPORT octree_server
                                 child_to_parent_state_injection_action);
 
   private:
-    /// 0.) Blocks until the child -> parent state injection that is at \a phase
-    ///     in the queue is ready.
-    /// 1.) Send a child -> parent state injection up to our parent. 
+    /// 0.) Once the child -> parent state injection that is at \a phase in the
+    ///     queue is ready ...
+    /// 1.) ... send a child -> parent state injection up to our parent. 
+    ///
+    /// Does not block; the returned future becomes ready once 1.) is done.
+    hpx::future<void> child_to_parent_state_injection_kernel_async(
+        boost::uint64_t phase
+        );
+
     void child_to_parent_state_injection_kernel(
         boost::uint64_t phase
+        )
+    {
+        child_to_parent_state_injection_kernel_async(phase).get();
+    }
+
+    /// Continuation of child_to_parent_state_injection_kernel_async; returns
+    /// the send to our parent (see when_all_sends).
+    hpx::future<void> push_child_state(
+        boost::uint64_t phase ///< Bound parameter.
+      , dependencies_future dependencies
         );
 
     // FIXME: Rvalue reference kung-fo must be applied here.
@@ -1013,11 +1311,27 @@ struct OCTOPUS_EXPORT octree_server
                                 child_to_parent_flux_injection_action);
 
   private:
-    /// 0.) Blocks until the child -> parent flux injection that is at \a phase
-    ///     in the queue is ready.
-    /// 1.) Send a child -> parent flux injection up to our parent. 
+    /// 0.) Once the child -> parent flux injection that is at \a phase in the
+    ///     queue is ready ...
+    /// 1.) ... send a child -> parent flux injection up to our parent. 
+    ///
+    /// Does not block; the returned future becomes ready once 1.) is done.
+    hpx::future<void> child_to_parent_flux_injection_kernel_async(
+        boost::uint64_t phase
+        );
+
     void child_to_parent_flux_injection_kernel(
         boost::uint64_t phase
+        )
+    {
+        child_to_parent_flux_injection_kernel_async(phase).get();
+    }
+
+    /// Continuation of child_to_parent_flux_injection_kernel_async; returns
+    /// the sends to our parent and siblings (see when_all_sends).
+    hpx::future<void> push_child_flux(
+        boost::uint64_t phase ///< Bound parameter.
+      , dependencies_future dependencies
         );
 
     // FIXME: Rvalue reference kung-fo must be applied here.
@@ -1071,38 +1385,314 @@ struct OCTOPUS_EXPORT octree_server
                                 step_recurse,
                                 step_recurse_action);  
 
-    void step()
+    /// \brief Take a timestep of size get_dt(). If config().batched_stepping
+    ///        is set, every locality runs the stages of the step over all
+    ///        of its nodes (see step_batched); otherwise, the step recurses
+    ///        through the tree and each node runs step_kernel.
+    void step();
+
+    HPX_DEFINE_COMPONENT_ACTION(octree_server,
+                                step,
+                                step_action);  
+
+    /// \brief Take a timestep on this node only, without recursing to our
+    ///        children. Every other node in the tree must be stepped
+    ///        concurrently (see step_by_locality in locality_apply.hpp).
+    void step_node(double dt)
+    {
+        OCTOPUS_ASSERT_MSG(0 < dt, "invalid timestep size");
+        step_kernel(dt);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// Returns the CFL timestep of the subtree rooted at this node. \a max_dt
+    /// is only used by the root.
+    double step_with_cfl_recurse(double cfl_factor, double max_dt);
+
+    HPX_DEFINE_COMPONENT_ACTION(octree_server,
+                                step_with_cfl_recurse,
+                                step_with_cfl_recurse_action);  
+
+    /// \brief Take a timestep whose size is computed by the steps
+    ///        themselves, instead of by a separate CFL pass over the tree.
+    ///
+    /// Each node produces a partial CFL timestep (\a cfl_factor times dx over
+    /// the largest wave speed) as a by-product of its flux sweeps and sends
+    /// the minimum over its subtree to its parent; the root broadcasts the
+    /// global minimum back down. The reduction is a chain of continuations
+    /// (see reduce_cfl_dt_async), so no thread waits for it.
+    ///
+    /// The reduction for the next step is started at the end of each step,
+    /// from the wave speeds of all of its sub steps. The next step exchanges
+    /// its ghost zones and computes and injects its first fluxes while it is
+    /// in flight, and each node only waits for it before its first update.
+    /// After a regrid, and on the first step, there are no wave speeds yet;
+    /// the reduction is then started after the first flux sweep of the step.
+    ///
+    /// Every node takes the minimum of the global CFL timestep and \a max_dt.
+    /// The timestep that was taken is posted and can be read with get_dt()
+    /// afterwards. Returns the global CFL timestep that the step used.
+    ///
+    /// The step still ends with a join over the whole tree: nodes have one
+    /// set of ghost zone and injection queues per sub step, not per
+    /// timestep, so the next step cannot start on a node before the
+    /// current one is done everywhere.
+    ///
+    /// Remote Operations:   Yes.
+    /// Concurrency Control: None.
+    /// Synchrony Gurantee:  Synchronous.
+    double step_with_cfl(double cfl_factor, double max_dt)
     {
         OCTOPUS_ASSERT(0 == level_);
-        step_recurse(get_dt());
+        return step_with_cfl_recurse(cfl_factor, max_dt);
     }
 
+    /// \brief Asynchronous version of step_with_cfl; the returned future
+    ///        becomes ready once the step is done everywhere.
+    ///
+    /// The caller must not touch the tree until then.
+    ///
+    /// Remote Operations:   Yes.
+    /// Concurrency Control: None.
+    /// Synchrony Gurantee:  Asynchronous.
+    hpx::future<double> step_with_cfl_async(double cfl_factor, double max_dt);
+
+    /// \brief Waits for the CFL timestep reduction that the last
+    ///        step_with_cfl started for the next step (if any), and discards
+    ///        it. Called on every node before the tree is regridded, since
+    ///        the reduction follows the shape of the tree.
+    ///
+    /// Remote Operations:   No.
+    /// Concurrency Control: None.
+    /// Synchrony Gurantee:  Synchronous.
+    void drop_next_cfl_dt();
+
     HPX_DEFINE_COMPONENT_ACTION(octree_server,
-                                step,
-                                step_action);  
+                                step_with_cfl,
+                                step_with_cfl_action);  
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Child -> parent reduction of the CFL timestep.
+    void receive_child_dt(
+        boost::uint64_t step ///< For debugging purposes.
+      , child_index idx 
+      , double dt
+        )
+    { // {{{
+        // The reduction for the next step starts when a node is done with
+        // the current one, so our children may be one step ahead of us.
+        OCTOPUS_ASSERT_MSG(step_ == step || step_ + 1 == step,
+            "cross-timestep communication occurred, octree is ill-formed");
+
+        OCTOPUS_ASSERT(boost::uint64_t(idx) < 8);
+
+        children_dt_deps_[idx].post(dt);
+    } // }}}
+
+    HPX_DEFINE_COMPONENT_ACTION(octree_server,
+                                receive_child_dt,
+                                receive_child_dt_action);
+
+    // Parent -> child broadcast of the timestep.
+    void receive_step_dt(
+        boost::uint64_t step ///< For debugging purposes.
+      , double dt
+        )
+    { // {{{
+        OCTOPUS_ASSERT_MSG(step_ == step,
+            "cross-timestep communication occurred, octree is ill-formed");
+
+        step_dt_dep_.post(dt);
+    } // }}}
+
+    HPX_DEFINE_COMPONENT_ACTION(octree_server,
+                                receive_step_dt,
+                                receive_step_dt_action);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // {{{ Stages of a timestep.
+    // step_kernel runs these in order on a single node. They are public so
+    // that a locality can run each stage over all of its nodes instead of
+    // running one long-lived step_kernel thread per node (see
+    // batched_step.hpp). The ghost zone and injection stages depend on the
+    // same stage having run on other nodes; their _async versions return
+    // without blocking, and the other versions block until they are done.
+    // The other stages only touch this node. phase is the Runge-Kutta sub
+    // step.
+
+    /// Saves the state from the previous timestep.
+    void begin_step_stage();
+
+    hpx::future<void> ghost_zone_stage_async(boost::uint64_t phase);
+
+    void ghost_zone_stage(boost::uint64_t phase)
+    {
+        ghost_zone_stage_async(phase).get();
+    }
+
+    void flux_stage(boost::uint64_t phase);
+
+    hpx::future<void> flux_injection_stage_async(boost::uint64_t phase);
+
+    void flux_injection_stage(boost::uint64_t phase)
+    {
+        flux_injection_stage_async(phase).get();
+    }
+
+    /// \a beta is only used by TVD Runge Kutta.
+    void update_stage(boost::uint64_t phase, double dt, double beta);
+
+    hpx::future<void> state_injection_stage_async(boost::uint64_t phase);
+
+    void state_injection_stage(boost::uint64_t phase)
+    {
+        state_injection_stage_async(phase).get();
+    }
+
+    /// Advances the step counter and time. The final ghost zone exchange
+    /// (ghost_zone_stage(config().runge_kutta_order)), if there is one, must
+    /// come first.
+    void end_step_stage(double dt);
+    // }}}
 
   private:
+    void create_differentials();
+
+    void drop_differentials();
+
+    /// Continuation of the _async stages; the timer is started when the stage
+    /// is, so waiting for other nodes is included.
+    void add_stage_timing(
+        cost_phase p ///< Bound parameter.
+      , hpx::util::high_resolution_timer const& t ///< Bound parameter.
+      , hpx::future<void> stage
+        );
+
     void step_kernel(double dt);
 
+    /// Returns the CFL timestep of the subtree rooted at this node.
+    double step_with_cfl_kernel(double cfl_factor, double max_dt);
+
+    typedef hpx::future<std::vector<hpx::future<double> > >
+        dt_dependencies_future;
+
+    /// 0.) Computes the CFL timestep of this node from max_wave_speed_.
+    /// 1.) Once the CFL timesteps of our children are ready ...
+    /// 2.) ... sends the minimum to our parent.
+    /// 3.) Once the global CFL timestep is received from our parent (or, on
+    ///     the root, once 1.) is done), sends it to our children.
+    ///
+    /// Does not block; the returned future holds the global CFL timestep.
+    hpx::future<double> reduce_cfl_dt_async(
+        double cfl_factor
+        );
+
+    /// Continuation of reduce_cfl_dt_async; returns the CFL timestep of the
+    /// subtree.
+    double combine_cfl_dt(
+        double cfl_dt ///< Bound parameter.
+      , dt_dependencies_future children_dt
+        );
+
+    /// Continuation of reduce_cfl_dt_async, on every node but the root;
+    /// sends the CFL timestep of the subtree to our parent. The returned
+    /// future holds it once our parent has received it.
+    hpx::future<double> push_child_dt(
+        hpx::future<double> subtree_dt
+        );
+
+    /// Continuation of reduce_cfl_dt_async, on the root.
+    hpx::future<double> broadcast_root_dt(
+        hpx::future<double> cfl_dt
+        );
+
+    /// Continuation of reduce_cfl_dt_async, on every other node. The
+    /// dependencies are the global CFL timestep and the CFL timestep of the
+    /// subtree.
+    hpx::future<double> receive_step_dt_callback(
+        dt_dependencies_future dependencies
+        );
+
+    /// Sends \a dt to our children. The returned future holds \a dt once
+    /// they have received it.
+    hpx::future<double> broadcast_step_dt(
+        double dt
+        );
+
+    /// Continuation of push_child_dt and broadcast_step_dt; propagates the
+    /// errors of the receivers and returns \a dt.
+    static double dt_sent(
+        double dt ///< Bound parameter.
+      , hpx::future<void> sends
+        );
+
+  public:
+    ///////////////////////////////////////////////////////////////////////////
+    /// Weight of the new state in sub step \a phase of TVD RK of order
+    /// config().runge_kutta_order (see runge_kutta.hpp).
+    static double runge_kutta_beta(boost::uint64_t phase);
+
+    /// Weight of the previous register in sub step \a phase of low-storage
+    /// RK of order config().runge_kutta_order (see runge_kutta.hpp).
+    static double low_storage_runge_kutta_a(boost::uint64_t phase);
+
+    /// Weight of the register in the update of sub step \a phase of
+    /// low-storage RK of order config().runge_kutta_order (see
+    /// runge_kutta.hpp).
+    static double low_storage_runge_kutta_b(boost::uint64_t phase);
+
+  private:
+    /// The ghost zone width that the reconstruction needs. This is
+    /// science().ghost_zone_length, unless config().wide_halos widened it.
+    static boost::uint64_t stencil_width();
+
+    /// The number of ghost zones (on each side) that sub step \a phase
+    /// updates along with our interior. Always 0 without wide halos.
+    static boost::uint64_t update_extension(boost::uint64_t phase);
+
+    /// Returns false for the sub steps that do not exchange ghost zones with
+    /// other nodes, which only happens with wide halos. \a phase may be
+    /// config().runge_kutta_order (the final exchange).
+    static bool exchanges_ghost_zones(boost::uint64_t phase);
+
     void sub_step_kernel(boost::uint64_t phase, double dt, double beta);
 
-    void add_differentials_kernel(double dt, double beta); 
+    // Ghost zone exchange, flux computation and child -> parent flux
+    // injection; everything in a sub step that does not depend on dt.
+    void sub_step_flux_kernel(boost::uint64_t phase);
+
+    // The update of the state and the child -> parent state injection.
+    void sub_step_update_kernel(boost::uint64_t phase, double dt, double beta);
+
+    void add_differentials_kernel(
+        boost::uint64_t phase
+      , double dt
+      , double beta
+        );
+
+    void add_differentials_low_storage_kernel(boost::uint64_t phase, double dt);
 
     void prepare_differentials_kernel(); 
 
     // Operations on each axis overlap each other.
-    void compute_flux_kernel(boost::uint64_t phase);
+    void compute_flux_kernel(boost::uint64_t phase, flux_scratch& f);
+
+    // Reads from U_, writes to f.FX and max_wave_speed_[x_axis].
+    void compute_x_flux_kernel(boost::uint64_t phase, flux_scratch& f);
 
-    // Reads from U_, writes to FX_.
-    void compute_x_flux_kernel();
+    // Reads from U_, writes to f.FY and max_wave_speed_[y_axis].
+    void compute_y_flux_kernel(boost::uint64_t phase, flux_scratch& f);
 
-    // Reads from U_, writes to FY_.
-    void compute_y_flux_kernel();
+    // Reads from U_, writes to f.FZ and max_wave_speed_[z_axis].
+    void compute_z_flux_kernel(boost::uint64_t phase, flux_scratch& f);
 
-    // Reads from U_, writes to FZ_.
-    void compute_z_flux_kernel();
+    // Subtracts the divergence of the fluxes in f from D and copies the
+    // flux planes of differentials_ out of f.
+    void sum_differentials_kernel(boost::uint64_t phase, flux_scratch const& f);
 
-    void sum_differentials_kernel();
+    // Adds the flow off through our faces to DFO_, after the fluxes of our
+    // children have been injected.
+    void sum_flow_off_kernel();
 
   public:
     ///////////////////////////////////////////////////////////////////////////
@@ -1142,8 +1732,78 @@ struct OCTOPUS_EXPORT octree_server
 
     void propagate_locked(child_index kid, mutex_type::scoped_lock &l);
 
+    /// Makes sure that the node across \a direction on our level will exist
+    /// after the next populate. If local_topology_index() says that a
+    /// coarser node covers that spot, its child on the way there is required
+    /// (which is marked and propagated in turn). Does nothing if the node
+    /// exists or would be outside of the domain.
+    void require_neighbor(
+        std::vector<hpx::future<void> >& markings
+      , array<boost::int64_t, 3> const& direction
+        ) const;
+
+    /// Calls require_neighbor for the edge and corner neighbors of our child
+    /// \a kid that are outside of us.
+    void require_diagonal_neighbors(
+        std::vector<hpx::future<void> >& markings
+      , child_index kid
+        ) const;
+
     void populate_kernel();
 
+    /// Appends an entry for each child that populate_kernel would create.
+    void collect_new_children(
+        std::vector<octree_server*>& parents
+      , std::vector<child_index>& kids
+      , std::vector<octree_init_data>& inits
+      , std::vector<boost::shared_ptr<vector4d<double> > >& parent_octants
+        );
+
+    void adopt_child(
+        child_index kid
+      , hpx::id_type const& gid
+        );
+
+  public:
+    /// \brief Create the new children of every node on this locality, with
+    ///        one creation request per destination locality (see
+    ///        create_octrees) instead of one per child. Used by populate when
+    ///        bulk_child_creation is on.
+    ///
+    /// Remote Operations:   Yes, O(localities).
+    /// Concurrency Control: Locks the octree_registry of this locality
+    ///                      briefly; same as populate otherwise.
+    /// Synchrony Gurantee:  Synchronous.
+    static void populate_local_nodes();
+
+    /// \brief Rebuild the sibling links, nephews and exterior nephews of
+    ///        every node on this locality from local_topology_index(),
+    ///        instead of tying them with actions between the nodes. Used by
+    ///        link when bulk_child_creation is on; the topology index must
+    ///        have been synchronized since the last populate.
+    ///
+    /// Remote Operations:   No.
+    /// Concurrency Control: Locks the octree_registry and the topology_index
+    ///                      of this locality briefly, and mtx_ of each node.
+    /// Synchrony Gurantee:  Synchronous.
+    static void link_local_nodes();
+
+    /// \brief Rebuild the edge and corner links (diagonal_directions_,
+    ///        diagonal_siblings_ and diagonal_nephews_) of every node on this
+    ///        locality from local_topology_index(). Used by refine with wide
+    ///        halos; the topology index must have been synchronized since the
+    ///        last populate.
+    ///
+    /// Remote Operations:   No.
+    /// Concurrency Control: Same as link_local_nodes.
+    /// Synchrony Gurantee:  Synchronous.
+    static void link_local_diagonals();
+
+  private:
+    void link_from_topology_index();
+
+    void link_diagonals();
+
     void link_kernel();
 
     void link_child(
@@ -1274,6 +1934,213 @@ struct OCTOPUS_EXPORT octree_server
     {};
     // }}}
 
+    ///////////////////////////////////////////////////////////////////////////
+    // {{{ Typed variants of apply, apply_leaf, reduce and reduce_zonal.
+    // These are parameterized on the type of the functor instead of taking an
+    // hpx::util::function, so the functor is serialized directly (no type
+    // erasure) and the per-node and per-cell calls can be inlined.
+    // Definitions are out-of-line in octree_apply.hpp, octree_apply_leaf.hpp
+    // and octree_reduce.hpp.
+    template <typename F>
+    void apply_typed(
+        F const& f
+        );
+
+    template <typename F>
+    struct apply_typed_action
+      : hpx::actions::make_action<
+            void (octree_server::*)(F const&)
+          , &octree_server::template apply_typed<F>
+          , apply_typed_action<F>
+        >
+    {};
+
+    template <typename T, typename F>
+    T apply_leaf_typed(
+        F const& f
+        );
+
+    template <typename T, typename F>
+    struct apply_leaf_typed_action
+      : hpx::actions::make_action<
+            T (octree_server::*)(F const&)
+          , &octree_server::template apply_leaf_typed<T, F>
+          , apply_leaf_typed_action<T, F>
+        >
+    {};
+
+  private:
+    template <typename T, typename Reducer>
+    void add_reduce_typed(
+        T& result
+      , Reducer const& reducer
+      , hpx::future<T> value
+        )
+    {
+        T tmp = value.get();
+
+        mutex_type::scoped_lock l(mtx_);
+        result = reducer(result, boost::move(tmp)); 
+    }
+
+  public:
+    // Initial should be an identity.
+    template <typename T, typename F, typename Reducer>
+    T reduce_typed(
+        F const& f
+      , Reducer const& reducer
+      , T const& initial = T()
+        );
+
+    template <typename T, typename F, typename Reducer>
+    struct reduce_typed_action
+      : hpx::actions::make_action<
+            T (octree_server::*)(F const&, Reducer const&, T const&)
+          , &octree_server::template reduce_typed<T, F, Reducer>
+          , reduce_typed_action<T, F, Reducer>
+        >
+    {};
+
+    // Initial should be an identity.
+    template <typename T, typename F, typename Reducer>
+    T reduce_zonal_typed(
+        F const& f
+      , Reducer const& reducer
+      , T const& initial = T()
+        );
+
+    template <typename T, typename F, typename Reducer>
+    struct reduce_zonal_typed_action
+      : hpx::actions::make_action<
+            T (octree_server::*)(F const&, Reducer const&, T const&)
+          , &octree_server::template reduce_zonal_typed<T, F, Reducer>
+          , reduce_zonal_typed_action<T, F, Reducer>
+        >
+    {};
+    // }}}
+
+    ///////////////////////////////////////////////////////////////////////////
+    // {{{ Zonal and leaf variants of apply and reduce.
+    // The zonal forms invoke f(U, i, j, k) on the interior zones of each node,
+    // where U is the octree_server, in parallel (one task per x-plane). 
+    //
+    // The _leaf forms skip everything that is covered by a finer level, so
+    // that every point in the domain is visited exactly once. reduce_leaf
+    // only visits nodes that have no children; apply_zonal_leaf and
+    // reduce_zonal_leaf visit the zones of every node that are not covered by
+    // one of its children. Note that this is unrelated to apply_leaf, which
+    // only runs on the node it is invoked on.
+    //
+    // Definitions are out-of-line in octree_apply.hpp and octree_reduce.hpp.
+    template <typename F>
+    void apply_zonal(
+        F const& f
+        );
+
+    template <typename F>
+    struct apply_zonal_action
+      : hpx::actions::make_action<
+            void (octree_server::*)(F const&)
+          , &octree_server::template apply_zonal<F>
+          , apply_zonal_action<F>
+        >
+    {};
+
+    template <typename F>
+    void apply_zonal_leaf(
+        F const& f
+        );
+
+    template <typename F>
+    struct apply_zonal_leaf_action
+      : hpx::actions::make_action<
+            void (octree_server::*)(F const&)
+          , &octree_server::template apply_zonal_leaf<F>
+          , apply_zonal_leaf_action<F>
+        >
+    {};
+
+    // Initial should be an identity.
+    template <typename T, typename F, typename Reducer>
+    T reduce_leaf(
+        F const& f
+      , Reducer const& reducer
+      , T const& initial = T()
+        );
+
+    template <typename T, typename F, typename Reducer>
+    struct reduce_leaf_action
+      : hpx::actions::make_action<
+            T (octree_server::*)(F const&, Reducer const&, T const&)
+          , &octree_server::template reduce_leaf<T, F, Reducer>
+          , reduce_leaf_action<T, F, Reducer>
+        >
+    {};
+
+    // Initial should be an identity.
+    template <typename T, typename F, typename Reducer>
+    T reduce_zonal_leaf(
+        F const& f
+      , Reducer const& reducer
+      , T const& initial = T()
+        );
+
+    template <typename T, typename F, typename Reducer>
+    struct reduce_zonal_leaf_action
+      : hpx::actions::make_action<
+            T (octree_server::*)(F const&, Reducer const&, T const&)
+          , &octree_server::template reduce_zonal_leaf<T, F, Reducer>
+          , reduce_zonal_leaf_action<T, F, Reducer>
+        >
+    {};
+
+    /// Returns true if interior zone (i, j, k) is covered by one of our
+    /// children.
+    bool zone_is_refined(
+        boost::uint64_t i
+      , boost::uint64_t j
+      , boost::uint64_t k
+        ) const;
+
+    boost::uint64_t number_of_children() const;
+
+  private:
+    // Runs f on the interior zones of x-plane i (skipping refined zones if
+    // leaf_only is true).
+    template <typename F>
+    void apply_zonal_plane_kernel(
+        F const& f
+      , boost::uint64_t i
+      , bool leaf_only
+        );
+
+    // Runs apply_zonal_plane_kernel on every interior x-plane in parallel.
+    template <typename F>
+    void apply_zonal_kernel(
+        F const& f
+      , bool leaf_only
+        );
+
+    template <typename T, typename F, typename Reducer>
+    T reduce_zonal_plane_kernel(
+        F const& f
+      , Reducer const& reducer
+      , T const& initial
+      , boost::uint64_t i
+      , bool leaf_only
+        );
+
+    template <typename T, typename F, typename Reducer>
+    T reduce_zonal_kernel(
+        F const& f
+      , Reducer const& reducer
+      , T const& initial
+      , bool leaf_only
+        );
+
+  public:
+    // }}}
+
     ///////////////////////////////////////////////////////////////////////////
     void slice(
         slice_function const& f
@@ -1286,6 +2153,14 @@ struct OCTOPUS_EXPORT octree_server
                                 slice_action);
 
   private:
+    /// Computes the index of the interior plane perpendicular to \a a that
+    /// contains the coordinate \a eps. Returns false if there is none.
+    bool slice_plane_index(
+        axis a
+      , double eps
+      , boost::uint64_t& index
+        ) const;
+
     void slice_x_kernel(slice_function const& f, double eps);
 
     void slice_y_kernel(slice_function const& f, double eps);
@@ -1318,6 +2193,65 @@ struct OCTOPUS_EXPORT octree_server
                                 slice_leaf,
                                 slice_leaf_action);
 
+    ///////////////////////////////////////////////////////////////////////////
+    /// \brief Call \a f on every interior cell whose center is in the box
+    ///        [\a lower, \a upper], on this node and its descendants. Only
+    ///        the children whose octant intersects the box are visited.
+    ///
+    /// Remote Operations:   Yes, one per child that intersects the box.
+    /// Concurrency Control: None.
+    /// Synchrony Gurantee:  Synchronous.
+    void region(
+        slice_function const& f
+      , array<double, 3> const& lower
+      , array<double, 3> const& upper
+        );
+
+    HPX_DEFINE_COMPONENT_ACTION(octree_server,
+                                region,
+                                region_action);
+
+  private:
+    void region_kernel(
+        slice_function const& f
+      , array<double, 3> const& lower
+      , array<double, 3> const& upper
+        );
+
+  public:
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// \brief Sample the state at each of \a points. Each point is routed
+    ///        down the tree to the finest node that contains it, and the
+    ///        state there is trilinearly interpolated from the cell centers.
+    ///        All the points that go to the same child are sent to it in a
+    ///        single message. Points outside of this node are clamped to its
+    ///        boundary.
+    ///
+    /// Remote Operations:   Yes, one per child that contains a point.
+    /// Concurrency Control: Locks mtx_ while interpolating.
+    /// Synchrony Gurantee:  Synchronous.
+    std::vector<state> probe(
+        std::vector<array<double, 3> > const& points
+        );
+
+    HPX_DEFINE_COMPONENT_ACTION(octree_server,
+                                probe,
+                                probe_action);
+
+  private:
+    /// Returns the child whose octant contains \a point.
+    child_index probe_child(
+        array<double, 3> const& point
+        ) const;
+
+    /// Trilinearly interpolates the state at \a point from our cells. The
+    /// ghost zones are only used if config().final_ghost_zone_exchange is on.
+    state interpolate_state_locked(
+        array<double, 3> const& point
+        ) const;
+
+  public:
     ///////////////////////////////////////////////////////////////////////////
     void save();
 
@@ -1373,10 +2307,13 @@ OCTOPUS_REGISTER_ACTION(get_oid);
 OCTOPUS_REGISTER_ACTION(get_siblings);
 OCTOPUS_REGISTER_ACTION(get_offset);
 OCTOPUS_REGISTER_ACTION(get_location);
+OCTOPUS_REGISTER_ACTION(get_cost);
 
 OCTOPUS_REGISTER_ACTION(receive_ghost_zone);
+OCTOPUS_REGISTER_ACTION(receive_diagonal_ghost_zone);
 OCTOPUS_REGISTER_ACTION(send_ghost_zone);
 OCTOPUS_REGISTER_ACTION(send_interpolated_ghost_zone);
+OCTOPUS_REGISTER_ACTION(exchange_ghost_zones);
 OCTOPUS_REGISTER_ACTION(map_ghost_zone);
 
 OCTOPUS_REGISTER_ACTION(child_to_parent_state_injection);
@@ -1389,6 +2326,10 @@ OCTOPUS_REGISTER_ACTION(apply);
 
 OCTOPUS_REGISTER_ACTION(step);
 OCTOPUS_REGISTER_ACTION(step_recurse);
+OCTOPUS_REGISTER_ACTION(step_with_cfl);
+OCTOPUS_REGISTER_ACTION(step_with_cfl_recurse);
+OCTOPUS_REGISTER_ACTION(receive_child_dt);
+OCTOPUS_REGISTER_ACTION(receive_step_dt);
 
 OCTOPUS_REGISTER_ACTION(copy_and_regrid);
 OCTOPUS_REGISTER_ACTION(refine);
@@ -1400,6 +2341,8 @@ OCTOPUS_REGISTER_ACTION(receive_sibling_refinement_signal);
 
 OCTOPUS_REGISTER_ACTION(slice);
 OCTOPUS_REGISTER_ACTION(slice_leaf);
+OCTOPUS_REGISTER_ACTION(region);
+OCTOPUS_REGISTER_ACTION(probe);
 
 #undef OCTOPUS_REGISTER_ACTION
 
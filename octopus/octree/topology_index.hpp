@@ -0,0 +1,293 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_6BEB9126_7C34_4953_BE3C_3A6520A55316)
+#define OCTOPUS_6BEB9126_7C34_4953_BE3C_3A6520A55316
+
+#include <hpx/include/naming.hpp>
+#include <hpx/lcos/local/mutex.hpp>
+
+#include <octopus/config.hpp>
+#include <octopus/assert.hpp>
+#include <octopus/array.hpp>
+#include <octopus/space_filling_curve.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace octopus
+{
+
+/// One node of the octree, as it is recorded in the topology_index.
+struct topology_entry
+{
+    ///< Morton key of the node at space_filling_curve_max_level resolution.
+    boost::uint64_t key;
+    boost::uint64_t level;
+    array<boost::uint64_t, 3> location;
+
+    ///< The locality that the node lives on.
+    hpx::id_type owner;
+
+    ///< Unmanaged reference to the node.
+    hpx::id_type gid;
+
+    topology_entry()
+      : key(0), level(0), location(), owner(), gid()
+    {}
+
+    topology_entry(
+        boost::uint64_t level_
+      , array<boost::uint64_t, 3> const& location_
+      , hpx::id_type const& owner_
+      , hpx::id_type const& gid_
+        )
+      : key(morton_key(location_, level_, space_filling_curve_max_level))
+      , level(level_)
+      , location(location_)
+      , owner(owner_)
+      , gid(gid_)
+    {}
+
+    /// Sorting by (key, level) puts the entries in depth-first order: a node
+    /// comes before its descendants, which come before the next node on its
+    /// level.
+    friend bool operator<(topology_entry const& a, topology_entry const& b)
+    {
+        if (a.key != b.key)
+            return a.key < b.key;
+        return a.level < b.level;
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        ar & key;
+        ar & level;
+        ar & location;
+        ar & owner;
+        ar & gid;
+    }
+};
+
+/// A linear octree of every node in the simulation: a vector of
+/// topology_entries sorted by (Morton key, level). Every locality keeps a
+/// replica, so any node can find its face, edge and corner neighbors on any
+/// level with O(log(n)) local lookups instead of chains of remote calls
+/// between live nodes.
+///
+/// The replicas are updated in batches. Nodes record themselves as pending on
+/// the locality they are constructed on, and synchronize_topology_index sends
+/// the pending entries of each locality to every other locality in a single
+/// message. Octopus does not currently coarsen, so entries are never removed.
+struct OCTOPUS_EXPORT topology_index : boost::noncopyable
+{
+  private:
+    typedef hpx::lcos::local::mutex mutex_type;
+
+    mutable mutex_type mtx_;
+    std::vector<topology_entry> entries_;
+    std::vector<topology_entry> pending_;
+
+    std::vector<topology_entry>::const_iterator find_locked(
+        boost::uint64_t level
+      , array<boost::uint64_t, 3> const& location
+        ) const
+    { // {{{
+        topology_entry const e(level, location, hpx::invalid_id
+                                              , hpx::invalid_id);
+
+        std::vector<topology_entry>::const_iterator it
+            = std::lower_bound(entries_.begin(), entries_.end(), e);
+
+        if (  it != entries_.end()
+           && it->key == e.key
+           && it->level == e.level)
+            return it;
+
+        return entries_.end();
+    } // }}}
+
+  public:
+    topology_index() : mtx_(), entries_(), pending_() {}
+
+    /// Adds \a entries (which do not need to be sorted) to this replica.
+    /// Entries that are already present are replaced.
+    void insert(std::vector<topology_entry> const& entries)
+    { // {{{
+        std::vector<topology_entry> update(entries);
+        std::stable_sort(update.begin(), update.end());
+
+        mutex_type::scoped_lock l(mtx_);
+
+        std::vector<topology_entry> merged;
+        merged.reserve(entries_.size() + update.size());
+
+        std::vector<topology_entry>::const_iterator a = entries_.begin()
+                                                  , b = update.begin();
+
+        // Merge the two sorted ranges; if a node is in both, or more than
+        // once in the update, the entry that comes last in the update wins.
+        while (a != entries_.end() || b != update.end())
+        {
+            // On ties the old entry goes first, so it is overwritten.
+            topology_entry const& e =
+                (a != entries_.end() && (b == update.end() || !(*b < *a)))
+                ? *a++ : *b++;
+
+            if (  !merged.empty()
+               && !(merged.back() < e) && !(e < merged.back()))
+                merged.back() = e;
+            else
+                merged.push_back(e);
+        }
+
+        entries_.swap(merged);
+    } // }}}
+
+    /// Records a node that was created on this locality and has not been
+    /// sent to the other replicas yet.
+    void add_pending(topology_entry const& e)
+    {
+        mutex_type::scoped_lock l(mtx_);
+        pending_.push_back(e);
+    }
+
+    /// Removes and returns the pending entries of this locality.
+    std::vector<topology_entry> take_pending()
+    {
+        mutex_type::scoped_lock l(mtx_);
+        std::vector<topology_entry> v;
+        v.swap(pending_);
+        return v;
+    }
+
+    /// Returns the node on \a level at \a location, if it exists.
+    boost::optional<topology_entry> find(
+        boost::uint64_t level
+      , array<boost::uint64_t, 3> const& location
+        ) const
+    { // {{{
+        mutex_type::scoped_lock l(mtx_);
+
+        std::vector<topology_entry>::const_iterator it
+            = find_locked(level, location);
+
+        if (it == entries_.end())
+            return boost::optional<topology_entry>();
+
+        return boost::optional<topology_entry>(*it);
+    } // }}}
+
+    /// Returns the finest node that covers the node on \a level at
+    /// \a location: the node itself if it exists, otherwise its closest
+    /// existing ancestor.
+    boost::optional<topology_entry> find_covering(
+        boost::uint64_t level
+      , array<boost::uint64_t, 3> const& location
+        ) const
+    { // {{{
+        mutex_type::scoped_lock l(mtx_);
+
+        for (boost::uint64_t up = 0; up <= level; ++up)
+        {
+            array<boost::uint64_t, 3> loc;
+            loc[0] = location[0] >> up;
+            loc[1] = location[1] >> up;
+            loc[2] = location[2] >> up;
+
+            std::vector<topology_entry>::const_iterator it
+                = find_locked(level - up, loc);
+
+            if (it != entries_.end())
+                return boost::optional<topology_entry>(*it);
+        }
+
+        return boost::optional<topology_entry>();
+    } // }}}
+
+    /// Returns the finest node that covers the neighbor of the node on
+    /// \a level at \a location in the direction \a offset, where each
+    /// component of \a offset is -1, 0 or +1. Face, edge and corner neighbors
+    /// have one, two and three non-zero components. Returns nothing if the
+    /// neighbor would be outside of the domain.
+    boost::optional<topology_entry> find_neighbor(
+        boost::uint64_t level
+      , array<boost::uint64_t, 3> const& location
+      , array<boost::int64_t, 3> const& offset
+        ) const
+    { // {{{
+        boost::int64_t const n = boost::int64_t(1) << level;
+
+        array<boost::uint64_t, 3> loc;
+
+        for (std::size_t a = 0; a < 3; ++a)
+        {
+            OCTOPUS_ASSERT(-1 <= offset[a] && offset[a] <= 1);
+
+            boost::int64_t const x = boost::int64_t(location[a]) + offset[a];
+
+            if (x < 0 || n <= x)
+                return boost::optional<topology_entry>();
+
+            loc[a] = boost::uint64_t(x);
+        }
+
+        return find_covering(level, loc);
+    } // }}}
+
+    /// Returns true if the node on \a level at \a location has any children.
+    bool refined(
+        boost::uint64_t level
+      , array<boost::uint64_t, 3> const& location
+        ) const
+    { // {{{
+        mutex_type::scoped_lock l(mtx_);
+
+        std::vector<topology_entry>::const_iterator it
+            = find_locked(level, location);
+
+        if (it == entries_.end())
+            return false;
+
+        // In depth-first order the descendants of a node come right after it,
+        // and their keys are within the range of the node's key.
+        boost::uint64_t const end = it->key
+            + space_filling_curve_extent(level, space_filling_curve_max_level);
+
+        ++it;
+
+        return it != entries_.end() && it->key < end;
+    } // }}}
+
+    std::size_t size() const
+    {
+        mutex_type::scoped_lock l(mtx_);
+        return entries_.size();
+    }
+};
+
+/// Returns the replica of the topology index on this locality.
+OCTOPUS_EXPORT topology_index& local_topology_index();
+
+/// \brief Send the entries that are pending on each locality to every
+///        locality, so that all the replicas describe every node that has
+///        been created so far.
+///
+/// Remote Operations:   Yes, O(localities^2) messages, one batch each.
+/// Concurrency Control: Locks the topology_index of each locality briefly.
+/// Synchrony Gurantee:  Synchronous.
+OCTOPUS_EXPORT void synchronize_topology_index();
+
+}
+
+#endif // OCTOPUS_6BEB9126_7C34_4953_BE3C_3A6520A55316
+
@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_CE5EE77D_120C_421D_982C_C76B28FBBF50)
+#define OCTOPUS_CE5EE77D_120C_421D_982C_C76B28FBBF50
+
+#include <octopus/assert.hpp>
+
+#include <boost/cstdint.hpp>
+
+namespace octopus
+{
+
+// Coefficients of the Runge Kutta schemes of order 1 to 3. Sub step phase of
+// TVD Runge Kutta (Shu and Osher) computes
+//
+//     U = (U + dt * L(U)) * beta(phase) + U0 * (1 - beta(phase))
+//
+// and sub step phase of low-storage Runge Kutta, which keeps a second
+// register D instead of U0 (Williamson's 2N-storage form), computes
+//
+//     D = D * a(phase) + L(U)
+//     U = U + dt * D * b(phase)
+//
+// with a(0) = 0. Both schemes are strong stability preserving (SSP).
+
+/// Weight of the new state in sub step \a phase of TVD RK of order \a order.
+inline double runge_kutta_beta(boost::uint64_t order, boost::uint64_t phase)
+{ // {{{
+    switch (order)
+    {
+        case 1:
+            return 1.0;
+
+        case 2:
+        {
+            double const beta[] = { 1.0, 0.5 };
+            return beta[phase];
+        }
+
+        case 3:
+        {
+            double const beta[] = { 1.0, 0.25, 2.0 / 3.0 };
+            return beta[phase];
+        }
+
+        default:
+        {
+            OCTOPUS_ASSERT_FMT_MSG(false,
+                "runge-kutta order (%1%) is unsupported or invalid",
+                order);
+        }
+    };
+
+    return 0.0;
+} // }}}
+
+/// Weight of the previous register in sub step \a phase of low-storage RK of
+/// order \a order.
+///
+/// The order 2 scheme is the same as TVD RK2. The order 3 scheme is the
+/// low-storage SSP RK3 of Gottlieb and Shu, "Total variation diminishing
+/// Runge-Kutta schemes", Math. Comp. 67 (1998), rather than Williamson's
+/// (1980) RK3, which is not SSP. Its SSP coefficient is 0.32, against 1 for
+/// TVD RK3; its linear stability region is that of every 3 stage, third
+/// order scheme. The coefficients are only given to 16 digits, so the third
+/// order conditions hold to about 1e-10.
+inline double low_storage_runge_kutta_a(
+    boost::uint64_t order
+  , boost::uint64_t phase
+    )
+{ // {{{
+    switch (order)
+    {
+        case 1:
+            return 0.0;
+
+        case 2:
+        {
+            double const a[] = { 0.0, -1.0 };
+            return a[phase];
+        }
+
+        case 3:
+        {
+            double const a[] =
+                { 0.0, -2.915492524638791, -0.000000093517376 };
+            return a[phase];
+        }
+
+        default:
+        {
+            OCTOPUS_ASSERT_FMT_MSG(false,
+                "runge-kutta order (%1%) is unsupported or invalid",
+                order);
+        }
+    };
+
+    return 0.0;
+} // }}}
+
+/// Weight of the register in the update of sub step \a phase of low-storage
+/// RK of order \a order (see low_storage_runge_kutta_a).
+inline double low_storage_runge_kutta_b(
+    boost::uint64_t order
+  , boost::uint64_t phase
+    )
+{ // {{{
+    switch (order)
+    {
+        case 1:
+            return 1.0;
+
+        case 2:
+        {
+            double const b[] = { 1.0, 0.5 };
+            return b[phase];
+        }
+
+        case 3:
+        {
+            double const b[] =
+                { 0.924574, 0.287713063186156, 0.626538109512740 };
+            return b[phase];
+        }
+
+        default:
+        {
+            OCTOPUS_ASSERT_FMT_MSG(false,
+                "runge-kutta order (%1%) is unsupported or invalid",
+                order);
+        }
+    };
+
+    return 0.0;
+} // }}}
+
+}
+
+#endif // OCTOPUS_CE5EE77D_120C_421D_982C_C76B28FBBF50
+
@@ -17,6 +17,7 @@
 #include <octopus/science/minmod_reconstruction.hpp>
 #include <octopus/science/ppm_reconstruction.hpp>
 #include <octopus/science/initial_dx.hpp>
+#include <octopus/science/space_filling_curve_distribution.hpp>
 
 #include <octopus/science/dt_prediction.hpp>
 
@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_94E01045_138D_472E_9E26_35C37F4AB455)
+#define OCTOPUS_94E01045_138D_472E_9E26_35C37F4AB455
+
+#include <octopus/array.hpp>
+#include <octopus/math.hpp>
+#include <octopus/octree/octree_reduce.hpp>
+
+#include <limits>
+
+namespace octopus
+{
+
+/// CFL timestep of a node with spacing \a dx, given the largest wave speed on
+/// each axis. Returns the largest representable double if nothing moves.
+inline double cfl_dt_from_wave_speeds(
+    double cfl_factor
+  , double dx
+  , array<double, 3> const& max_speed
+    )
+{
+    double const speed = maximum(max_speed[0], max_speed[1], max_speed[2]);
+
+    if (0.0 < speed)
+        return cfl_factor * dx / speed;
+
+    return (std::numeric_limits<double>::max)();
+}
+
+/// Computes the CFL timestep of a single node from the wave speeds recorded by
+/// its flux sweeps (see octree_server::get_max_wave_speed). Nodes that have
+/// not swept since they were created or loaded compute the wave speeds from
+/// their zones instead.
+struct node_cfl_dt_from_flux_sweep
+{
+  private:
+    double cfl_factor_;
+
+  public:
+    node_cfl_dt_from_flux_sweep() : cfl_factor_(0.0) {}
+
+    node_cfl_dt_from_flux_sweep(double cfl_factor) : cfl_factor_(cfl_factor) {}
+
+    double operator()(octree_server& U) const
+    {
+        array<double, 3> speed = U.get_max_wave_speed();
+
+        if (0.0 == maximum(speed[0], speed[1], speed[2]))
+            speed = U.compute_max_wave_speed();
+
+        return cfl_dt_from_wave_speeds(cfl_factor_, U.get_dx(), speed);
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        ar & cfl_factor_;
+    }
+};
+
+/// \brief Computes the CFL timestep of the tree rooted at the given node from
+///        the wave speeds that the flux kernels recorded, instead of
+///        reconstructing every node again.
+///
+/// The wave speeds are the largest of the flux sweeps of the last timestep,
+/// i.e. of the states at the beginning of each of its sub steps, not of the
+/// state at the end of it. Nodes without recorded wave speeds (before the
+/// first timestep, after a checkpoint was loaded, or new children from
+/// refinement) fall back to octree_server::compute_max_wave_speed.
+///
+/// Remote Operations:   Yes.
+/// Concurrency Control: Same as octree_server::reduce_typed.
+/// Synchrony Gurantee:  Synchronous.
+struct cfl_dt_from_flux_sweep
+{
+  private:
+    double cfl_factor_;
+
+  public:
+    cfl_dt_from_flux_sweep() : cfl_factor_(0.0) {}
+
+    cfl_dt_from_flux_sweep(double cfl_factor) : cfl_factor_(cfl_factor) {}
+
+    double operator()(octree_server& root) const
+    {
+        OCTOPUS_ASSERT(0.0 < cfl_factor_);
+
+        return root.reduce_typed<double>
+            ( node_cfl_dt_from_flux_sweep(cfl_factor_)
+            , minimum_functor()
+            , (std::numeric_limits<double>::max)());
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        ar & cfl_factor_;
+    }
+};
+
+}
+
+#endif // OCTOPUS_94E01045_138D_472E_9E26_35C37F4AB455
+
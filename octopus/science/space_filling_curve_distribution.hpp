@@ -0,0 +1,256 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_A0F4E2C6_7B19_4D83_8E55_1C3B9D6F2A47)
+#define OCTOPUS_A0F4E2C6_7B19_4D83_8E55_1C3B9D6F2A47
+
+#include <hpx/runtime/naming/name.hpp>
+
+#include <octopus/octree/octree_init_data.hpp>
+#include <octopus/space_filling_curve.hpp>
+#include <octopus/assert.hpp>
+#include <octopus/array.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace octopus
+{
+
+/// A node as seen by the space-filling-curve distribution policy.
+struct space_filling_curve_node
+{
+    space_filling_curve_node()
+      : level(0)
+      , location()
+      , cost(0.0)
+    {}
+
+    space_filling_curve_node(
+        boost::uint64_t level_
+      , array<boost::uint64_t, 3> const& location_
+      , double cost_ = 0.0
+        )
+      : level(level_)
+      , location(location_)
+      , cost(cost_)
+    {}
+
+    boost::uint64_t           level;
+    array<boost::uint64_t, 3> location;
+
+    /// If this is not positive, the per-level weight is used instead.
+    double                    cost;
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        ar & level;
+        ar & location;
+        ar & cost;
+    }
+};
+
+/// Distribution policy which orders the nodes of the octree along a Morton or
+/// Hilbert curve and assigns each locality a contiguous range of the curve.
+/// Siblings are adjacent on the curve, so they mostly share a locality.
+///
+/// Until partition() has been called, the curve is split into equal-volume
+/// ranges, which are equal-cost ranges if every level is refined uniformly.
+/// partition() takes the actual set of nodes (and either their measured costs
+/// or the per-level weights) and places the splitters so that each locality
+/// gets an equal share of the total cost.
+struct space_filling_curve_distribution
+{
+  private:
+    space_filling_curve curve_;
+
+    /// Cost of a node on level i, used by partition() for nodes without a
+    /// measured cost. Levels past the end of the vector have a weight of 1.
+    std::vector<double> level_weights_;
+
+    /// Keys (at space_filling_curve_max_level resolution) of the first node
+    /// assigned to localities 1 through N - 1. Empty if partition() has not
+    /// been called.
+    std::vector<boost::uint64_t> splitters_;
+
+  public:
+    space_filling_curve_distribution()
+      : curve_(hilbert_curve)
+      , level_weights_()
+      , splitters_()
+    {}
+
+    space_filling_curve_distribution(
+        space_filling_curve curve
+      , std::vector<double> const& level_weights = std::vector<double>()
+        )
+      : curve_(curve)
+      , level_weights_(level_weights)
+      , splitters_()
+    {}
+
+    space_filling_curve curve() const
+    {
+        return curve_;
+    }
+
+    std::vector<double> const& level_weights() const
+    {
+        return level_weights_;
+    }
+
+    std::vector<boost::uint64_t> const& splitters() const
+    {
+        return splitters_;
+    }
+
+    double level_weight(boost::uint64_t level) const
+    {
+        if (level < level_weights_.size())
+            return level_weights_[level];
+        return 1.0;
+    }
+
+    boost::uint64_t key(
+        boost::uint64_t level
+      , array<boost::uint64_t, 3> const& location
+        ) const
+    {
+        OCTOPUS_ASSERT_FMT_MSG(level <= space_filling_curve_max_level,
+            "level (%1%) is too deep for the space-filling curve", level);
+        return space_filling_curve_key(curve_, location, level
+                                     , space_filling_curve_max_level);
+    }
+
+    /// Returns the index of the locality (out of \a n) that owns \a key.
+    boost::uint64_t owner(
+        boost::uint64_t key
+      , boost::uint64_t n
+        ) const
+    { // {{{
+        OCTOPUS_ASSERT(0 < n);
+
+        if (!splitters_.empty())
+        {
+            OCTOPUS_ASSERT_FMT_MSG(splitters_.size() + 1 == n,
+                "partition was computed for %1% localities, not %2%",
+                (splitters_.size() + 1) % n);
+
+            return std::upper_bound(splitters_.begin(), splitters_.end(), key)
+                 - splitters_.begin();
+        }
+
+        // Equal-volume split.
+        boost::uint64_t const total
+            = space_filling_curve_extent(0, space_filling_curve_max_level);
+
+        boost::uint64_t const l
+            = boost::uint64_t(double(key) / double(total) * double(n));
+
+        return (std::min)(l, n - 1);
+    } // }}}
+
+    /// Places the splitters so that each of the \a n localities is assigned an
+    /// equal share of the cost of \a nodes.
+    void partition(
+        std::vector<space_filling_curve_node> nodes
+      , boost::uint64_t n
+        )
+    { // {{{
+        OCTOPUS_ASSERT(0 < n);
+
+        splitters_.clear();
+
+        // Without any nodes, fall back to the equal-volume split.
+        if (1 == n || nodes.empty())
+            return;
+
+        std::vector<std::pair<boost::uint64_t, double> > keyed;
+        keyed.reserve(nodes.size());
+
+        double total = 0.0;
+
+        for (boost::uint64_t i = 0; i < nodes.size(); ++i)
+        {
+            double const cost = (0.0 < nodes[i].cost)
+                              ? nodes[i].cost
+                              : level_weight(nodes[i].level);
+            keyed.push_back(std::make_pair(key(nodes[i].level
+                                             , nodes[i].location)
+                                         , cost));
+            total += cost;
+        }
+
+        // A parent and its first child share a key; the parent goes first.
+        std::stable_sort(keyed.begin(), keyed.end(), key_less());
+
+        splitters_.reserve(n - 1);
+
+        double running = 0.0;
+        boost::uint64_t l = 1;
+
+        for (boost::uint64_t i = 0; i < keyed.size() && l < n; ++i)
+        {
+            // Start a new range when this node's midpoint crosses the next
+            // equal-cost boundary.
+            while (l < n && (running + 0.5 * keyed[i].second)
+                                >= (double(l) / double(n)) * total)
+            {
+                splitters_.push_back(keyed[i].first);
+                ++l;
+            }
+
+            running += keyed[i].second;
+        }
+
+        // Localities with nothing left to own get empty ranges at the end.
+        while (l < n)
+        {
+            splitters_.push_back(~boost::uint64_t(0));
+            ++l;
+        }
+    } // }}}
+
+    hpx::id_type operator()(
+        octree_init_data const& init
+      , std::vector<hpx::id_type> const& localities
+        ) const
+    {
+        OCTOPUS_ASSERT(!localities.empty());
+        return localities[owner(key(init.level, init.location)
+                              , localities.size())];
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        ar & curve_;
+        ar & level_weights_;
+        ar & splitters_;
+    }
+
+  private:
+    struct key_less
+    {
+        bool operator()(
+            std::pair<boost::uint64_t, double> const& a
+          , std::pair<boost::uint64_t, double> const& b
+            ) const
+        {
+            return a.first < b.first;
+        }
+    };
+};
+
+}
+
+#endif // OCTOPUS_A0F4E2C6_7B19_4D83_8E55_1C3B9D6F2A47
+
@@ -0,0 +1,160 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_5C1B7E0A_3D42_4E8F_9A61_2F7D0C84B9E3)
+#define OCTOPUS_5C1B7E0A_3D42_4E8F_9A61_2F7D0C84B9E3
+
+#include <octopus/assert.hpp>
+#include <octopus/array.hpp>
+
+#include <boost/cstdint.hpp>
+
+namespace octopus
+{
+
+/// The deepest level that a space-filling-curve key can describe; 3 bits are
+/// needed per level, so 21 levels fit in a 64-bit key.
+boost::uint64_t const space_filling_curve_max_level = 21;
+
+enum space_filling_curve
+{
+    morton_curve  = 0,
+    hilbert_curve = 1
+};
+
+/// Returns the Morton (Z-order) key of the node at \a location on \a level,
+/// expressed at the resolution of \a max_level. The children of a node occupy
+/// the eight contiguous sub-ranges of their parent's range, so keys from
+/// different levels can be compared directly.
+inline boost::uint64_t morton_key(
+    array<boost::uint64_t, 3> const& location
+  , boost::uint64_t level
+  , boost::uint64_t max_level
+    )
+{ // {{{
+    OCTOPUS_ASSERT(level <= max_level);
+    OCTOPUS_ASSERT(max_level <= space_filling_curve_max_level);
+
+    boost::uint64_t key = 0;
+
+    for (boost::uint64_t b = level; b > 0; --b)
+    {
+        key = (key << 3)
+            | (((location[0] >> (b - 1)) & 1) << 0)
+            | (((location[1] >> (b - 1)) & 1) << 1)
+            | (((location[2] >> (b - 1)) & 1) << 2);
+    }
+
+    return key << (3 * (max_level - level));
+} // }}}
+
+/// Returns the Hilbert key of the node at \a location on \a level, expressed at
+/// the resolution of \a max_level. Uses Skilling's transpose algorithm on the
+/// first descendant of the node at \a max_level and then masks off the bits
+/// below \a level; for a fixed-order Hilbert curve the top 3 * \a level bits
+/// identify the octant, so this is well defined.
+inline boost::uint64_t hilbert_key(
+    array<boost::uint64_t, 3> const& location
+  , boost::uint64_t level
+  , boost::uint64_t max_level
+    )
+{ // {{{
+    OCTOPUS_ASSERT(level <= max_level);
+    OCTOPUS_ASSERT(max_level <= space_filling_curve_max_level);
+
+    if (0 == max_level)
+        return 0;
+
+    boost::uint64_t const shift = max_level - level;
+
+    boost::uint64_t X[3] = { location[0] << shift
+                           , location[1] << shift
+                           , location[2] << shift };
+
+    boost::uint64_t const M = boost::uint64_t(1) << (max_level - 1);
+
+    // Inverse undo.
+    for (boost::uint64_t Q = M; Q > 1; Q >>= 1)
+    {
+        boost::uint64_t const P = Q - 1;
+
+        for (boost::uint64_t i = 0; i < 3; ++i)
+        {
+            if (X[i] & Q)
+                X[0] ^= P;
+            else
+            {
+                boost::uint64_t const t = (X[0] ^ X[i]) & P;
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+        }
+    }
+
+    // Gray encode.
+    X[1] ^= X[0];
+    X[2] ^= X[1];
+
+    boost::uint64_t t = 0;
+
+    for (boost::uint64_t Q = M; Q > 1; Q >>= 1)
+        if (X[2] & Q)
+            t ^= Q - 1;
+
+    for (boost::uint64_t i = 0; i < 3; ++i)
+        X[i] ^= t;
+
+    boost::uint64_t key = 0;
+
+    for (boost::uint64_t b = max_level; b > 0; --b)
+    {
+        key = (key << 3)
+            | (((X[0] >> (b - 1)) & 1) << 2)
+            | (((X[1] >> (b - 1)) & 1) << 1)
+            | (((X[2] >> (b - 1)) & 1) << 0);
+    }
+
+    // Drop the bits that describe positions below our level.
+    return (key >> (3 * shift)) << (3 * shift);
+} // }}}
+
+inline boost::uint64_t space_filling_curve_key(
+    space_filling_curve curve
+  , array<boost::uint64_t, 3> const& location
+  , boost::uint64_t level
+  , boost::uint64_t max_level
+    )
+{ // {{{
+    switch (curve)
+    {
+        case morton_curve:
+            return morton_key(location, level, max_level);
+        case hilbert_curve:
+            return hilbert_key(location, level, max_level);
+        default:
+            break;
+    }
+
+    OCTOPUS_ASSERT_MSG(false, "invalid space-filling curve");
+    return 0;
+} // }}}
+
+/// Returns the number of keys (at the resolution of \a max_level) covered by a
+/// node on \a level.
+inline boost::uint64_t space_filling_curve_extent(
+    boost::uint64_t level
+  , boost::uint64_t max_level
+    )
+{
+    OCTOPUS_ASSERT(level <= max_level);
+    return boost::uint64_t(1) << (3 * (max_level - level));
+}
+
+}
+
+#endif // OCTOPUS_5C1B7E0A_3D42_4E8F_9A61_2F7D0C84B9E3
+
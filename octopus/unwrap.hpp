@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(OCTOPUS_E2B1430B_AF9E_4873_9CDF_10314F1262AE)
+#define OCTOPUS_E2B1430B_AF9E_4873_9CDF_10314F1262AE
+
+#include <hpx/lcos/future.hpp>
+#include <hpx/lcos/local/promise.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace octopus
+{
+
+namespace detail
+{
+
+/// Moves the result (or error) of the inner future into the promise.
+template <typename T>
+struct forward_unwrapped
+{
+    static void call(
+        boost::shared_ptr<hpx::lcos::local::promise<T> > p
+      , hpx::future<T> f
+        )
+    {
+        try
+        {
+            p->set_value(f.move());
+        }
+
+        catch (...)
+        {
+            p->set_exception(boost::current_exception());
+        }
+    }
+};
+
+template <>
+struct forward_unwrapped<void>
+{
+    static void call(
+        boost::shared_ptr<hpx::lcos::local::promise<void> > p
+      , hpx::future<void> f
+        )
+    {
+        try
+        {
+            f.move();
+        }
+
+        catch (...)
+        {
+            p->set_exception(boost::current_exception());
+            return;
+        }
+
+        p->set_value();
+    }
+};
+
+/// Attaches forward_unwrapped to the inner future once the outer one is
+/// ready.
+template <typename T>
+void forward_outer(
+    boost::shared_ptr<hpx::lcos::local::promise<T> > p
+  , hpx::future<hpx::future<T> > f
+    )
+{
+    try
+    {
+        f.move().then(boost::bind(&forward_unwrapped<T>::call, p, _1));
+    }
+
+    catch (...)
+    {
+        p->set_exception(boost::current_exception());
+    }
+}
+
+}
+
+/// \brief Returns a future which becomes ready with the result (or the error)
+///        of the future that \a f becomes ready with.
+///
+/// Continuations that start more asynchronous work (e.g. the sends of a
+/// stage) return a future; this lets their caller wait for that work without
+/// a continuation blocking on it.
+///
+/// Remote Operations:   No.
+/// Concurrency Control: None.
+/// Synchrony Gurantee:  Asynchronous.
+template <typename T>
+hpx::future<T> unwrap(
+    hpx::future<hpx::future<T> > f
+    )
+{ // {{{
+    boost::shared_ptr<hpx::lcos::local::promise<T> > p
+        = boost::make_shared<hpx::lcos::local::promise<T> >();
+
+    hpx::future<T> result = p->get_future();
+
+    f.then(boost::bind(&detail::forward_outer<T>, p, _1));
+
+    return result;
+} // }}}
+
+}
+
+#endif // OCTOPUS_E2B1430B_AF9E_4873_9CDF_10314F1262AE
+
@@ -10,6 +10,7 @@
 
 #include <octopus/assert.hpp>
 #include <octopus/array.hpp>
+#include <octopus/buffer_pool.hpp>
 
 #include <boost/move/move.hpp>
 #include <boost/serialization/vector.hpp>
@@ -29,7 +30,11 @@ struct vector4d
     size_type x_length_;
     size_type y_length_;
     size_type z_length_;
-    std::vector<T> data_;
+
+    // Ghost zones, child state and child fluxes are vector4ds that are
+    // allocated (and deserialized into) every sub step; the pool recycles
+    // their storage.
+    std::vector<T, pooled_allocator<T> > data_;
 
     BOOST_COPYABLE_AND_MOVABLE(vector4d);
 
@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#include <octopus/buffer_pool.hpp>
+
+namespace octopus
+{
+
+void* buffer_pool::allocate(std::size_t bytes)
+{ // {{{
+    std::size_t const c = size_class_of(bytes);
+
+    if (number_of_size_classes == c)
+        return ::operator new(bytes);
+
+    {
+        mutex_type::scoped_lock l(classes_[c].mtx);
+
+        if (!classes_[c].free.empty())
+        {
+            void* p = classes_[c].free.back();
+            classes_[c].free.pop_back();
+            ++classes_[c].hits;
+            return p;
+        }
+
+        ++classes_[c].misses;
+    }
+
+    return ::operator new(block_size(c));
+} // }}}
+
+void buffer_pool::deallocate(void* p, std::size_t bytes)
+{ // {{{
+    if (0 == p)
+        return;
+
+    std::size_t const c = size_class_of(bytes);
+
+    if (number_of_size_classes != c)
+    {
+        mutex_type::scoped_lock l(classes_[c].mtx);
+
+        if (classes_[c].free.size() < max_free_blocks)
+        {
+            classes_[c].free.push_back(p);
+            return;
+        }
+    }
+
+    ::operator delete(p);
+} // }}}
+
+void buffer_pool::trim()
+{ // {{{
+    for (std::size_t c = 0; c < number_of_size_classes; ++c)
+    {
+        std::vector<void*> blocks;
+
+        {
+            mutex_type::scoped_lock l(classes_[c].mtx);
+            blocks.swap(classes_[c].free);
+        }
+
+        for (std::size_t i = 0; i < blocks.size(); ++i)
+            ::operator delete(blocks[i]);
+    }
+} // }}}
+
+std::size_t buffer_pool::free_bytes()
+{ // {{{
+    std::size_t bytes = 0;
+
+    for (std::size_t c = 0; c < number_of_size_classes; ++c)
+    {
+        mutex_type::scoped_lock l(classes_[c].mtx);
+        bytes += classes_[c].free.size() * block_size(c);
+    }
+
+    return bytes;
+} // }}}
+
+boost::uint64_t buffer_pool::hits()
+{ // {{{
+    boost::uint64_t n = 0;
+
+    for (std::size_t c = 0; c < number_of_size_classes; ++c)
+    {
+        mutex_type::scoped_lock l(classes_[c].mtx);
+        n += classes_[c].hits;
+    }
+
+    return n;
+} // }}}
+
+boost::uint64_t buffer_pool::misses()
+{ // {{{
+    boost::uint64_t n = 0;
+
+    for (std::size_t c = 0; c < number_of_size_classes; ++c)
+    {
+        mutex_type::scoped_lock l(classes_[c].mtx);
+        n += classes_[c].misses;
+    }
+
+    return n;
+} // }}}
+
+buffer_pool& local_buffer_pool()
+{
+    // Leaked on purpose; see the header.
+    static buffer_pool* pool = new buffer_pool;
+    return *pool;
+}
+
+}
@@ -134,6 +134,32 @@ int hpx_main(variables_map& vm)
         if (define_p.first)
             (*define_p.first)(vm, octopus::science());
 
+        // Widen the ghost zones once the problem has picked its
+        // reconstruction. Everything else is laid out from grid_node_length
+        // and ghost_zone_length, so the interior keeps its size.
+        if (octopus::config().wide_halos)
+        {
+            boost::uint64_t const bw = octopus::science().ghost_zone_length;
+            boost::uint64_t const interior
+                = octopus::config().grid_node_length - 2 * bw;
+            boost::uint64_t const halo
+                = octopus::config().runge_kutta_order * bw;
+
+            // A ghost zone only reaches into the interior of our neighbors.
+            OCTOPUS_ASSERT_FMT_MSG(halo <= interior,
+                "wide halos (%1% zones) are wider than the interior of a "
+                "grid node (%2% zones)",
+                halo % interior);
+
+            octopus::config().grid_node_length = interior + 2 * halo;
+            octopus::science().ghost_zone_length = halo;
+
+            std::cout << "Using wide halos: ghost_zone_length = " << halo
+                      << ", grid_node_length = " << (interior + 2 * halo)
+                      << "\n"
+                      << "\n";
+        }
+
         ///////////////////////////////////////////////////////////////////////
         // Create an engine on every locality.
         std::cout << "Creating system components...\n";
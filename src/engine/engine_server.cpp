@@ -13,6 +13,53 @@
 #include <octopus/trivial_serialization.hpp>
 #include <octopus/science.hpp>
 
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/shared_ptr.hpp>
+
+#include <map>
+
+namespace octopus
+{
+
+/// Creates the octree_servers described by \a inits and \a parent_octants on
+/// this locality.
+std::vector<hpx::id_type> create_octrees_here(
+    std::vector<octree_init_data> const& inits
+  , std::vector<boost::shared_ptr<vector4d<double> > > const& parent_octants
+    )
+{
+    OCTOPUS_ASSERT(inits.size() == parent_octants.size());
+
+    using hpx::components::stubs::runtime_support;
+
+    hpx::id_type const here = hpx::find_here();
+
+    std::vector<hpx::future<hpx::id_type> > creations;
+    creations.reserve(inits.size());
+
+    for (std::size_t i = 0; i < inits.size(); ++i)
+    {
+        // Roots are created by octree_client::create_root, which makes sure
+        // that there is only one.
+        OCTOPUS_ASSERT(0 != inits[i].level);
+
+        creations.push_back(runtime_support::create_component_async
+            <octopus::octree_server>(here, inits[i], parent_octants[i]));
+    }
+
+    std::vector<hpx::id_type> gids;
+    gids.reserve(creations.size());
+
+    for (std::size_t i = 0; i < creations.size(); ++i)
+        gids.push_back(creations[i].get());
+
+    return gids;
+}
+
+}
+
+HPX_PLAIN_ACTION(octopus::create_octrees_here, create_octrees_here_action);
+
 namespace octopus
 {
 
@@ -25,7 +72,6 @@ engine_server::engine_server(
     )
   : config_(config)
   , science_(science) 
-  , round_robin_(0)
   , localities_(localities)
   , checkpoint_file_()
 {
@@ -37,7 +83,7 @@ engine_server::engine_server(
 
 hpx::future<hpx::id_type> engine_server::create_octree_async(
     octree_init_data const& init
-  , boost::shared_ptr<vector4d<double> > const& parent_U
+  , boost::shared_ptr<vector4d<double> > const& parent_octant
     )
 {
     OCTOPUS_ASSERT_MSG(!localities_.empty(),
@@ -48,7 +94,64 @@ hpx::future<hpx::id_type> engine_server::create_octree_async(
     hpx::id_type locality = science().distribute(init, localities_);
 
     return runtime_support::create_component_async<octopus::octree_server>
-        (locality, init, parent_U);
+        (locality, init, parent_octant);
+}
+
+std::vector<hpx::id_type> engine_server::create_octrees(
+    std::vector<octree_init_data> const& inits
+  , std::vector<boost::shared_ptr<vector4d<double> > > const& parent_octants
+    )
+{
+    OCTOPUS_ASSERT_MSG(!localities_.empty(),
+                       "no localities supporting Octopus available");
+    OCTOPUS_ASSERT(inits.size() == parent_octants.size());
+
+    // Group the nodes by the locality that they are placed on.
+    std::map<hpx::id_type, std::vector<std::size_t> > groups;
+
+    for (std::size_t i = 0; i < inits.size(); ++i)
+        groups[science().distribute(inits[i], localities_)].push_back(i);
+
+    typedef std::map<hpx::id_type, std::vector<std::size_t> >::const_iterator
+        iterator;
+
+    std::vector<hpx::future<std::vector<hpx::id_type> > > creations;
+    creations.reserve(groups.size());
+
+    for (iterator it = groups.begin(); it != groups.end(); ++it)
+    {
+        std::vector<octree_init_data> group_inits;
+        std::vector<boost::shared_ptr<vector4d<double> > > group_octants;
+
+        group_inits.reserve(it->second.size());
+        group_octants.reserve(it->second.size());
+
+        for (std::size_t j = 0; j < it->second.size(); ++j)
+        {
+            group_inits.push_back(inits[it->second[j]]);
+            group_octants.push_back(parent_octants[it->second[j]]);
+        }
+
+        creations.push_back(hpx::async<create_octrees_here_action>
+            (it->first, group_inits, group_octants));
+    }
+
+    // Scatter the results back into the order of the requests.
+    std::vector<hpx::id_type> gids(inits.size());
+
+    std::size_t g = 0;
+
+    for (iterator it = groups.begin(); it != groups.end(); ++it, ++g)
+    {
+        std::vector<hpx::id_type> const group_gids = creations[g].get();
+
+        OCTOPUS_ASSERT(group_gids.size() == it->second.size());
+
+        for (std::size_t j = 0; j < group_gids.size(); ++j)
+            gids[it->second[j]] = group_gids[j];
+    }
+
+    return gids;
 }
 
 void engine_server::open_checkpoint(
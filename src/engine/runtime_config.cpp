@@ -69,6 +69,7 @@ std::ostream& operator<<(
         << OCTOPUS_FORMAT_OPTION(levels_of_refinement) << "\n"
 
         << OCTOPUS_FORMAT_OPTION(runge_kutta_order) << "\n"
+        << OCTOPUS_FORMAT_OPTION(low_storage_runge_kutta) << "\n"
         << OCTOPUS_FORMAT_OPTION(reflect_on_z) << "\n"
 
         << OCTOPUS_FORMAT_OPTION(spatial_domain) << "\n"
@@ -80,7 +81,17 @@ std::ostream& operator<<(
         << OCTOPUS_FORMAT_OPTION(output_frequency) << "\n"
 
         << OCTOPUS_FORMAT_OPTION(checkpoint_file) << "\n"
-        << OCTOPUS_FORMAT_OPTION(load_checkpoint)
+        << OCTOPUS_FORMAT_OPTION(load_checkpoint) << "\n"
+
+        << OCTOPUS_FORMAT_OPTION(cost_window) << "\n"
+        << OCTOPUS_FORMAT_OPTION(rebalance_on_refine) << "\n"
+        << OCTOPUS_FORMAT_OPTION(batched_stepping) << "\n"
+        << OCTOPUS_FORMAT_OPTION(final_ghost_zone_exchange) << "\n"
+        << OCTOPUS_FORMAT_OPTION(wide_halos) << "\n"
+        << OCTOPUS_FORMAT_OPTION(bulk_child_creation) << "\n"
+
+        << OCTOPUS_FORMAT_OPTION(asynchronous_output) << "\n"
+        << OCTOPUS_FORMAT_OPTION(output_queue_length)
     ;
 
     #undef OCTOPUS_FORMAT_OPTION
@@ -100,6 +111,7 @@ config_data config_from_ini()
         ("levels_of_refinement", cfg.levels_of_refinement, 3) 
 
         ("runge_kutta_order", cfg.runge_kutta_order, 3) 
+        ("low_storage_runge_kutta", cfg.low_storage_runge_kutta, false)
         ("reflect_on_z", cfg.reflect_on_z, false) 
 
         ("spatial_domain", cfg.spatial_domain, 1.5) 
@@ -113,6 +125,16 @@ config_data config_from_ini()
 
         ("checkpoint_file", cfg.checkpoint_file, "checkpoint_L%06u.bin")
         ("load_checkpoint", cfg.load_checkpoint, false)
+
+        ("cost_window", cfg.cost_window, 16)
+        ("rebalance_on_refine", cfg.rebalance_on_refine, false)
+        ("batched_stepping", cfg.batched_stepping, false)
+        ("final_ghost_zone_exchange", cfg.final_ghost_zone_exchange, true)
+        ("wide_halos", cfg.wide_halos, false)
+        ("bulk_child_creation", cfg.bulk_child_creation, false)
+
+        ("asynchronous_output", cfg.asynchronous_output, false)
+        ("output_queue_length", cfg.output_queue_length, 256)
     ;
 
     return cfg;
@@ -59,64 +59,6 @@ void fstream_writer::stop_write()
         file_.close();
 }
 
-void fstream_perform_start_write(
-    boost::uint64_t step
-  , double time
-    )
-{
-    science().output.cast<fstream_writer>()->start_write(step, time);
-}
-
-void fstream_perform_stop_write()
-{
-    science().output.cast<fstream_writer>()->stop_write();
-}
-
-}
-
-HPX_PLAIN_ACTION(octopus::fstream_perform_start_write
-               , fstream_perform_start_write_action);
-HPX_PLAIN_ACTION(octopus::fstream_perform_stop_write
-               , fstream_perform_stop_write_action);
-
-namespace octopus
-{
-
-void fstream_writer::begin_epoch(
-    octree_server& e
-  , double time
-    )
-{
-    std::vector<hpx::id_type> const& targets = localities();
-
-    std::vector<hpx::future<void> > futures;
-    futures.reserve(targets.size());
-
-    fstream_perform_start_write_action act;
-
-    for (boost::uint64_t i = 0; i < targets.size(); ++i)
-    {
-        futures.emplace_back(hpx::async(act, targets[i], e.get_step(), time));
-    }
-
-    hpx::wait(futures);
-}
-
-void fstream_writer::end_epoch(octree_server& e)
-{
-    std::vector<hpx::id_type> const& targets = localities();
-
-    std::vector<hpx::future<void> > futures;
-    futures.reserve(targets.size());
-
-    fstream_perform_stop_write_action act;
-
-    for (boost::uint64_t i = 0; i < targets.size(); ++i)
-        futures.push_back(hpx::async(act, targets[i]));
-
-    hpx::wait(futures);
-}
-
 void fstream_writer::operator()(octree_server& e)
 {
     mutex_type::scoped_lock l(mtx_);
@@ -0,0 +1,248 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#include <hpx/runtime/threads/thread_helpers.hpp>
+
+#include <octopus/io/io_pipeline.hpp>
+#include <octopus/octree/octree_server.hpp>
+#include <octopus/engine/engine_interface.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/format.hpp>
+
+#include <iostream>
+
+namespace octopus
+{
+
+node_snapshot take_node_snapshot(octree_server& e)
+{ // {{{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+    boost::uint64_t const n = gnx - 2 * bw;
+
+    node_snapshot s;
+
+    s.level    = e.get_level();
+    s.location = e.get_location();
+    s.step     = e.get_step();
+    s.time     = e.get_time();
+    s.dx       = e.get_dx();
+
+    s.x_faces.reserve(n + 1);
+    s.y_faces.reserve(n + 1);
+    s.z_faces.reserve(n + 1);
+
+    for (boost::uint64_t i = bw; i < (gnx - bw + 1); ++i)
+    {
+        s.x_faces.push_back(e.x_face(i));
+        s.y_faces.push_back(e.y_face(i));
+        s.z_faces.push_back(e.z_face(i));
+    }
+
+    s.U.reset(new vector4d<double>(n));
+
+    for (boost::uint64_t i = bw; i < (gnx - bw); ++i)
+        for (boost::uint64_t j = bw; j < (gnx - bw); ++j)
+            for (boost::uint64_t k = bw; k < (gnx - bw); ++k)
+                (*s.U)(i - bw, j - bw, k - bw) = e(i, j, k);
+
+    return s;
+} // }}}
+
+io_pipeline::io_pipeline(std::size_t capacity)
+  : mtx_()
+  , not_empty_()
+  , not_full_()
+  , idle_()
+  , queue_()
+  , capacity_(capacity)
+  , busy_(false)
+  , stopping_(false)
+  , thread_()
+  , submitted_(0)
+  , completed_(0)
+  , backpressure_stalls_(0)
+  , max_queue_depth_(0)
+  , error_()
+{
+    OCTOPUS_ASSERT(0 < capacity_);
+}
+
+io_pipeline::~io_pipeline()
+{
+    {
+        boost::mutex::scoped_lock l(mtx_);
+        stopping_ = true;
+    }
+
+    not_empty_.notify_all();
+
+    if (thread_)
+        thread_->join();
+}
+
+void io_pipeline::run()
+{ // {{{
+    boost::mutex::scoped_lock l(mtx_);
+
+    while (true)
+    {
+        while (queue_.empty() && !stopping_)
+            not_empty_.wait(l);
+
+        // The queue is finished before the thread exits.
+        if (queue_.empty())
+            return;
+
+        job j = queue_.front();
+        queue_.pop_front();
+        busy_ = true;
+
+        not_full_.notify_all();
+
+        boost::exception_ptr error;
+
+        {
+            l.unlock();
+
+            try
+            {
+                j();
+            }
+
+            catch (...)
+            {
+                error = boost::current_exception();
+            }
+
+            l.lock();
+        }
+
+        // Keep the first error until somebody sees it.
+        if (error && !error_)
+            error_ = error;
+
+        busy_ = false;
+        ++completed_;
+
+        if (queue_.empty())
+            idle_.notify_all();
+    }
+} // }}}
+
+void io_pipeline::rethrow_locked(boost::mutex::scoped_lock& l)
+{
+    OCTOPUS_ASSERT(l.owns_lock());
+
+    if (!error_)
+        return;
+
+    boost::exception_ptr error;
+    error.swap(error_);
+
+    boost::rethrow_exception(error);
+}
+
+void io_pipeline::submit(job const& j)
+{ // {{{
+    bool const hpx_thread = (0 != hpx::threads::get_self_ptr());
+
+    boost::mutex::scoped_lock l(mtx_);
+
+    rethrow_locked(l);
+
+    if (!thread_)
+        thread_.reset(new boost::thread(boost::bind(&io_pipeline::run, this)));
+
+    if (queue_.size() >= capacity_)
+    {
+        ++backpressure_stalls_;
+
+        while (queue_.size() >= capacity_)
+        {
+            // Don't block the worker OS-thread that we are running on if we
+            // are an HPX thread.
+            if (hpx_thread)
+            {
+                l.unlock();
+                hpx::this_thread::suspend(boost::posix_time::milliseconds(1));
+                l.lock();
+            }
+
+            else
+                not_full_.wait(l);
+        }
+    }
+
+    queue_.push_back(j);
+    ++submitted_;
+
+    if (queue_.size() > max_queue_depth_)
+        max_queue_depth_ = queue_.size();
+
+    not_empty_.notify_one();
+} // }}}
+
+void io_pipeline::drain()
+{ // {{{
+    bool const hpx_thread = (0 != hpx::threads::get_self_ptr());
+
+    boost::mutex::scoped_lock l(mtx_);
+
+    while (!queue_.empty() || busy_)
+    {
+        if (hpx_thread)
+        {
+            l.unlock();
+            hpx::this_thread::suspend(boost::posix_time::milliseconds(1));
+            l.lock();
+        }
+
+        else
+            idle_.wait(l);
+    }
+
+    rethrow_locked(l);
+} // }}}
+
+void io_pipeline::drain_and_report()
+{
+    try
+    {
+        drain();
+    }
+
+    catch (...)
+    {
+        std::cerr << "io_pipeline: an I/O job failed: "
+                  << boost::current_exception_diagnostic_information()
+                  << "\n";
+    }
+}
+
+void io_pipeline::report(std::ostream& os) const
+{
+    boost::mutex::scoped_lock l(mtx_);
+
+    os << ( boost::format("%u jobs, queue depth %u of %u at most, "
+                          "%u backpressure stalls")
+          % completed_
+          % max_queue_depth_
+          % capacity_
+          % backpressure_stalls_);
+}
+
+io_pipeline& local_io_pipeline()
+{
+    static io_pipeline pipeline(config().output_queue_length);
+    return pipeline;
+}
+
+}
+
@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#include <octopus/io/probe.hpp>
+
+#include <boost/format.hpp>
+
+namespace octopus
+{
+
+probe_series::probe_series(
+    std::vector<array<double, 3> > const& points
+  , std::string const& file_name
+    )
+  : points_(points)
+  , file_()
+{
+    file_.open(file_name.c_str(), std::ofstream::out | std::ofstream::trunc);
+
+    OCTOPUS_ASSERT_FMT_MSG(file_.is_open(),
+        "couldn't open probe file, file(%1%)", file_name);
+
+    file_ << "# step, time";
+
+    for (std::size_t p = 0; p < points_.size(); ++p)
+        file_ << ( boost::format(", probe %u at (%.6e, %.6e, %.6e) [%u fields]")
+                 % p % points_[p][0] % points_[p][1] % points_[p][2]
+                 % OCTOPUS_STATE_SIZE);
+
+    file_ << "\n";
+}
+
+void probe_series::write(
+    boost::uint64_t step
+  , double time
+  , std::vector<state> const& samples
+    )
+{
+    OCTOPUS_ASSERT(samples.size() == points_.size());
+
+    file_ << (boost::format("%u %.9e") % step % time);
+
+    for (std::size_t p = 0; p < samples.size(); ++p)
+        for (std::size_t f = 0; f < samples[p].size(); ++f)
+            file_ << (boost::format(" %.9e") % samples[p][f]);
+
+    file_ << "\n";
+
+    // Keep the series readable while the run is in progress.
+    file_.flush();
+}
+
+void probe_series::operator()(octree_server& root)
+{
+    write(root.get_step(), root.get_time(), root.probe(points_));
+}
+
+}
+
@@ -17,21 +17,42 @@
 #include <boost/smart_ptr/scoped_array.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
 
+#include <algorithm>
 #include <cmath>
 
 namespace octopus
 {
 
-void single_variable_silo_writer::start_write_locked(
+silo_writer::~silo_writer()
+{
+    // Make sure the I/O thread is done with us.
+    if (config().asynchronous_output)
+        local_io_pipeline().drain_and_report();
+
+    mutex_type::scoped_lock l(mtx_);
+    merge_locked(l);
+    stop_write_locked(l);
+}
+
+void silo_writer::start_write_locked(
     boost::uint64_t step
   , double time
   , mutex_type::scoped_lock& l
     )
 {
     OCTOPUS_ASSERT(l.owns_lock());
+    start_write_unlocked(step, time, hpx::get_locality_id(), false);
+}
 
+void silo_writer::start_write_unlocked(
+    boost::uint64_t step
+  , double time
+  , boost::uint32_t locality_id
+  , bool io_thread
+    )
+{
     // Make sure we closed the last epoch.
-    stop_write_locked(l);
+    stop_write_unlocked(io_thread);
 
     step_ = step;
     time_ = time; 
@@ -39,7 +60,7 @@ void single_variable_silo_writer::start_write_locked(
     try
     {
         std::string s = boost::str( boost::format(file_name_)
-                                  % hpx::get_locality_id() % step_);
+                                  % locality_id % step_);
         file_ = DBCreate(s.c_str(), DB_CLOBBER, DB_LOCAL, NULL, DB_PDB);
     }
     // FIXME: Catch the specific boost.format exception.
@@ -48,7 +69,7 @@ void single_variable_silo_writer::start_write_locked(
         try
         {
             std::string s = boost::str( boost::format(file_name_)
-                                      % hpx::get_locality_id());
+                                      % locality_id);
             file_ = DBCreate(s.c_str(), DB_CLOBBER, DB_LOCAL, NULL, DB_PDB);
         }
         // FIXME: Catch the specific boost.format exception.
@@ -73,11 +94,15 @@ void single_variable_silo_writer::start_write_locked(
     }
 }
 
-void single_variable_silo_writer::stop_write_locked(mutex_type::scoped_lock& l)
+void silo_writer::stop_write_locked(mutex_type::scoped_lock& l)
 {
     OCTOPUS_ASSERT(l.owns_lock());
+    stop_write_unlocked(false);
+}
 
-    merge_locked(l);
+void silo_writer::stop_write_unlocked(bool io_thread)
+{
+    merge_unlocked(io_thread);
 
     if (file_)
     {
@@ -89,72 +114,41 @@ void single_variable_silo_writer::stop_write_locked(mutex_type::scoped_lock& l)
     merged_ = false;
 }
 
-void silo_perform_start_write(
+void silo_writer::start_write(
     boost::uint64_t step
   , double time
     )
 {
-    science().output.cast<single_variable_silo_writer>()->start_write
-        (step, time);
-}
-
-void silo_perform_stop_write()
-{
-    science().output.cast<single_variable_silo_writer>()->stop_write();
-}
-
-}
-
-HPX_PLAIN_ACTION(octopus::silo_perform_start_write
-               , silo_perform_start_write_action);
-HPX_ACTION_USES_MEDIUM_STACK(silo_perform_start_write_action);
-HPX_PLAIN_ACTION(octopus::silo_perform_stop_write
-               , silo_perform_stop_write_action);
-HPX_ACTION_USES_MEDIUM_STACK(silo_perform_stop_write_action);
-
-namespace octopus
-{
-
-void single_variable_silo_writer::begin_epoch(
-    octree_server& e
-  , double time
-    )
-{
-    std::vector<hpx::id_type> const& targets = localities();
-
-    std::vector<hpx::future<void> > futures;
-    futures.reserve(targets.size());
-
-    silo_perform_start_write_action act;
-
-    for (boost::uint64_t i = 0; i < targets.size(); ++i)
+    if (config().asynchronous_output)
     {
-        futures.emplace_back(hpx::async(act, targets[i], e.get_step(), time));
+        local_io_pipeline().submit(
+            boost::bind(&silo_writer::start_write_unlocked
+                      , this, step, time, hpx::get_locality_id(), true));
+        return;
     }
 
-    hpx::wait(futures);
+    mutex_type::scoped_lock l(mtx_);
+    start_write_locked(step, time, l);
 }
 
-void single_variable_silo_writer::end_epoch(octree_server& e)
+void silo_writer::stop_write()
 {
-    std::vector<hpx::id_type> const& targets = localities();
-
-    std::vector<hpx::future<void> > futures;
-    futures.reserve(targets.size());
-
-    silo_perform_stop_write_action act;
-
-    for (boost::uint64_t i = 0; i < targets.size(); ++i)
-        futures.push_back(hpx::async(act, targets[i]));
+    if (config().asynchronous_output)
+    {
+        local_io_pipeline().submit(
+            boost::bind(&silo_writer::stop_write_unlocked
+                      , this, true));
+        return;
+    }
 
-    hpx::wait(futures);
+    mutex_type::scoped_lock l(mtx_);
+    stop_write_locked(l);
 }
 
-void perform_merge(
-    hpx::lcos::local::channel<void>& sync
-  , DBfile* file 
+void merge_file(
+    DBfile* file 
   , std::vector<std::string> const& directory_names
-  , std::string const& variable_name 
+  , std::vector<std::string> const& variable_names 
   , boost::uint64_t& step
   , double& time
     )
@@ -164,23 +158,27 @@ void perform_merge(
         int error = DBSetDir(file, directory_names[level].c_str());
         OCTOPUS_ASSERT(error == 0);
     
-        // Get a list of all the meshes and variables in that directory.
+        // Get a list of all the meshes in that directory.
         DBtoc* contents = DBGetToc(file);
 
-        // Make the mesh and variable names.
-        boost::ptr_vector<char> mesh_names(contents->nqmesh);
-        boost::ptr_vector<char> variable_names(contents->nqmesh);
-        
-        double grid_dim = config().spatial_domain;
+        // when we change directories below, "contents" will go out of scope
+        boost::uint64_t nqmesh = contents->nqmesh;
+
+        // If the writer has an output_filter, some levels may have no nodes
+        // on this locality; Silo does not allow empty multiblock objects.
+        if (0 == nqmesh)
+            continue;
 
-        for (boost::uint64_t i = 1; i < level; ++i)
-            grid_dim *= 0.5;
+        // Make the mesh names, and remember the "L%i_%i_%i_%i" part of each
+        // one; the variables on that mesh are named "<variable>_" plus that.
+        boost::ptr_vector<char> mesh_names(nqmesh);
+        std::vector<std::string> node_names;
+        node_names.reserve(nqmesh);
 
-        for (boost::uint64_t j = 0; j < boost::uint64_t(contents->nqmesh); ++j)
+        for (boost::uint64_t j = 0; j < nqmesh; ++j)
         {
             std::string tmp;
 
-            ///////////////////////////////////////////////////////////////////
             tmp  = directory_names[level];
             tmp += "/";
             tmp += contents->qmesh_names[j];
@@ -189,32 +187,19 @@ void perform_merge(
             mesh_names.push_back(new char[tmp.size() + 1]);
             std::strcpy(&mesh_names[j], tmp.c_str());
 
-            ///////////////////////////////////////////////////////////////////
-            tmp  = directory_names[level];
-            tmp += "/";
-            tmp += contents->qvar_names[j];
-
-            // The extra character is for the terminating byte.
-            variable_names.push_back(new char[tmp.size() + 1]);
-            std::strcpy(&variable_names[j], tmp.c_str());
+            std::string const mesh_name = contents->qmesh_names[j];
+            OCTOPUS_ASSERT(mesh_name.compare(0, 5, "mesh_") == 0);
+            node_names.push_back(mesh_name.substr(5));
         }
 
-        // when we change directories below, "contents" will go out of scope
-        boost::uint64_t nqmesh = contents->nqmesh;
-
         error = DBSetDir(file, "/");
         OCTOPUS_ASSERT(error == 0);
 
-        std::string multi_mesh_name
-            = boost::str( boost::format("mesh_level_%1%")
-                        % level);
-
-        std::string multi_variable_name
-            = boost::str( boost::format("%1%_level_%2%")
-                        % variable_name % level); 
-
-
         {
+            std::string multi_mesh_name
+                = boost::str( boost::format("mesh_level_%1%")
+                            % level);
+
             DBoptlist* optlist = DBMakeOptlist(4);
             DBObjectType type1 = DB_QUADRECT;
             DBAddOption(optlist, DBOPT_MB_BLOCK_TYPE, &type1);
@@ -229,7 +214,29 @@ void perform_merge(
             OCTOPUS_ASSERT(error == 0);
         }
 
+        for (boost::uint64_t v = 0; v < variable_names.size(); ++v)
         {
+            boost::ptr_vector<char> names(nqmesh);
+
+            for (boost::uint64_t j = 0; j < nqmesh; ++j)
+            {
+                std::string tmp;
+
+                tmp  = directory_names[level];
+                tmp += "/";
+                tmp += variable_names[v];
+                tmp += "_";
+                tmp += node_names[j];
+
+                // The extra character is for the terminating byte.
+                names.push_back(new char[tmp.size() + 1]);
+                std::strcpy(&names[j], tmp.c_str());
+            }
+
+            std::string multi_variable_name
+                = boost::str( boost::format("%1%_level_%2%")
+                            % variable_names[v] % level); 
+
             DBoptlist* optlist = DBMakeOptlist(4);
             DBObjectType type1 = DB_QUADVAR;
             DBAddOption(optlist, DBOPT_MB_BLOCK_TYPE, &type1);
@@ -241,21 +248,44 @@ void perform_merge(
             error = DBPutMultivar(file
                                 , multi_variable_name.c_str()
                                 , nqmesh
-                                , variable_names.c_array()
+                                , names.c_array()
                                 , NULL, optlist);
             OCTOPUS_ASSERT(error == 0);
         }
     }
+} // }}}
 
+void perform_merge(
+    hpx::lcos::local::channel<void>& sync
+  , DBfile* file 
+  , std::vector<std::string> const& directory_names
+  , std::vector<std::string> const& variable_names 
+  , boost::uint64_t& step
+  , double& time
+    )
+{
+    merge_file(file, directory_names, variable_names, step, time);
     sync.post();
-} // }}}
+}
 
-void single_variable_silo_writer::merge_locked(mutex_type::scoped_lock& l)
+void silo_writer::merge_locked(mutex_type::scoped_lock& l)
 {
     OCTOPUS_ASSERT(l.owns_lock());
+    merge_unlocked(false);
+}
 
+void silo_writer::merge_unlocked(bool io_thread)
+{
     if (merged_ || !file_) return;
 
+    // The I/O thread has a big enough stack of its own.
+    if (io_thread)
+    {
+        merge_file(file_, directory_names_, variable_names_, step_, time_);
+        merged_ = true;
+        return;
+    }
+
     hpx::lcos::local::channel<void> sync;
  
     hpx::applier::register_work_nullary(
@@ -263,7 +293,7 @@ void single_variable_silo_writer::merge_locked(mutex_type::scoped_lock& l)
                   , boost::ref(sync)
                   , file_
                   , boost::cref(directory_names_)
-                  , boost::cref(variable_name_)
+                  , boost::cref(variable_names_)
                   , boost::ref(step_)
                   , boost::ref(time_)
                     )
@@ -279,30 +309,40 @@ void single_variable_silo_writer::merge_locked(mutex_type::scoped_lock& l)
     merged_ = true;
 }
 
-void perform_write(
-    hpx::lcos::local::channel<void>& sync
-  , octree_server& e
-  , DBfile* file 
+void silo_writer::merge()
+{
+    if (config().asynchronous_output)
+    {
+        local_io_pipeline().submit(
+            boost::bind(&silo_writer::merge_unlocked
+                      , this, true));
+        return;
+    }
+
+    mutex_type::scoped_lock l(mtx_);
+    merge_locked(l);
+}
+
+void write_node_snapshot(
+    DBfile* file 
   , std::vector<std::string> const& directory_names
-  , std::string const& variable_name
-  , boost::uint64_t variable_index
+  , std::vector<std::string> const& variable_names
+  , std::vector<boost::uint64_t> const& variable_indices
+  , node_snapshot const& s
     )
 { // {{{
-    boost::uint64_t const bw = science().ghost_zone_length;
-    boost::uint64_t const gnx = config().grid_node_length;
-
-    boost::uint64_t level = e.get_level();
+    boost::uint64_t level = s.level;
 
     int nnodes[] = {
-        int(gnx - 2 * bw + 1)
-      , int(gnx - 2 * bw + 1)
-      , int(gnx - 2 * bw + 1)
+        int(s.x_faces.size())
+      , int(s.y_faces.size())
+      , int(s.z_faces.size())
     };
 
     int nzones[] = {
-        int(gnx - 2 * bw) 
-      , int(gnx - 2 * bw) 
-      , int(gnx - 2 * bw) 
+        int(s.x_faces.size() - 1) 
+      , int(s.y_faces.size() - 1) 
+      , int(s.z_faces.size() - 1) 
     };
 
     //char* coordinate_names[] = { (char*) "X", (char*) "Y", (char*) "Z" };
@@ -315,24 +355,11 @@ void perform_write(
     boost::scoped_array<double> variables
         (new double [nzones[0] * nzones[1] * nzones[2]]);
 
-    for (boost::uint64_t i = bw; i < (gnx - bw + 1); ++i) 
-    {
-        coordinates[0][i - bw] = e.x_face(i); 
-        coordinates[1][i - bw] = e.y_face(i); 
-        coordinates[2][i - bw] = e.z_face(i); 
-    }
-
-    for (boost::uint64_t i = bw; i < (gnx - bw); ++i) 
-        for (boost::uint64_t j = bw; j < (gnx - bw); ++j) 
-            for (boost::uint64_t k = bw; k < (gnx - bw); ++k) 
-            {
-                boost::uint64_t index = (i - bw)
-                                      + (j - bw) * nzones[0]
-                                      + (k - bw) * nzones[0] * nzones[1];
-                variables[index] = e(i, j, k)[variable_index];
-            }
+    std::copy(s.x_faces.begin(), s.x_faces.end(), coordinates[0]);
+    std::copy(s.y_faces.begin(), s.y_faces.end(), coordinates[1]);
+    std::copy(s.z_faces.begin(), s.z_faces.end(), coordinates[2]);
 
-    array<boost::uint64_t, 3> location = e.get_location();
+    array<boost::uint64_t, 3> const& location = s.location;
 
     std::string mesh_name
         = boost::str( boost::format("mesh_L%i_%i_%i_%i")
@@ -341,14 +368,6 @@ void perform_write(
                     % location[1]
                     % location[2]);
 
-    std::string value_name
-        = boost::str( boost::format("%s_L%i_%i_%i_%i")
-                    % variable_name
-                    % level
-                    % location[0]
-                    % location[1]
-                    % location[2]);
-
     int error = DBSetDir(file, directory_names[level].c_str());
     OCTOPUS_ASSERT(error == 0);
 
@@ -367,7 +386,29 @@ void perform_write(
         OCTOPUS_ASSERT(error == 0);
     }
 
+    // The mesh is written once, and every variable is put on it.
+    for (boost::uint64_t v = 0; v < variable_indices.size(); ++v)
     {
+        boost::uint64_t const variable_index = variable_indices[v];
+
+        for (boost::uint64_t i = 0; i < boost::uint64_t(nzones[0]); ++i) 
+            for (boost::uint64_t j = 0; j < boost::uint64_t(nzones[1]); ++j) 
+                for (boost::uint64_t k = 0; k < boost::uint64_t(nzones[2]); ++k) 
+                {
+                    boost::uint64_t index = i
+                                          + j * nzones[0]
+                                          + k * nzones[0] * nzones[1];
+                    variables[index] = (*s.U)(i, j, k)[variable_index];
+                }
+
+        std::string value_name
+            = boost::str( boost::format("%s_L%i_%i_%i_%i")
+                        % variable_names[v]
+                        % level
+                        % location[0]
+                        % location[1]
+                        % location[2]);
+
         DBoptlist* optlist = DBMakeOptlist(3);
         // REVIEW: Verify this.
         int type = DB_ROWMAJOR;
@@ -384,12 +425,42 @@ void perform_write(
     delete[] coordinates[0];
     delete[] coordinates[1];
     delete[] coordinates[2]; 
+} // }}}
 
+void perform_write(
+    hpx::lcos::local::channel<void>& sync
+  , DBfile* file 
+  , std::vector<std::string> const& directory_names
+  , std::vector<std::string> const& variable_names
+  , std::vector<boost::uint64_t> const& variable_indices
+  , node_snapshot const& s
+    )
+{
+    write_node_snapshot(file, directory_names, variable_names
+                      , variable_indices, s);
     sync.post();
-} // }}}
+}
 
-void single_variable_silo_writer::operator()(octree_server& e)
+void silo_writer::write_unlocked(node_snapshot const& s)
 {
+    write_node_snapshot(file_, directory_names_, variable_names_
+                      , variable_indices_, s);
+}
+
+void silo_writer::operator()(octree_server& e)
+{
+    // The copy is taken on the calling thread, the node may change as soon
+    // as we return.
+    node_snapshot const s = take_node_snapshot(e);
+
+    if (config().asynchronous_output)
+    {
+        local_io_pipeline().submit(
+            boost::bind(&silo_writer::write_unlocked
+                      , this, s));
+        return;
+    }
+
     mutex_type::scoped_lock l(mtx_);
 
     hpx::lcos::local::channel<void> sync;
@@ -397,11 +468,11 @@ void single_variable_silo_writer::operator()(octree_server& e)
     hpx::applier::register_work_nullary(
         boost::bind(&perform_write
                   , boost::ref(sync)
-                  , boost::ref(e)
                   , file_
                   , boost::cref(directory_names_)
-                  , boost::cref(variable_name_)
-                  , boost::cref(variable_index_)
+                  , boost::cref(variable_names_)
+                  , boost::cref(variable_indices_)
+                  , boost::cref(s)
                     )
       , "perform_write"
       , hpx::threads::pending
@@ -0,0 +1,216 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#include <hpx/include/actions.hpp>
+#include <hpx/lcos/future_wait.hpp>
+
+#include <octopus/io/slice.hpp>
+#include <octopus/engine/engine_interface.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+
+#include <cstring>
+
+namespace octopus
+{
+
+/// Appends the records of the cells it is called on to a buffer.
+struct pack_slice_records
+{
+  private:
+    std::vector<char>* records_;
+
+    template <typename T>
+    void append(T const& t) const
+    {
+        char const* p = reinterpret_cast<char const*>(&t);
+        records_->insert(records_->end(), p, p + sizeof(T));
+    }
+
+  public:
+    pack_slice_records() : records_(0) {}
+
+    pack_slice_records(std::vector<char>& records) : records_(&records) {}
+
+    void operator()(
+        octree_server& e
+      , state& u
+      , array<double, 3>& c
+        ) const
+    {
+        append(c[0]);
+        append(c[1]);
+        append(c[2]);
+        append(boost::uint64_t(e.get_level()));
+
+        for (boost::uint64_t i = 0; i < u.size(); ++i)
+            append(u[i]);
+    }
+
+    // Only used locally.
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int)
+    {
+        OCTOPUS_ASSERT(false);
+    }
+};
+
+slice_writer::~slice_writer()
+{
+    // Make sure the I/O thread is done with us.
+    if (config().asynchronous_output)
+        local_io_pipeline().drain_and_report();
+
+    mutex_type::scoped_lock l(mtx_);
+    stop_write_unlocked();
+}
+
+void slice_writer::start_write_unlocked(
+    boost::uint64_t step
+  , double time
+  , boost::uint32_t locality_id
+    )
+{ // {{{
+    // Make sure we closed the last epoch.
+    stop_write_unlocked();
+
+    std::string s;
+
+    try
+    {
+        s = boost::str(boost::format(file_name_) % locality_id % step);
+    }
+    // FIXME: Catch the specific boost.format exception.
+    catch (...)
+    {
+        try
+        {
+            s = boost::str(boost::format(file_name_) % locality_id);
+        }
+        // FIXME: Catch the specific boost.format exception.
+        catch (...)
+        {
+            s = file_name_;
+        }
+    }
+
+    file_.open(s.c_str(), std::ios::binary | std::ios::trunc);
+
+    OCTOPUS_ASSERT(file_.is_open());
+
+    slice::file_header h;
+    std::memset(&h, 0, sizeof(h));
+
+    std::memcpy(h.magic, slice::magic, sizeof(slice::magic));
+    h.version     = slice::format_version;
+    h.byte_order  = slice::byte_order_mark;
+    h.locality_id = locality_id;
+    h.step        = step;
+    h.time        = time;
+    h.axis        = axis_;
+    h.eps         = eps_;
+    h.state_size  = OCTOPUS_STATE_SIZE;
+
+    file_.write(reinterpret_cast<char const*>(&h), sizeof(h));
+
+    block_.reserve(block_size);
+} // }}}
+
+void slice_writer::flush_unlocked()
+{
+    if (!block_.empty())
+    {
+        file_.write(&block_[0], block_.size());
+        block_.clear();
+    }
+}
+
+void slice_writer::stop_write_unlocked()
+{
+    if (file_.is_open())
+    {
+        flush_unlocked();
+        file_.close();
+    }
+
+    block_.clear();
+}
+
+void slice_writer::write_unlocked(
+    boost::shared_ptr<std::vector<char> > const& records
+    )
+{
+    OCTOPUS_ASSERT(file_.is_open());
+
+    if (block_.size() + records->size() > block_size)
+        flush_unlocked();
+
+    block_.insert(block_.end(), records->begin(), records->end());
+}
+
+void slice_writer::start_write(
+    boost::uint64_t step
+  , double time
+    )
+{
+    if (config().asynchronous_output)
+    {
+        local_io_pipeline().submit(
+            boost::bind(&slice_writer::start_write_unlocked
+                      , this, step, time, hpx::get_locality_id()));
+        return;
+    }
+
+    mutex_type::scoped_lock l(mtx_);
+    start_write_unlocked(step, time, hpx::get_locality_id());
+}
+
+void slice_writer::stop_write()
+{
+    if (config().asynchronous_output)
+    {
+        local_io_pipeline().submit(
+            boost::bind(&slice_writer::stop_write_unlocked, this));
+        return;
+    }
+
+    mutex_type::scoped_lock l(mtx_);
+    stop_write_unlocked();
+}
+
+void slice_writer::operator()(octree_server& e)
+{ // {{{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    boost::shared_ptr<std::vector<char> > records
+        = boost::make_shared<std::vector<char> >();
+
+    records->reserve((gnx - 2 * bw) * (gnx - 2 * bw)
+                   * slice::record_size(OCTOPUS_STATE_SIZE));
+
+    // Nodes pack their records concurrently; only the append to the block
+    // is serialized.
+    e.slice_leaf(pack_slice_records(*records), axis_, eps_);
+
+    if (records->empty())
+        return;
+
+    if (config().asynchronous_output)
+    {
+        local_io_pipeline().submit(
+            boost::bind(&slice_writer::write_unlocked, this, records));
+        return;
+    }
+
+    mutex_type::scoped_lock l(mtx_);
+    write_unlocked(records);
+} // }}}
+
+}
+
@@ -0,0 +1,159 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#include <hpx/include/actions.hpp>
+#include <hpx/lcos/future_wait.hpp>
+
+#include <octopus/io/snapshot.hpp>
+#include <octopus/engine/engine_interface.hpp>
+
+#include <boost/bind.hpp>
+
+#include <cstring>
+
+namespace octopus
+{
+
+snapshot_writer::~snapshot_writer()
+{
+    // Make sure the I/O thread is done with us.
+    if (config().asynchronous_output)
+        local_io_pipeline().drain_and_report();
+
+    mutex_type::scoped_lock l(mtx_);
+    stop_write_unlocked();
+}
+
+void snapshot_writer::start_write_unlocked(
+    boost::uint64_t step
+  , double time
+  , boost::uint32_t locality_id
+    )
+{ // {{{
+    // Make sure we closed the last epoch.
+    stop_write_unlocked();
+
+    snapshot::file_header h;
+    std::memset(&h, 0, sizeof(h));
+
+    h.locality_id          = locality_id;
+    h.step                 = step;
+    h.time                 = time;
+    h.grid_node_length     = config().grid_node_length;
+    h.ghost_zone_length    = science().ghost_zone_length;
+    h.interior_length      = config().grid_node_length
+                           - 2 * science().ghost_zone_length;
+    h.state_size           = OCTOPUS_STATE_SIZE;
+    h.levels_of_refinement = config().levels_of_refinement;
+    h.spatial_domain       = config().spatial_domain;
+
+    // Leave room for the terminating byte.
+    std::strncpy(h.science, science_name_.c_str(), sizeof(h.science) - 1);
+
+    std::string s;
+
+    try
+    {
+        s = boost::str(boost::format(file_name_) % locality_id % step);
+    }
+    // FIXME: Catch the specific boost.format exception.
+    catch (...)
+    {
+        try
+        {
+            s = boost::str(boost::format(file_name_) % locality_id);
+        }
+        // FIXME: Catch the specific boost.format exception.
+        catch (...)
+        {
+            s = file_name_;
+        }
+    }
+
+    file_.reset(new snapshot::file_writer(s, h));
+} // }}}
+
+void snapshot_writer::stop_write_unlocked()
+{
+    if (file_)
+    {
+        file_->close();
+        file_.reset();
+    }
+}
+
+void snapshot_writer::write_unlocked(node_snapshot const& s)
+{ // {{{
+    OCTOPUS_ASSERT(file_);
+
+    snapshot::index_entry e;
+    std::memset(&e, 0, sizeof(e));
+
+    e.level       = s.level;
+    e.location[0] = s.location[0];
+    e.location[1] = s.location[1];
+    e.location[2] = s.location[2];
+    e.step        = s.step;
+    e.time        = s.time;
+    e.dx          = s.dx;
+
+    // The interior copy in the snapshot is a vector4d, which has the layout
+    // of the file format.
+    file_->write_node(e
+                    , &s.x_faces[0]
+                    , &s.y_faces[0]
+                    , &s.z_faces[0]
+                    , &(*s.U)(0, 0, 0)[0]);
+} // }}}
+
+void snapshot_writer::start_write(
+    boost::uint64_t step
+  , double time
+    )
+{
+    if (config().asynchronous_output)
+    {
+        local_io_pipeline().submit(
+            boost::bind(&snapshot_writer::start_write_unlocked
+                      , this, step, time, hpx::get_locality_id()));
+        return;
+    }
+
+    mutex_type::scoped_lock l(mtx_);
+    start_write_unlocked(step, time, hpx::get_locality_id());
+}
+
+void snapshot_writer::stop_write()
+{
+    if (config().asynchronous_output)
+    {
+        local_io_pipeline().submit(
+            boost::bind(&snapshot_writer::stop_write_unlocked, this));
+        return;
+    }
+
+    mutex_type::scoped_lock l(mtx_);
+    stop_write_unlocked();
+}
+
+void snapshot_writer::operator()(octree_server& e)
+{
+    node_snapshot const s = take_node_snapshot(e);
+
+    if (config().asynchronous_output)
+    {
+        local_io_pipeline().submit(
+            boost::bind(&snapshot_writer::write_unlocked, this, s));
+        return;
+    }
+
+    mutex_type::scoped_lock l(mtx_);
+    write_unlocked(s);
+}
+
+}
+
@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#include <hpx/include/actions.hpp>
+#include <hpx/lcos/future_wait.hpp>
+
+#include <octopus/io/writer.hpp>
+#include <octopus/engine/engine_interface.hpp>
+
+namespace octopus
+{
+
+// The writer is looked up through science().output on each locality, so a
+// writer that is wrapped in a multi_writer is started along with the rest.
+void writer_perform_start_write(
+    boost::uint64_t step
+  , double time
+    )
+{
+    science().output.start_write(step, time);
+}
+
+void writer_perform_stop_write()
+{
+    science().output.stop_write();
+}
+
+}
+
+// Silo needs a medium stack.
+HPX_PLAIN_ACTION(octopus::writer_perform_start_write
+               , writer_perform_start_write_action);
+HPX_ACTION_USES_MEDIUM_STACK(writer_perform_start_write_action);
+HPX_PLAIN_ACTION(octopus::writer_perform_stop_write
+               , writer_perform_stop_write_action);
+HPX_ACTION_USES_MEDIUM_STACK(writer_perform_stop_write_action);
+
+namespace octopus
+{
+
+void writer_base::begin_epoch(
+    octree_server& e
+  , double time
+    )
+{
+    std::vector<hpx::id_type> const& targets = localities();
+
+    std::vector<hpx::future<void> > futures;
+    futures.reserve(targets.size());
+
+    writer_perform_start_write_action act;
+
+    for (boost::uint64_t i = 0; i < targets.size(); ++i)
+        futures.push_back(hpx::async(act, targets[i], e.get_step(), time));
+
+    hpx::wait(futures);
+}
+
+void writer_base::end_epoch(octree_server& e)
+{
+    std::vector<hpx::id_type> const& targets = localities();
+
+    std::vector<hpx::future<void> > futures;
+    futures.reserve(targets.size());
+
+    writer_perform_stop_write_action act;
+
+    for (boost::uint64_t i = 0; i < targets.size(); ++i)
+        futures.push_back(hpx::async(act, targets[i]));
+
+    hpx::wait(futures);
+}
+
+}
+
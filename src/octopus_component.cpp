@@ -49,10 +49,13 @@ OCTOPUS_REGISTER_ACTION(get_oid);
 OCTOPUS_REGISTER_ACTION(get_siblings);
 OCTOPUS_REGISTER_ACTION(get_offset);
 OCTOPUS_REGISTER_ACTION(get_location);
+OCTOPUS_REGISTER_ACTION(get_cost);
 
 OCTOPUS_REGISTER_ACTION(receive_ghost_zone);
+OCTOPUS_REGISTER_ACTION(receive_diagonal_ghost_zone);
 OCTOPUS_REGISTER_ACTION(send_ghost_zone);
 OCTOPUS_REGISTER_ACTION(send_interpolated_ghost_zone);
+OCTOPUS_REGISTER_ACTION(exchange_ghost_zones);
 OCTOPUS_REGISTER_ACTION(map_ghost_zone);
 
 OCTOPUS_REGISTER_ACTION(child_to_parent_state_injection);
@@ -65,6 +68,10 @@ OCTOPUS_REGISTER_ACTION(apply);
 
 OCTOPUS_REGISTER_ACTION(step);
 OCTOPUS_REGISTER_ACTION(step_recurse);
+OCTOPUS_REGISTER_ACTION(step_with_cfl);
+OCTOPUS_REGISTER_ACTION(step_with_cfl_recurse);
+OCTOPUS_REGISTER_ACTION(receive_child_dt);
+OCTOPUS_REGISTER_ACTION(receive_step_dt);
 
 OCTOPUS_REGISTER_ACTION(copy_and_regrid);
 OCTOPUS_REGISTER_ACTION(refine);
@@ -76,6 +83,8 @@ OCTOPUS_REGISTER_ACTION(receive_sibling_refinement_signal);
 
 OCTOPUS_REGISTER_ACTION(slice);
 OCTOPUS_REGISTER_ACTION(slice_leaf);
+OCTOPUS_REGISTER_ACTION(region);
+OCTOPUS_REGISTER_ACTION(probe);
 
 OCTOPUS_REGISTER_ACTION(save);
 OCTOPUS_REGISTER_ACTION(load);
@@ -0,0 +1,278 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#include <hpx/config.hpp>
+#include <hpx/async.hpp>
+#include <hpx/lcos/future.hpp>
+#include <hpx/lcos/future_wait.hpp>
+#include <hpx/lcos/local/promise.hpp>
+#include <hpx/apply.hpp>
+
+#include <octopus/engine/engine_interface.hpp>
+#include <octopus/octree/octree_server.hpp>
+#include <octopus/octree/octree_registry.hpp>
+#include <octopus/octree/batched_step.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+namespace octopus
+{
+
+/// One stage of the timestep of one node.
+struct batched_stage
+{
+    enum kind
+    {
+        begin_step
+      , ghost_zones
+      , flux
+      , flux_injection
+      , update
+      , state_injection
+      , end_step
+    };
+
+  private:
+    kind kind_;
+    boost::uint64_t phase_;
+    double dt_;
+    double beta_;
+
+  public:
+    batched_stage(
+        kind k
+      , boost::uint64_t phase
+      , double dt = 0.0
+      , double beta = 0.0
+        )
+      : kind_(k)
+      , phase_(phase)
+      , dt_(dt)
+      , beta_(beta)
+    {}
+
+    /// Returns true if the stage depends on other nodes, in which case it has
+    /// to be started with run_async.
+    bool communicates() const
+    {
+        return ghost_zones == kind_
+            || flux_injection == kind_
+            || state_injection == kind_;
+    }
+
+    void run(octree_server& node) const
+    { // {{{
+        switch (kind_)
+        {
+            case begin_step:
+                node.begin_step_stage();
+                break;
+
+            case flux:
+                node.flux_stage(phase_);
+                break;
+
+            case update:
+                node.update_stage(phase_, dt_, beta_);
+                break;
+
+            case end_step:
+                node.end_step_stage(dt_);
+                break;
+
+            default:
+                OCTOPUS_ASSERT_MSG(false, "batched stage is asynchronous");
+        }
+    } // }}}
+
+    hpx::future<void> run_async(octree_server& node) const
+    { // {{{
+        switch (kind_)
+        {
+            case ghost_zones:
+                return node.ghost_zone_stage_async(phase_);
+
+            case flux_injection:
+                return node.flux_injection_stage_async(phase_);
+
+            case state_injection:
+                return node.state_injection_stage_async(phase_);
+
+            default:
+                OCTOPUS_ASSERT_MSG(false, "batched stage is synchronous");
+        }
+
+        return hpx::future<void>();
+    } // }}}
+};
+
+/// The stages of a timestep of size \a dt, in order.
+std::vector<batched_stage> batched_stages(double dt)
+{ // {{{
+    std::vector<batched_stage> stages;
+
+    boost::uint64_t const rk_order = config().runge_kutta_order;
+
+    stages.push_back(batched_stage(batched_stage::begin_step, 0));
+
+    for (boost::uint64_t phase = 0; phase < rk_order; ++phase)
+    {
+        double const beta = octree_server::runge_kutta_beta(phase);
+
+        stages.push_back(batched_stage(batched_stage::ghost_zones, phase));
+        stages.push_back(batched_stage(batched_stage::flux, phase));
+        stages.push_back(batched_stage(batched_stage::flux_injection, phase));
+        stages.push_back(batched_stage(batched_stage::update, phase
+                                     , dt, beta));
+        stages.push_back(batched_stage(batched_stage::state_injection
+                                     , phase));
+    }
+
+    if (config().final_ghost_zone_exchange)
+        stages.push_back(batched_stage(batched_stage::ghost_zones, rk_order));
+    stages.push_back(batched_stage(batched_stage::end_step, rk_order, dt));
+
+    return stages;
+} // }}}
+
+/// The timestep of one node. Each stage that depends on other nodes is started
+/// and the rest of the step is attached to it as a continuation, so no thread
+/// waits for another node and each node moves on to its next stage as soon as
+/// its own dependencies are met.
+struct node_dataflow_step
+{
+    octree_server* node;
+    std::vector<batched_stage> const* stages;
+    std::size_t next;
+    hpx::lcos::local::promise<void> done;
+
+    node_dataflow_step(
+        octree_server* node_
+      , std::vector<batched_stage> const* stages_
+        )
+      : node(node_)
+      , stages(stages_)
+      , next(0)
+      , done()
+    {}
+};
+
+void resume_dataflow_step(
+    boost::shared_ptr<node_dataflow_step> s
+  , hpx::future<void> previous
+    );
+
+/// Runs the stages of \a s until one of them has to wait for another node.
+void advance_dataflow_step(
+    boost::shared_ptr<node_dataflow_step> s
+    )
+{ // {{{
+    try
+    {
+        while (s->next < s->stages->size())
+        {
+            batched_stage const& stage = (*s->stages)[s->next++];
+
+            if (stage.communicates())
+            {
+                stage.run_async(*s->node).then(
+                    boost::bind(&resume_dataflow_step, s, _1));
+                return;
+            }
+
+            stage.run(*s->node);
+        }
+    }
+
+    catch (...)
+    {
+        s->done.set_exception(boost::current_exception());
+        return;
+    }
+
+    s->done.set_value();
+} // }}}
+
+void resume_dataflow_step(
+    boost::shared_ptr<node_dataflow_step> s ///< Bound parameter.
+  , hpx::future<void> previous
+    )
+{ // {{{
+    try
+    {
+        // Propagate errors from the previous stage.
+        previous.move();
+    }
+
+    catch (...)
+    {
+        s->done.set_exception(boost::current_exception());
+        return;
+    }
+
+    advance_dataflow_step(s);
+} // }}}
+
+void step_local_nodes_batched(double dt)
+{ // {{{
+    OCTOPUS_ASSERT_MSG(0 < dt, "invalid timestep size");
+
+    std::vector<octree_server*> const nodes = local_octree_registry().nodes();
+
+    std::vector<batched_stage> const stages = batched_stages(dt);
+
+    std::vector<hpx::future<void> > steps;
+    steps.reserve(nodes.size());
+
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        boost::shared_ptr<node_dataflow_step> s
+            = boost::make_shared<node_dataflow_step>(nodes[i], &stages);
+
+        steps.push_back(s->done.get_future());
+
+        hpx::apply(boost::bind(&advance_dataflow_step, s));
+    }
+
+    // stages has to outlive the steps.
+    hpx::wait(steps);
+} // }}}
+
+struct step_locality_batched
+{
+  private:
+    double dt_;
+
+  public:
+    step_locality_batched() : dt_(0.0) {}
+
+    step_locality_batched(double dt) : dt_(dt) {}
+
+    void operator()() const
+    {
+        step_local_nodes_batched(dt_);
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        ar & dt_;
+    }
+};
+
+void step_batched(double dt)
+{ // {{{
+    hpx::wait(call_everywhere(step_locality_batched(dt)));
+} // }}}
+
+}
+
@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#include <octopus/engine/engine_interface.hpp>
+#include <octopus/octree/flux_scratch_pool.hpp>
+
+#include <algorithm>
+
+namespace octopus
+{
+
+boost::shared_ptr<flux_scratch> flux_scratch_pool::acquire()
+{ // {{{
+    {
+        mutex_type::scoped_lock l(mtx_);
+
+        ++leased_;
+        peak_leased_ = (std::max)(peak_leased_, leased_);
+
+        if (!free_.empty())
+        {
+            boost::shared_ptr<flux_scratch> s = free_.back();
+            free_.pop_back();
+            return s;
+        }
+
+        ++allocated_;
+    }
+
+    // Allocate outside of the lock.
+    return boost::shared_ptr<flux_scratch>
+        (new flux_scratch(config().grid_node_length));
+} // }}}
+
+void flux_scratch_pool::release(boost::shared_ptr<flux_scratch>& s)
+{ // {{{
+    if (!s)
+        return;
+
+    mutex_type::scoped_lock l(mtx_);
+    OCTOPUS_ASSERT(0 < leased_);
+    --leased_;
+    free_.push_back(s);
+    s.reset();
+} // }}}
+
+flux_scratch_pool& local_flux_scratch_pool()
+{
+    static flux_scratch_pool pool;
+    return pool;
+}
+
+}
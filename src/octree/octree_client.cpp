@@ -14,6 +14,8 @@
 
 #include <octopus/octree/octree_server.hpp>
 #include <octopus/octree/octree_apply_leaf.hpp>
+#include <octopus/octree/locality_apply.hpp>
+#include <octopus/octree/octree_registry.hpp>
 #include <octopus/engine/engine_interface.hpp>
 #include <octopus/trivial_serialization.hpp>
 #include <octopus/math.hpp>
@@ -80,11 +82,38 @@ octree_client::octree_client(
 } // }}}
 
 ///////////////////////////////////////////////////////////////////////////////
+/// Fails if there is a root on the calling locality.
+struct require_no_root
+{
+    void operator()() const
+    {
+        OCTOPUS_ASSERT_MSG(local_octree_registry().nodes(0).empty(),
+                           "only one octree is supported");
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int)
+    {}
+};
+
+/// Apply, reduce and output on the root visit every node that is registered
+/// on each locality (see locality_apply.hpp), so they would also visit the
+/// nodes of any other octree. Only one octree may be created.
+void require_single_octree()
+{
+    std::vector<hpx::future<void> > checks = call_everywhere(require_no_root());
+
+    for (std::size_t i = 0; i < checks.size(); ++i)
+        checks[i].get();
+}
+
 void octree_client::create_root(
     hpx::id_type const& locality
   , octree_init_data const& init
     ) 
 {
+    require_single_octree();
+
     kind_ = real_boundary;
 
     OCTOPUS_ASSERT_FMT_MSG(!(locality.get_msb() & 0xFF),
@@ -101,6 +130,8 @@ void octree_client::create_root(
   , BOOST_RV_REF(octree_init_data) init
     ) 
 {
+    require_single_octree();
+
     kind_ = real_boundary;
 
     OCTOPUS_ASSERT_FMT_MSG(!(locality.get_msb() & 0xFF),
@@ -288,6 +319,13 @@ octree_client::get_location_async() const
     return hpx::async<octree_server::get_location_action>(gid_);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+hpx::future<node_cost> octree_client::get_cost_async() const
+{
+    ensure_real();
+    return hpx::async<octree_server::get_cost_action>(gid_);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 hpx::future<vector4d<double> >
 octree_client::send_interpolated_ghost_zone_async(
@@ -380,6 +418,18 @@ void octree_client::receive_ghost_zone_push(
         (gid_, step, phase, f, boost::move(zone));
 }
 
+hpx::future<void> octree_client::receive_diagonal_ghost_zone_async(
+    boost::uint64_t step ///< For debugging purposes.
+  , boost::uint64_t phase 
+  , array<boost::int64_t, 3> const& direction ///< Of the caller.
+  , BOOST_RV_REF(vector4d<double>) zone
+    ) const
+{
+    ensure_real();
+    return hpx::async<octree_server::receive_diagonal_ghost_zone_action>
+        (gid_, step, phase, direction, boost::move(zone));
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 hpx::future<void> octree_client::child_to_parent_state_injection_async(
     boost::uint64_t phase 
@@ -464,6 +514,61 @@ hpx::future<void> octree_client::step_async() const
     return hpx::async<octree_server::step_action>(gid_);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+hpx::future<double> octree_client::step_with_cfl_async(
+    double cfl_factor
+  , double max_dt
+    ) const
+{
+    ensure_real();
+    return hpx::async<octree_server::step_with_cfl_action>
+        (gid_, cfl_factor, max_dt);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+hpx::future<void> octree_client::receive_child_dt_async(
+    boost::uint64_t step ///< For debugging purposes.
+  , child_index idx 
+  , double dt
+    ) const
+{
+    ensure_real();
+    return hpx::async<octree_server::receive_child_dt_action>
+        (gid_, step, idx, dt);
+}
+
+void octree_client::receive_child_dt_push(
+    boost::uint64_t step ///< For debugging purposes.
+  , child_index idx 
+  , double dt
+    ) const
+{
+    ensure_real();
+    hpx::apply<octree_server::receive_child_dt_action>
+        (gid_, step, idx, dt);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+hpx::future<void> octree_client::receive_step_dt_async(
+    boost::uint64_t step ///< For debugging purposes.
+  , double dt
+    ) const
+{
+    ensure_real();
+    return hpx::async<octree_server::receive_step_dt_action>
+        (gid_, step, dt);
+}
+
+void octree_client::receive_step_dt_push(
+    boost::uint64_t step ///< For debugging purposes.
+  , double dt
+    ) const
+{
+    ensure_real();
+    hpx::apply<octree_server::receive_step_dt_action>
+        (gid_, step, dt);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 struct begin_io_epoch_locally
 {
@@ -552,7 +657,8 @@ struct output_continuation
     // future continuation overload
     result_type operator()(hpx::future<void> res) const
     {
-        self_.apply(output_locally());
+        // Each locality writes its own nodes.
+        apply_by_locality(output_locally());
     }
 };
     
@@ -681,6 +787,24 @@ hpx::future<void> octree_client::slice_leaf_async(
     return hpx::async<octree_server::slice_leaf_action>(gid_, f, a, eps); 
 }
 
+hpx::future<void> octree_client::region_async(
+    slice_function const& f
+  , array<double, 3> const& lower
+  , array<double, 3> const& upper
+    ) const
+{
+    ensure_real();
+    return hpx::async<octree_server::region_action>(gid_, f, lower, upper); 
+}
+
+hpx::future<std::vector<state> > octree_client::probe_async(
+    std::vector<array<double, 3> > const& points
+    ) const
+{
+    ensure_real();
+    return hpx::async<octree_server::probe_action>(gid_, points); 
+}
+
 hpx::future<void> octree_client::save_async() const
 {
     ensure_real();
@@ -0,0 +1,19 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#include <octopus/octree/octree_registry.hpp>
+
+namespace octopus
+{
+
+octree_registry& local_octree_registry()
+{
+    static octree_registry registry;
+    return registry;
+}
+
+}
@@ -12,18 +12,31 @@
 #include <hpx/lcos/future.hpp>
 #include <hpx/lcos/future_wait.hpp>
 #include <hpx/lcos/wait_all.hpp>
+#include <hpx/lcos/when_all.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
 
 #include <octopus/math.hpp>
+#include <octopus/buffer_pool.hpp>
 #include <octopus/iomanip.hpp>
 #include <octopus/indexer2d.hpp>
+#include <octopus/runge_kutta.hpp>
+#include <octopus/unwrap.hpp>
 #include <octopus/octree/octree_server.hpp>
+#include <octopus/octree/octree_registry.hpp>
+#include <octopus/octree/topology_index.hpp>
+#include <octopus/octree/flux_scratch_pool.hpp>
+#include <octopus/octree/batched_step.hpp>
+#include <octopus/octree/load_balance.hpp>
+#include <octopus/octree/locality_apply.hpp>
+#include <octopus/science/cfl_dt_from_flux_sweep.hpp>
 #include <octopus/engine/engine_interface.hpp>
 
 #include <boost/array.hpp>
 #include <boost/range/adaptor/map.hpp>
 
-// TODO: Verify the size of parent_U and it's elements when initialization is
-// complete.
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 // NOTE (wash): Is it necessary to solve coarser regions of the grid that are
 // being solved at a finer level? I know this is necessary for the multigrid
@@ -81,41 +94,46 @@ std::ostream& operator<<(std::ostream& os, oid_type const& id)
     return os;
 }
 
-// IMPLEMENT: Pass only the state that is needed.
+/// \a parent_octant is the octant of our parent's state that covers us, plus a
+/// one cell border (see octree_server::send_child_octant).
 void octree_server::parent_to_child_injection(
-    vector4d<double> const& parent_U 
+    vector4d<double> const& parent_octant 
     )
 { // {{{
     boost::uint64_t const bw = science().ghost_zone_length;
     boost::uint64_t const gnx = config().grid_node_length;
+
+    OCTOPUS_ASSERT(parent_octant.x_length() == (gnx / 2 - bw) + 2);
+    OCTOPUS_ASSERT(parent_octant.y_length() == (gnx / 2 - bw) + 2);
+    OCTOPUS_ASSERT(parent_octant.z_length() == (gnx / 2 - bw) + 2);
     
     indexer2d<2> const indexer(bw, gnx - bw - 1, bw, gnx - bw - 1);
 
-    child_index c = get_child_index();
-
     state s1, s2, s3;
 
     for (boost::uint64_t index = 0; index <= indexer.maximum; ++index)
     {
         boost::uint64_t k = indexer.y(index);
         boost::uint64_t j = indexer.x(index);
-        boost::uint64_t k0 = (bw + k) / 2 + c.z() * (gnx / 2 - bw);
-        boost::uint64_t j0 = (bw + j) / 2 + c.y() * (gnx / 2 - bw);
 
-        for ( boost::uint64_t i = bw, i0 = bw + c.x() * (gnx / 2 - bw)
+        // Adjusted indices (for source); the border is at 0.
+        boost::uint64_t k0 = (k - bw) / 2 + 1;
+        boost::uint64_t j0 = (j - bw) / 2 + 1;
+
+        for ( boost::uint64_t i = bw, i0 = 1
             ; i < (gnx - bw)
             ; i += 2, ++i0)
         {
-            state const& u = parent_U(i0, j0, k0);
+            state const& u = parent_octant(i0, j0, k0);
 
-            s1 = minmod(parent_U(i0 + 1, j0, k0) - u
-                      , u - parent_U(i0 - 1, j0, k0));
+            s1 = minmod(parent_octant(i0 + 1, j0, k0) - u
+                      , u - parent_octant(i0 - 1, j0, k0));
 
-            s2 = minmod(parent_U(i0, j0 + 1, k0) - u
-                      , u - parent_U(i0, j0 - 1, k0));
+            s2 = minmod(parent_octant(i0, j0 + 1, k0) - u
+                      , u - parent_octant(i0, j0 - 1, k0));
 
-            s3 = minmod(parent_U(i0, j0, k0 + 1) - u
-                      , u - parent_U(i0, j0, k0 - 1));
+            s3 = minmod(parent_octant(i0, j0, k0 + 1) - u
+                      , u - parent_octant(i0, j0, k0 - 1));
 
             // FIXME: The little DSEL makes for clean syntax, but I need to
             // check with Joel Falcou/Heller about how copy intensive this is.
@@ -144,6 +162,11 @@ void octree_server::initialize_queues()
     for (boost::uint64_t i = 0; i < (config().runge_kutta_order + 1); ++i)
         ghost_zone_deps_.push_back(sibling_state_dependencies());
 
+    if (config().wide_halos)
+        for (boost::uint64_t i = 0; i < (config().runge_kutta_order + 1); ++i)
+            diagonal_ghost_zone_deps_.push_back
+                (diagonal_state_dependencies());
+
     if (level_ == config().levels_of_refinement)
         return;
 
@@ -171,6 +194,7 @@ octree_server::octree_server(
   , past_self_(hpx::invalid_id)
   , marked_for_refinement_()
   , ghost_zone_deps_()
+  , diagonal_ghost_zone_deps_()
   , children_state_deps_()
   , children_flux_deps_()
   , refinement_deps_()
@@ -178,6 +202,9 @@ octree_server::octree_server(
   , siblings_()
   , nephews_()
   , exterior_nephews_()
+  , diagonal_directions_()
+  , diagonal_siblings_()
+  , diagonal_nephews_()
   , level_(init.level)
   , location_(init.location)
   , dx_(init.dx)
@@ -185,16 +212,17 @@ octree_server::octree_server(
   , time_(init.time)
   , offset_(init.offset)
   , origin_(init.origin)
+  , bounds_lower_()
+  , bounds_upper_()
   , step_(0)
   , U_(new vector4d<double>(config().grid_node_length))
   , U0_()
-  , FX_(config().grid_node_length)
-  , FY_(config().grid_node_length)
-  , FZ_(config().grid_node_length)
+  , differentials_()
   , FO_(new state())
   , FO0_()
-  , D_(config().grid_node_length)
   , DFO_()
+  , max_wave_speed_()
+  , timings_(config().cost_window)
 {
     OCTOPUS_ASSERT(back_ptr);
     OCTOPUS_ASSERT(back_ptr->get_gid() != hpx::invalid_id);
@@ -202,6 +230,12 @@ octree_server::octree_server(
 
     initialize_queues();
 
+    compute_bounding_box();
+
+    local_octree_registry().add(this, level_);
+    local_topology_index().add_pending(topology_entry
+        (level_, location_, hpx::find_here(), reference_from_this()));
+
     for (face i = XL; i < invalid_face; i = face(boost::uint8_t(i + 1)))
     {
         siblings_[i] = octree_client(physical_boundary, client_from_this(), i); 
@@ -212,7 +246,7 @@ octree_server::octree_server(
 octree_server::octree_server(
     back_pointer_type back_ptr
   , octree_init_data const& init
-  , boost::shared_ptr<vector4d<double> > const& parent_U
+  , boost::shared_ptr<vector4d<double> > const& parent_octant
     )
 // {{{
   : base_type(back_ptr)
@@ -222,6 +256,7 @@ octree_server::octree_server(
   , past_self_(hpx::invalid_id)
   , marked_for_refinement_()
   , ghost_zone_deps_()
+  , diagonal_ghost_zone_deps_()
   , children_state_deps_()
   , children_flux_deps_()
   , refinement_deps_()
@@ -229,6 +264,9 @@ octree_server::octree_server(
   , siblings_()
   , nephews_()
   , exterior_nephews_()
+  , diagonal_directions_()
+  , diagonal_siblings_()
+  , diagonal_nephews_()
   , level_(init.level)
   , location_(init.location)
   , dx_(init.dx)
@@ -236,16 +274,17 @@ octree_server::octree_server(
   , time_(init.time)
   , offset_(init.offset)
   , origin_(init.origin)
+  , bounds_lower_()
+  , bounds_upper_()
   , step_(init.step)
   , U_(new vector4d<double>(config().grid_node_length))
   , U0_()
-  , FX_(config().grid_node_length)
-  , FY_(config().grid_node_length)
-  , FZ_(config().grid_node_length)
+  , differentials_()
   , FO_(new state())
   , FO0_()
-  , D_(config().grid_node_length)
   , DFO_()
+  , max_wave_speed_()
+  , timings_(config().cost_window)
 {
     OCTOPUS_ASSERT(back_ptr);
     OCTOPUS_ASSERT(back_ptr->get_gid() != hpx::invalid_id);
@@ -257,7 +296,73 @@ octree_server::octree_server(
 
     initialize_queues();
 
-    parent_to_child_injection(*parent_U);
+    compute_bounding_box();
+
+    parent_to_child_injection(*parent_octant);
+
+    local_octree_registry().add(this, level_);
+    local_topology_index().add_pending(topology_entry
+        (level_, location_, hpx::find_here(), reference_from_this()));
+} // }}}
+
+octree_server::~octree_server()
+{
+    local_octree_registry().remove(this, level_);
+}
+
+bool octree_server::zone_is_refined(
+    boost::uint64_t i
+  , boost::uint64_t j
+  , boost::uint64_t k
+    ) const
+{ // {{{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    OCTOPUS_ASSERT(bw <= i && i < (gnx - bw));
+    OCTOPUS_ASSERT(bw <= j && j < (gnx - bw));
+    OCTOPUS_ASSERT(bw <= k && k < (gnx - bw));
+
+    // Each child covers half of our interior zones along each axis (see
+    // add_child_state).
+    boost::uint64_t const half = (gnx / 2) - bw;
+
+    child_index const kid((i - bw) / half, (j - bw) / half, (k - bw) / half);
+
+    return hpx::invalid_id != children_[kid];
+} // }}}
+
+boost::uint64_t octree_server::number_of_children() const
+{ // {{{
+    boost::uint64_t count = 0;
+
+    for (boost::uint64_t i = 0; i < 8; ++i)
+        if (hpx::invalid_id != children_[i])
+            ++count;
+
+    return count;
+} // }}}
+
+array<double, 3> octree_server::compute_max_wave_speed()
+{ // {{{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    array<double, 3> max_speed;
+
+    for (boost::uint64_t i = bw; i < (gnx - bw); ++i)
+        for (boost::uint64_t j = bw; j < (gnx - bw); ++j)
+            for (boost::uint64_t k = bw; k < (gnx - bw); ++k)
+            {
+                state const& u = (*U_)(i, j, k);
+                array<double, 3> const coords = center_coords(i, j, k);
+
+                for (boost::uint64_t a = 0; a < 3; ++a)
+                    max_speed[a] = (std::max)(max_speed[a]
+                      , science().max_eigenvalue(*this, u, coords, axis(a)));
+            }
+
+    return max_speed;
 } // }}}
 
 // NOTE: Should be thread-safe, offset_ and origin_ are only read, and never
@@ -293,6 +398,56 @@ double octree_server::z_face(boost::uint64_t i) const
         return double(offset_[2] + i) * dx_ - grid_dim - bw * dx0_;
 } // }}}
 
+double octree_server::face_coord(axis a, boost::uint64_t i) const
+{ // {{{
+    switch (a)
+    {
+        case x_axis: return x_face(i);
+        case y_axis: return y_face(i);
+        case z_axis: return z_face(i);
+        default: break;
+    }
+
+    OCTOPUS_ASSERT(false);
+    return 0.0;
+} // }}}
+
+void octree_server::compute_bounding_box()
+{ // {{{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    for (boost::uint64_t a = 0; a < 3; ++a)
+    {
+        bounds_lower_[a] = face_coord(axis(a), bw);
+        bounds_upper_[a] = face_coord(axis(a), gnx - bw);
+    }
+} // }}}
+
+bool octree_server::child_intersects(
+    child_index kid
+  , array<double, 3> const& lower
+  , array<double, 3> const& upper
+    ) const
+{ // {{{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+    boost::uint64_t const half = gnx / 2 - bw;
+
+    array<boost::uint64_t, 3> const k = kid.get_array<boost::uint64_t>();
+
+    for (boost::uint64_t a = 0; a < 3; ++a)
+    {
+        double const child_lower = face_coord(axis(a), bw + k[a] * half);
+        double const child_upper = face_coord(axis(a), bw + (k[a] + 1) * half);
+
+        if (upper[a] < child_lower || child_upper <= lower[a])
+            return false;
+    }
+
+    return true;
+} // }}}
+
 void octree_server::prepare_compute_queues()
 { // {{{
 /*
@@ -473,16 +628,35 @@ struct relatives
     }
 }; // }}}
 
-// IMPLEMENT: Pass only the state that is needed.
-void octree_server::create_child(
+boost::shared_ptr<vector4d<double> > octree_server::send_child_octant(
     child_index kid
-    )
+    ) const
 { // {{{
-    OCTOPUS_ASSERT_FMT_MSG(children_[kid] == hpx::invalid_id,
-        "child already exists, child(%1%)", kid);
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
 
-    relatives r(kid);
+    boost::uint64_t const half = gnx / 2 - bw;
+
+    boost::shared_ptr<vector4d<double> > octant
+        (new vector4d<double>(half + 2));
+
+    // The first interior cell of the octant, minus the border.
+    boost::uint64_t const i0 = bw + kid.x() * half - 1;
+    boost::uint64_t const j0 = bw + kid.y() * half - 1;
+    boost::uint64_t const k0 = bw + kid.z() * half - 1;
+
+    for (boost::uint64_t i = 0; i < half + 2; ++i)
+        for (boost::uint64_t j = 0; j < half + 2; ++j)
+            for (boost::uint64_t k = 0; k < half + 2; ++k)
+                (*octant)(i, j, k) = (*U_)(i0 + i, j0 + j, k0 + k);
 
+    return octant;
+} // }}}
+
+octree_init_data octree_server::child_init_data(
+    child_index kid
+    ) const
+{ // {{{
     octree_init_data kid_init;
 
     boost::uint64_t const bw = science().ghost_zone_length;
@@ -498,8 +672,20 @@ void octree_server::create_child(
     kid_init.origin   = origin_;
     kid_init.step     = step_;
 
-    // Create the child. 
-    octree_client kid_client(create_octree(kid_init, U_));
+    return kid_init;
+} // }}}
+
+void octree_server::create_child(
+    child_index kid
+    )
+{ // {{{
+    OCTOPUS_ASSERT_FMT_MSG(children_[kid] == hpx::invalid_id,
+        "child already exists, child(%1%)", kid);
+
+    // Create the child. It is only sent the part of our state that it is
+    // interpolated from, which is about 1/8th of U_.
+    octree_client kid_client(create_octree(child_init_data(kid)
+                                         , send_child_octant(kid)));
 
     OCTOPUS_ASSERT(kid_client != hpx::invalid_id);
 
@@ -664,12 +850,70 @@ void octree_server::tie_child_sibling(
 ///////////////////////////////////////////////////////////////////////////////
 // Ghost zone communication
 
+/// Returns the index of \a d in octree_server::diagonal_state_dependencies.
+inline boost::uint64_t diagonal_index(array<boost::int64_t, 3> const& d)
+{ // {{{
+    return boost::uint64_t((d[0] + 1) + 3 * (d[1] + 1) + 9 * (d[2] + 1));
+} // }}}
+
+/// Returns the direction opposite to \a d.
+inline array<boost::int64_t, 3> opposite_direction(
+    array<boost::int64_t, 3> const& d
+    )
+{ // {{{
+    array<boost::int64_t, 3> o;
+
+    for (std::size_t a = 0; a < 3; ++a)
+        o[a] = -d[a];
+
+    return o;
+} // }}}
+
+/// Returns the first zone, along one axis, of an edge or corner ghost zone
+/// whose sender is in direction \a d (along that axis) from us.
+inline boost::uint64_t diagonal_ghost_zone_begin(boost::int64_t d)
+{ // {{{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    if (d < 0)
+        return 0;
+    else if (0 < d)
+        return gnx - bw;
+    else
+        return bw;
+} // }}}
+
+/// Returns the first zone, along one axis, of the part of our interior that
+/// the node in direction \a d (along that axis) from us needs for its edge or
+/// corner ghost zone.
+inline boost::uint64_t diagonal_interior_begin(boost::int64_t d)
+{ // {{{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    if (0 < d)
+        return gnx - 2 * bw;
+    else
+        return bw;
+} // }}}
+
+/// Returns the length, along one axis, of an edge or corner ghost zone whose
+/// sender is in direction \a d (along that axis).
+inline boost::uint64_t diagonal_ghost_zone_length(boost::int64_t d)
+{ // {{{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    return (0 != d) ? bw : gnx - 2 * bw;
+} // }}}
+
 // REVIEW: I think step 2.) can come before step 1.).
 /// 0.) Push ghost zone data to our siblings and determine which ghost zones we
 ///     will receive.
-/// 1.) Wait for our ghost zones to be delivered by our siblings.
-/// 2.) Push ghost zone data to our nephews.
-void octree_server::communicate_ghost_zones(
+/// 1.) Once our ghost zones have been delivered by our siblings ...
+/// 2.) ... push ghost zone data to our nephews.
+hpx::future<void> octree_server::communicate_ghost_zones_async(
     boost::uint64_t phase
     )
 { // {{{
@@ -716,35 +960,99 @@ void octree_server::communicate_ghost_zones(
         }
     }
 
-    // Handle physical boundaries.
-    // FIXME: Optimize.
-    for (boost::uint64_t i = 0; i < 6; ++i)
-    {
-        face const fi = face(i);
+    if (config().wide_halos)
+        communicate_diagonal_ghost_zones(phase, dependencies);
 
-        if (physical_boundary == siblings_[i].kind())
-            map_ghost_zone(fi);
-    }
+    // Handle physical boundaries. Wide halos are mapped once the rest of our
+    // ghost zones have arrived (see push_nephew_ghost_zones).
+    else
+        map_physical_ghost_zones();
 
     ///////////////////////////////////////////////////////////////////////////
-    // Wait for our ghost zones to be delivered by our siblings.
-    for (boost::uint64_t i = 0; i < dependencies.size(); ++i)
-        dependencies[i].move();
+    // Once our ghost zones have been delivered by our siblings, push ghost zone
+    // data to our nephews.
+    return unwrap(hpx::when_all(dependencies).then(
+        boost::bind(&octree_server::push_nephew_ghost_zones,
+            this, phase, _1)));
+} // }}}
 
-    ///////////////////////////////////////////////////////////////////////////
-    // Push ghost zone data to our nephews.
-    std::vector<hpx::future<void> > nephews;
-    nephews.reserve(nephews_.size());
+void octree_server::exchange_ghost_zones(
+    boost::uint64_t phase
+    )
+{ // {{{
+    std::vector<hpx::future<void> > recursion_is_parallelism;
+    recursion_is_parallelism.reserve(8);
+
+    for (boost::uint64_t i = 0; i < 8; ++i)
+        if (hpx::invalid_id != children_[i])
+            recursion_is_parallelism.push_back
+                (hpx::async<exchange_ghost_zones_action>
+                    (children_[i].get_gid(), phase)); 
+
+    // Our siblings and nephews are exchanging concurrently.
+    communicate_ghost_zones(phase);
+
+    hpx::wait(recursion_is_parallelism); 
+} // }}}
+
+hpx::future<void> octree_server::push_nephew_ghost_zones(
+    boost::uint64_t phase ///< Bound parameter.
+  , dependencies_future dependencies
+    )
+{ // {{{
+    // Propagate errors.
+    get_dependencies(dependencies);
+
+    // Our nephews interpolate from these too.
+    if (config().wide_halos)
+        map_physical_ghost_zones();
+
+    std::vector<hpx::future<void> > sends;
+    sends.reserve(nephews_.size() + diagonal_nephews_.size());
 
     BOOST_FOREACH(state_interpolation_data const& nephew, nephews_) 
     {
-        nephews.push_back(nephew.subject.receive_ghost_zone_async
+        sends.push_back(nephew.subject.receive_ghost_zone_async
             (step_, phase, invert(nephew.direction),
                 send_interpolated_ghost_zone(nephew.direction
                                            , nephew.offset)));
     }
 
-    hpx::wait(nephews);
+    BOOST_FOREACH(diagonal_interpolation_data const& nephew, diagonal_nephews_)
+    {
+        sends.push_back(nephew.subject.receive_diagonal_ghost_zone_async
+            (step_, phase, opposite_direction(nephew.direction),
+                send_interpolated_diagonal_ghost_zone(nephew.direction
+                                                    , nephew.offset)));
+    }
+
+    // Propagate the errors of our nephews.
+    return when_all_sends(sends);
+} // }}}
+
+void octree_server::get_dependencies(
+    dependencies_future& dependencies
+    )
+{ // {{{
+    std::vector<hpx::future<void> > ready = dependencies.move();
+
+    for (boost::uint64_t i = 0; i < ready.size(); ++i)
+        ready[i].move();
+} // }}}
+
+hpx::future<void> octree_server::when_all_sends(
+    std::vector<hpx::future<void> >& sends
+    )
+{ // {{{
+    return hpx::when_all(sends).then(
+        boost::bind(&octree_server::get_sends, _1));
+} // }}}
+
+void octree_server::get_sends(
+    dependencies_future sends
+    )
+{ // {{{
+    get_dependencies(sends);
 } // }}}
 
 void octree_server::add_ghost_zone(
@@ -1511,6 +1819,11 @@ void octree_server::map_ghost_zone(
     boost::uint64_t const bw = science().ghost_zone_length;
     boost::uint64_t const gnx = config().grid_node_length;
 
+    // With wide halos, the edges and corners next to the face are mapped too
+    // (see map_physical_ghost_zones).
+    boost::uint64_t const first = config().wide_halos ? 0 : bw;
+    boost::uint64_t const last = gnx - first;
+
     switch (f)
     {
         ///////////////////////////////////////////////////////////////////////
@@ -1521,8 +1834,8 @@ void octree_server::map_ghost_zone(
         case XL:
         {
             for (boost::uint64_t i = bw; i < (2 * bw); ++i)
-                for (boost::uint64_t j = bw; j < (gnx - bw); ++j)
-                    for (boost::uint64_t k = bw; k < (gnx - bw); ++k) 
+                for (boost::uint64_t j = first; j < last; ++j)
+                    for (boost::uint64_t k = first; k < last; ++k) 
                     {
                         array<boost::uint64_t, 3> v =
 //                            map_location(f, gnx - 2 * bw + i, j, k);
@@ -1552,8 +1865,8 @@ void octree_server::map_ghost_zone(
         case XU:
         {
             for (boost::uint64_t i = gnx - 2 * bw; i < (gnx - bw); ++i)
-                for (boost::uint64_t j = bw; j < (gnx - bw); ++j)
-                    for (boost::uint64_t k = bw; k < (gnx - bw); ++k) 
+                for (boost::uint64_t j = first; j < last; ++j)
+                    for (boost::uint64_t k = first; k < last; ++k) 
                     {
                         array<boost::uint64_t, 3> v =
 //                            map_location(f, 2 * bw + i - gnx, j, k);
@@ -1584,9 +1897,9 @@ void octree_server::map_ghost_zone(
         ///         for k in [BW, GNX - BW)
         case YL:
         {
-            for (boost::uint64_t i = bw; i < (gnx - bw); ++i)
+            for (boost::uint64_t i = first; i < last; ++i)
                 for (boost::uint64_t j = bw; j < (2 * bw); ++j)
-                    for (boost::uint64_t k = bw; k < (gnx - bw); ++k) 
+                    for (boost::uint64_t k = first; k < last; ++k) 
                     {
                         array<boost::uint64_t, 3> v =
 //                            map_location(f, i, gnx - 2 * bw + j, k);
@@ -1615,9 +1928,9 @@ void octree_server::map_ghost_zone(
         ///         for k in [BW, GNX - BW)
         case YU:
         {
-            for (boost::uint64_t i = bw; i < (gnx - bw); ++i)
+            for (boost::uint64_t i = first; i < last; ++i)
                 for (boost::uint64_t j = gnx - 2 * bw; j < (gnx - bw); ++j)
-                    for (boost::uint64_t k = bw; k < (gnx - bw); ++k) 
+                    for (boost::uint64_t k = first; k < last; ++k) 
                     {
                         array<boost::uint64_t, 3> v =
 //                            map_location(f, i, 2 * bw + j - gnx, k);
@@ -1648,8 +1961,8 @@ void octree_server::map_ghost_zone(
         ///         for k in [0, BW)
         case ZL:
         {
-            for (boost::uint64_t i = bw; i < (gnx - bw); ++i)
-                for (boost::uint64_t j = bw; j < (gnx - bw); ++j) 
+            for (boost::uint64_t i = first; i < last; ++i)
+                for (boost::uint64_t j = first; j < last; ++j) 
                     for (boost::uint64_t k = bw; k < (2 * bw); ++k)
                     {
                         array<boost::uint64_t, 3> v =
@@ -1683,8 +1996,8 @@ void octree_server::map_ghost_zone(
         ///         for k in [GNX - BW, GNX)
         case ZU:
         {
-            for (boost::uint64_t i = bw; i < (gnx - bw); ++i)
-                for (boost::uint64_t j = bw; j < (gnx - bw); ++j) 
+            for (boost::uint64_t i = first; i < last; ++i)
+                for (boost::uint64_t j = first; j < last; ++j) 
                     for (boost::uint64_t k = gnx - 2 * bw; k < (gnx - bw); ++k)
                     {
                         array<boost::uint64_t, 3> v =  
@@ -1716,6 +2029,196 @@ void octree_server::map_ghost_zone(
     };
 } // }}}
 
+void octree_server::map_physical_ghost_zones()
+{ // {{{
+    // FIXME: Optimize.
+    for (boost::uint64_t i = 0; i < 6; ++i)
+    {
+        face const fi = face(i);
+
+        if (physical_boundary == siblings_[i].kind())
+            map_ghost_zone(fi);
+    }
+} // }}}
+
+void octree_server::communicate_diagonal_ghost_zones(
+    boost::uint64_t phase
+  , std::vector<hpx::future<void> >& dependencies
+    )
+{ // {{{
+    OCTOPUS_ASSERT_FMT_MSG(
+        phase < diagonal_ghost_zone_deps_.size(),
+        "phase (%1%) is greater than the diagonal ghost zone queue length "
+        "(%2%)",
+        phase % diagonal_ghost_zone_deps_.size());
+
+    // Set up callbacks which add the edge and corner ghost zones to our state
+    // when they arrive.
+    for (std::size_t i = 0; i < diagonal_directions_.size(); ++i)
+    {
+        array<boost::int64_t, 3> const& d = diagonal_directions_[i];
+
+        dependencies.push_back(
+            diagonal_ghost_zone_deps_[phase](diagonal_index(d)).then(
+                boost::bind(&octree_server::add_diagonal_ghost_zone_callback,
+                    this, d, _1)));
+    }
+
+    // Send out edge and corner ghost zone data for our neighbors on our
+    // level. Those on our children's level get theirs from
+    // push_nephew_ghost_zones.
+    for (std::size_t i = 0; i < diagonal_siblings_.size(); ++i)
+    {
+        diagonal_interpolation_data const& sib = diagonal_siblings_[i];
+
+        dependencies.push_back(sib.subject.receive_diagonal_ghost_zone_async
+            (step_, phase, opposite_direction(sib.direction),
+                send_diagonal_ghost_zone(sib.direction)));
+    }
+} // }}}
+
+void octree_server::receive_diagonal_ghost_zone(
+    boost::uint64_t step ///< For debugging purposes.
+  , boost::uint64_t phase
+  , array<boost::int64_t, 3> const& direction ///< Of the caller, from us.
+  , vector4d<double> const& zone
+    )
+{ // {{{
+    OCTOPUS_ASSERT_MSG(step_ == step,
+        "cross-timestep communication occurred, octree is ill-formed");
+
+    OCTOPUS_ASSERT_FMT_MSG(
+        phase < diagonal_ghost_zone_deps_.size(),
+        "phase (%1%) is greater than the diagonal ghost zone queue length "
+        "(%2%)",
+        phase % diagonal_ghost_zone_deps_.size());
+
+    diagonal_ghost_zone_deps_[phase](diagonal_index(direction)).post(zone);
+} // }}}
+
+void octree_server::add_diagonal_ghost_zone(
+    array<boost::int64_t, 3> const& direction ///< Of the sender, from us.
+  , BOOST_RV_REF(vector4d<double>) zone
+    )
+{ // {{{
+    array<boost::uint64_t, 3> begin;
+
+    for (std::size_t a = 0; a < 3; ++a)
+        begin[a] = diagonal_ghost_zone_begin(direction[a]);
+
+    OCTOPUS_ASSERT(zone.x_length() == diagonal_ghost_zone_length(direction[0]));
+    OCTOPUS_ASSERT(zone.y_length() == diagonal_ghost_zone_length(direction[1]));
+    OCTOPUS_ASSERT(zone.z_length() == diagonal_ghost_zone_length(direction[2]));
+
+    for (boost::uint64_t i = 0; i < zone.x_length(); ++i)
+        for (boost::uint64_t j = 0; j < zone.y_length(); ++j)
+            for (boost::uint64_t k = 0; k < zone.z_length(); ++k)
+                (*U_)(begin[0] + i, begin[1] + j, begin[2] + k)
+                    = zone(i, j, k);
+} // }}}
+
+vector4d<double> octree_server::send_diagonal_ghost_zone(
+    array<boost::int64_t, 3> const& direction
+    ) const
+{ // {{{
+    array<boost::uint64_t, 3> begin;
+
+    for (std::size_t a = 0; a < 3; ++a)
+        begin[a] = diagonal_interior_begin(direction[a]);
+
+    // The receiver sees us in the opposite direction, which has the same
+    // lengths.
+    vector4d<double> zone(diagonal_ghost_zone_length(direction[0])
+                        , diagonal_ghost_zone_length(direction[1])
+                        , diagonal_ghost_zone_length(direction[2]));
+
+    for (boost::uint64_t i = 0; i < zone.x_length(); ++i)
+        for (boost::uint64_t j = 0; j < zone.y_length(); ++j)
+            for (boost::uint64_t k = 0; k < zone.z_length(); ++k)
+                zone(i, j, k)
+                    = (*U_)(begin[0] + i, begin[1] + j, begin[2] + k);
+
+    return zone;
+} // }}}
+
+/// Each zone of the nephew is interpolated from the zone of ours that covers
+/// it, with minmod slopes along the axes of \a direction (like the face ghost
+/// zones of send_interpolated_ghost_zone, which only use the slope across
+/// the face). Our own ghost zones have to be current, because our zones next
+/// to the missing child are used for the slopes.
+vector4d<double> octree_server::send_interpolated_diagonal_ghost_zone(
+    array<boost::int64_t, 3> const& direction
+  , array<boost::int64_t, 3> const& offset
+    ) const
+{ // {{{
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    // The nephew sees our missing child in the opposite direction.
+    array<boost::uint64_t, 3> begin;
+
+    for (std::size_t a = 0; a < 3; ++a)
+        begin[a] = diagonal_ghost_zone_begin(-direction[a]);
+
+    vector4d<double> zone(diagonal_ghost_zone_length(direction[0])
+                        , diagonal_ghost_zone_length(direction[1])
+                        , diagonal_ghost_zone_length(direction[2]));
+
+    for (boost::uint64_t i = 0; i < zone.x_length(); ++i)
+        for (boost::uint64_t j = 0; j < zone.y_length(); ++j)
+            for (boost::uint64_t k = 0; k < zone.z_length(); ++k)
+            {
+                array<boost::uint64_t, 3> n;
+                n[0] = begin[0] + i;
+                n[1] = begin[1] + j;
+                n[2] = begin[2] + k;
+
+                // Our zone that covers the nephew's zone n, and which half of
+                // it n is in along each axis.
+                array<boost::uint64_t, 3> c;
+                bool upper[3];
+
+                for (std::size_t a = 0; a < 3; ++a)
+                {
+                    boost::int64_t const fine = offset[a] + boost::int64_t(n[a]);
+
+                    OCTOPUS_ASSERT(0 <= fine);
+
+                    c[a] = boost::uint64_t(fine / 2);
+                    upper[a] = (fine % 2) ? true : false;
+
+                    OCTOPUS_ASSERT(0 < c[a] && c[a] < gnx - 1);
+                }
+
+                state const& u = (*U_)(c[0], c[1], c[2]);
+
+                state v = u;
+
+                for (std::size_t a = 0; a < 3; ++a)
+                {
+                    if (0 == direction[a])
+                        continue;
+
+                    array<boost::uint64_t, 3> up = c;
+                    array<boost::uint64_t, 3> down = c;
+                    ++up[a];
+                    --down[a];
+
+                    state const slope
+                        = minmod((*U_)(up[0], up[1], up[2]) - u
+                               , u - (*U_)(down[0], down[1], down[2]));
+
+                    if (upper[a])
+                        v += slope * 0.25;
+                    else
+                        v -= slope * 0.25;
+                }
+
+                zone(i, j, k) = v;
+            }
+
+    return zone;
+} // }}}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Child -> parent injection of state.
 
@@ -1739,9 +2242,9 @@ void octree_server::child_to_parent_state_injection(
     child_to_parent_state_injection_kernel(phase); 
 } // }}}
 
-/// 0.) Wait for all children to signal us.
-/// 1.) Signal our parent.
-void octree_server::child_to_parent_state_injection_kernel(
+/// 0.) Once all children have signalled us ...
+/// 1.) ... signal our parent.
+hpx::future<void> octree_server::child_to_parent_state_injection_kernel_async(
     boost::uint64_t phase
     )
 { // {{{
@@ -1784,19 +2287,34 @@ void octree_server::child_to_parent_state_injection_kernel(
     }
 
     ///////////////////////////////////////////////////////////////////////////
-    // Wait for all children to signal us.
-    for (boost::uint64_t i = 0; i < dependencies.size(); ++i)
-        dependencies[i].move();
+    // Once all children have signalled us, send a signal to our parent.
+    return unwrap(hpx::when_all(dependencies).then(
+        boost::bind(&octree_server::push_child_state,
+            this, phase, _1)));
+} // }}}
 
-    ///////////////////////////////////////////////////////////////////////////
+hpx::future<void> octree_server::push_child_state(
+    boost::uint64_t phase ///< Bound parameter.
+  , dependencies_future dependencies
+    )
+{ // {{{
+    // Propagate errors.
+    get_dependencies(dependencies);
+
+    std::vector<hpx::future<void> > sends;
+
+    ///////////////////////////////////////////////////////////////////////////
     // Send a signal to our parent (if we have a parent). 
     if (parent_ != hpx::invalid_id)
     {
         OCTOPUS_ASSERT(level_ != 0);
 
-        parent_.receive_child_state(step_, phase,
-            get_child_index(), send_child_state());
+        sends.push_back(parent_.receive_child_state_async(step_, phase,
+            get_child_index(), send_child_state()));
     }
+
+    // Propagate the errors of our parent.
+    return when_all_sends(sends);
 } // }}}
 
 void octree_server::add_child_state(
@@ -1899,9 +2417,9 @@ void octree_server::child_to_parent_flux_injection(
     child_to_parent_flux_injection_kernel(phase); 
 } // }}}
 
-/// 0.) Wait for all children to signal us.
-/// 1.) Signal our parent.
-void octree_server::child_to_parent_flux_injection_kernel(
+/// 0.) Once all children have signalled us ...
+/// 1.) ... signal our parent.
+hpx::future<void> octree_server::child_to_parent_flux_injection_kernel_async(
     boost::uint64_t phase
     )
 { // {{{ 
@@ -2217,17 +2735,31 @@ void octree_server::child_to_parent_flux_injection_kernel(
     }
 
     ///////////////////////////////////////////////////////////////////////////
-    // Wait for all children to signal us.
-    for (boost::uint64_t i = 0; i < dependencies.size(); ++i)
-        dependencies[i].move();
+    // Once all children have signalled us, send out our flux adjustments.
+    return unwrap(hpx::when_all(dependencies).then(
+        boost::bind(&octree_server::push_child_flux,
+            this, phase, _1)));
+} // }}}
+
+hpx::future<void> octree_server::push_child_flux(
+    boost::uint64_t phase ///< Bound parameter.
+  , dependencies_future dependencies
+    )
+{ // {{{
+    // Propagate errors.
+    get_dependencies(dependencies);
+
+    std::vector<hpx::future<void> > sends;
 
     //////////////////////////////////////////////////////////////////////////
     // Send out flux adjustments. 
     if (parent_ == hpx::invalid_id)
-        return;
+        return when_all_sends(sends);
 
     OCTOPUS_ASSERT(level_ != 0);
 
+    sends.reserve(6);
+
     { // {{{ X flux
         boost::uint8_t cj = get_child_index().y();
         boost::uint8_t ck = get_child_index().z();
@@ -2249,8 +2781,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                 % boost::uint16_t(cj)
                 % boost::uint16_t(ck)
                 % siblings_[XL].get_oid()));
-            siblings_[XL].receive_child_flux(step_, phase,
-                get_flux_index(x_axis, l, cj, ck), send_child_flux(XL));
+            sends.push_back(siblings_[XL].receive_child_flux_async(
+                step_, phase, get_flux_index(x_axis, l, cj, ck)
+              , send_child_flux(XL)));
 
             if (get_child_index().x() == 0)
             {
@@ -2263,8 +2796,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                     % boost::uint16_t(cj)
                     % boost::uint16_t(ck)
                     % parent_.get_oid()));
-                parent_.receive_child_flux(step_, phase,
-                    get_flux_index(x_axis, 0, cj, ck), send_child_flux(XU));
+                sends.push_back(parent_.receive_child_flux_async(
+                    step_, phase, get_flux_index(x_axis, 0, cj, ck)
+                  , send_child_flux(XU)));
             }
         }
 
@@ -2285,8 +2819,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                 % boost::uint16_t(cj)
                 % boost::uint16_t(ck)
                 % parent_.get_oid()));
-            parent_.receive_child_flux(step_, phase,
-                get_flux_index(x_axis, l, cj, ck), send_child_flux(XU));
+            sends.push_back(parent_.receive_child_flux_async(
+                step_, phase, get_flux_index(x_axis, l, cj, ck)
+              , send_child_flux(XU)));
         }
 
         if (siblings_[XU].kind() == amr_boundary)
@@ -2308,8 +2843,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                 % boost::uint16_t(cj)
                 % boost::uint16_t(ck)
                 % siblings_[XU].get_oid()));
-            siblings_[XU].receive_child_flux(step_, phase,
-                get_flux_index(x_axis, l, cj, ck), send_child_flux(XU));
+            sends.push_back(siblings_[XU].receive_child_flux_async(
+                step_, phase, get_flux_index(x_axis, l, cj, ck)
+              , send_child_flux(XU)));
 
             if (get_child_index().x() == 1)
             {
@@ -2322,8 +2858,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                     % boost::uint16_t(cj)
                     % boost::uint16_t(ck)
                     % parent_.get_oid()));
-                parent_.receive_child_flux(step_, phase,
-                    get_flux_index(x_axis, 2, cj, ck), send_child_flux(XL));
+                sends.push_back(parent_.receive_child_flux_async(
+                    step_, phase, get_flux_index(x_axis, 2, cj, ck)
+                  , send_child_flux(XL)));
             }
         }
 
@@ -2344,8 +2881,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                 % boost::uint16_t(cj)
                 % boost::uint16_t(ck)
                 % parent_.get_oid()));
-            parent_.receive_child_flux(step_, phase,
-                get_flux_index(x_axis, l, cj, ck), send_child_flux(XL));
+            sends.push_back(parent_.receive_child_flux_async(
+                step_, phase, get_flux_index(x_axis, l, cj, ck)
+              , send_child_flux(XL)));
         }
     } // }}}
 
@@ -2370,8 +2908,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                 % boost::uint16_t(l)
                 % boost::uint16_t(ck)
                 % siblings_[YL].get_oid()));
-            siblings_[YL].receive_child_flux(step_, phase,
-                get_flux_index(y_axis, l, cj, ck), send_child_flux(YL));
+            sends.push_back(siblings_[YL].receive_child_flux_async(
+                step_, phase, get_flux_index(y_axis, l, cj, ck)
+              , send_child_flux(YL)));
 
             if (get_child_index().y() == 0)
             {
@@ -2384,8 +2923,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                     % 0
                     % boost::uint16_t(ck)
                     % parent_.get_oid()));
-                parent_.receive_child_flux(step_, phase,
-                    get_flux_index(y_axis, 0, cj, ck), send_child_flux(YU));
+                sends.push_back(parent_.receive_child_flux_async(
+                    step_, phase, get_flux_index(y_axis, 0, cj, ck)
+                  , send_child_flux(YU)));
             }
         }
 
@@ -2406,8 +2946,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                 % boost::uint16_t(l)
                 % boost::uint16_t(ck)
                 % parent_.get_oid()));
-            parent_.receive_child_flux(step_, phase,
-                get_flux_index(y_axis, l, cj, ck), send_child_flux(YU));
+            sends.push_back(parent_.receive_child_flux_async(
+                step_, phase, get_flux_index(y_axis, l, cj, ck)
+              , send_child_flux(YU)));
         }
 
         if (siblings_[YU].kind() == amr_boundary)
@@ -2427,8 +2968,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                 % boost::uint16_t(l)
                 % boost::uint16_t(ck)
                 % siblings_[YU].get_oid()));
-            siblings_[YU].receive_child_flux(step_, phase,
-                get_flux_index(y_axis, l, cj, ck), send_child_flux(YU));
+            sends.push_back(siblings_[YU].receive_child_flux_async(
+                step_, phase, get_flux_index(y_axis, l, cj, ck)
+              , send_child_flux(YU)));
 
             if (get_child_index().y() == 1)
             {
@@ -2441,8 +2983,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                     % 2
                     % boost::uint16_t(ck)
                     % parent_.get_oid()));
-                parent_.receive_child_flux(step_, phase,
-                    get_flux_index(y_axis, 2, cj, ck), send_child_flux(YL));
+                sends.push_back(parent_.receive_child_flux_async(
+                    step_, phase, get_flux_index(y_axis, 2, cj, ck)
+                  , send_child_flux(YL)));
             }
         }
 
@@ -2463,8 +3006,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                 % boost::uint16_t(l)
                 % boost::uint16_t(ck)
                 % parent_.get_oid()));
-            parent_.receive_child_flux(step_, phase,
-                get_flux_index(y_axis, l, cj, ck), send_child_flux(YL));
+            sends.push_back(parent_.receive_child_flux_async(
+                step_, phase, get_flux_index(y_axis, l, cj, ck)
+              , send_child_flux(YL)));
         }
     } // }}}
 
@@ -2489,8 +3033,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                 % boost::uint16_t(ck)
                 % boost::uint16_t(l)
                 % siblings_[ZL].get_oid()));
-            siblings_[ZL].receive_child_flux(step_, phase,
-                get_flux_index(z_axis, l, cj, ck), send_child_flux(ZL));
+            sends.push_back(siblings_[ZL].receive_child_flux_async(
+                step_, phase, get_flux_index(z_axis, l, cj, ck)
+              , send_child_flux(ZL)));
 
             if (get_child_index().z() == 0)
             {
@@ -2503,8 +3048,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                     % boost::uint16_t(ck)
                     % 0
                     % parent_.get_oid()));
-                parent_.receive_child_flux(step_, phase,
-                    get_flux_index(z_axis, 0, cj, ck), send_child_flux(ZU));
+                sends.push_back(parent_.receive_child_flux_async(
+                    step_, phase, get_flux_index(z_axis, 0, cj, ck)
+                  , send_child_flux(ZU)));
             }
         }
 
@@ -2525,8 +3071,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                 % boost::uint16_t(ck)
                 % boost::uint16_t(l)
                 % parent_.get_oid()));
-            parent_.receive_child_flux(step_, phase,
-                get_flux_index(z_axis, l, cj, ck), send_child_flux(ZU));
+            sends.push_back(parent_.receive_child_flux_async(
+                step_, phase, get_flux_index(z_axis, l, cj, ck)
+              , send_child_flux(ZU)));
         }
 
         if (siblings_[ZU].kind() == amr_boundary)
@@ -2546,8 +3093,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                 % boost::uint16_t(ck)
                 % boost::uint16_t(l)
                 % siblings_[ZU].get_oid()));
-            siblings_[ZU].receive_child_flux(step_, phase,
-                get_flux_index(z_axis, l, cj, ck), send_child_flux(ZU));
+            sends.push_back(siblings_[ZU].receive_child_flux_async(
+                step_, phase, get_flux_index(z_axis, l, cj, ck)
+              , send_child_flux(ZU)));
 
             if (get_child_index().z() == 1)
             {
@@ -2560,8 +3108,9 @@ void octree_server::child_to_parent_flux_injection_kernel(
                     % boost::uint16_t(ck)
                     % 2
                     % parent_.get_oid()));
-                parent_.receive_child_flux(step_, phase,
-                    get_flux_index(z_axis, 2, cj, ck), send_child_flux(ZL));
+                sends.push_back(parent_.receive_child_flux_async(
+                    step_, phase, get_flux_index(z_axis, 2, cj, ck)
+                  , send_child_flux(ZL)));
             }
         }
 
@@ -2582,10 +3131,14 @@ void octree_server::child_to_parent_flux_injection_kernel(
                 % boost::uint16_t(ck)
                 % boost::uint16_t(l)
                 % parent_.get_oid()));
-            parent_.receive_child_flux(step_, phase,
-                get_flux_index(z_axis, l, cj, ck), send_child_flux(ZL));
+            sends.push_back(parent_.receive_child_flux_async(
+                step_, phase, get_flux_index(z_axis, l, cj, ck)
+              , send_child_flux(ZL)));
         }
     } // }}}
+
+    // Propagate the errors of our receivers.
+    return when_all_sends(sends);
 } // }}}
 
 void octree_server::add_child_flux(
@@ -2599,6 +3152,16 @@ void octree_server::add_child_flux(
     boost::uint64_t const bw = science().ghost_zone_length;
     boost::uint64_t const gnx = config().grid_node_length;
 
+    double const dx_inv = 1.0 / dx_;
+
+    boost::uint64_t const p = flux_plane(i0, bw, gnx);
+
+    // The flux of our child replaces ours on its face, so the differentials
+    // of the zones on either side of the face (those that are not ghost
+    // zones) are corrected by the difference. Children on different axes
+    // correct the same zones.
+    mutex_type::scoped_lock l(mtx_);
+
     switch (a)
     {
         case x_axis:
@@ -2618,7 +3181,16 @@ void octree_server::add_child_flux(
                     boost::uint64_t const k0
                         = k + bw + ck * ((gnx / 2) - bw);
         
-                    FX_(i0, j0, k0) = flux(0, j, k); 
+                    state const delta = ( flux(0, j, k)
+                                        - differentials_->FX(p, j0, k0))
+                                      * dx_inv;
+
+                    if (bw < i0)
+                        differentials_->D(i0 - 1, j0, k0) -= delta;
+                    if (i0 < gnx - bw)
+                        differentials_->D(i0, j0, k0) += delta;
+
+                    differentials_->FX(p, j0, k0) = flux(0, j, k);
                 }
 
             break;
@@ -2641,7 +3213,16 @@ void octree_server::add_child_flux(
                     boost::uint64_t const k0
                         = k + bw + ck * ((gnx / 2) - bw);
         
-                    FY_(j0, i0, k0) = flux(j, 0, k); 
+                    state const delta = ( flux(j, 0, k)
+                                        - differentials_->FY(j0, p, k0))
+                                      * dx_inv;
+
+                    if (bw < i0)
+                        differentials_->D(j0, i0 - 1, k0) -= delta;
+                    if (i0 < gnx - bw)
+                        differentials_->D(j0, i0, k0) += delta;
+
+                    differentials_->FY(j0, p, k0) = flux(j, 0, k);
                 }
 
             break;
@@ -2664,7 +3245,16 @@ void octree_server::add_child_flux(
                     boost::uint64_t const k0
                         = k + bw + ck * ((gnx / 2) - bw);
         
-                    FZ_(j0, k0, i0) = flux(j, k, 0); 
+                    state const delta = ( flux(j, k, 0)
+                                        - differentials_->FZ(j0, k0, p))
+                                      * dx_inv;
+
+                    if (bw < i0)
+                        differentials_->D(j0, k0, i0 - 1) -= delta;
+                    if (i0 < gnx - bw)
+                        differentials_->D(j0, k0, i0) += delta;
+
+                    differentials_->FZ(j0, k0, p) = flux(j, k, 0);
                 }
 
             break;
@@ -2709,6 +3299,8 @@ vector4d<double> octree_server::send_child_flux(face f)
         default: break; 
     };
 
+    boost::uint64_t const p = flux_plane(i, bw, gnx);
+
     switch (f)
     {
         case XL:
@@ -2728,10 +3320,10 @@ vector4d<double> octree_server::send_child_flux(face f)
                     boost::uint64_t const jj = ((j + bw) / 2) - bw; 
                     boost::uint64_t const kk = ((k + bw) / 2) - bw; 
 
-                    flux(0, jj, kk) = ( FX_(i, j + 0, k + 0)
-                                      + FX_(i, j + 1, k + 0)
-                                      + FX_(i, j + 0, k + 1)
-                                      + FX_(i, j + 1, k + 1)) * 0.25;
+                    flux(0, jj, kk) = ( differentials_->FX(p, j + 0, k + 0)
+                                      + differentials_->FX(p, j + 1, k + 0)
+                                      + differentials_->FX(p, j + 0, k + 1)
+                                      + differentials_->FX(p, j + 1, k + 1)) * 0.25;
                 }
 
             return flux; 
@@ -2754,10 +3346,10 @@ vector4d<double> octree_server::send_child_flux(face f)
                     boost::uint64_t const jj = ((j + bw) / 2) - bw; 
                     boost::uint64_t const kk = ((k + bw) / 2) - bw; 
 
-                    flux(jj, 0, kk) = ( FY_(j + 0, i, k + 0)
-                                      + FY_(j + 1, i, k + 0)
-                                      + FY_(j + 0, i, k + 1)
-                                      + FY_(j + 1, i, k + 1)) * 0.25;
+                    flux(jj, 0, kk) = ( differentials_->FY(j + 0, p, k + 0)
+                                      + differentials_->FY(j + 1, p, k + 0)
+                                      + differentials_->FY(j + 0, p, k + 1)
+                                      + differentials_->FY(j + 1, p, k + 1)) * 0.25;
                 }
 
             return flux; 
@@ -2780,10 +3372,10 @@ vector4d<double> octree_server::send_child_flux(face f)
                     boost::uint64_t const jj = ((j + bw) / 2) - bw; 
                     boost::uint64_t const kk = ((k + bw) / 2) - bw; 
 
-                    flux(jj, kk, 0) = ( FZ_(j + 0, k + 0, i)
-                                      + FZ_(j + 1, k + 0, i)
-                                      + FZ_(j + 0, k + 1, i)
-                                      + FZ_(j + 1, k + 1, i)) * 0.25;
+                    flux(jj, kk, 0) = ( differentials_->FZ(j + 0, k + 0, p)
+                                      + differentials_->FZ(j + 1, k + 0, p)
+                                      + differentials_->FZ(j + 0, k + 1, p)
+                                      + differentials_->FZ(j + 1, k + 1, p)) * 0.25;
                 }
 
             return flux; 
@@ -2802,6 +3394,13 @@ void octree_server::apply(
     hpx::util::function<void(octree_server&)> const& f
     )
 { // {{{
+    // The whole tree is visited per locality, without walking it.
+    if (0 == level_)
+    {
+        apply_by_locality(f);
+        return;
+    }
+
     std::vector<hpx::future<void> > recursion_is_parallelism;
     
     recursion_is_parallelism.reserve(8);
@@ -2841,268 +3440,771 @@ void octree_server::step_recurse(double dt)
     hpx::wait(recursion_is_parallelism); 
 } // }}}
 
-void octree_server::step_kernel(double dt)
+double octree_server::step_with_cfl_recurse(
+    double cfl_factor
+  , double max_dt
+    )
 { // {{{
-    U0_.reset(new vector4d<double>(*U_));
-    FO0_.reset(new state(*FO_));
+    std::vector<hpx::future<double> > recursion_is_parallelism;
+    recursion_is_parallelism.reserve(8);
 
-    prepare_compute_queues();
+    OCTOPUS_ASSERT_MSG(0 < cfl_factor, "invalid CFL factor");
+    OCTOPUS_ASSERT_MSG(0 < max_dt, "invalid maximum timestep size");
 
-    // We do TVD RK3.
-    switch (config().runge_kutta_order)
-    {
-        case 1:
-        {
-            sub_step_kernel(0, dt, 1.0);
-            break;
-        }
+    // Start recursively executing the kernel function on our children.
+    for (boost::uint64_t i = 0; i < 8; ++i)
+        if (hpx::invalid_id != children_[i])
+            recursion_is_parallelism.push_back
+                (hpx::async<step_with_cfl_recurse_action>
+                    (children_[i].get_gid(), cfl_factor, max_dt)); 
 
-        case 2:
-        {
-            sub_step_kernel(0, dt, 1.0);
-            sub_step_kernel(1, dt, 0.5);
-            break; 
-        }
+    // Kernel.
+    double const cfl_dt = step_with_cfl_kernel(cfl_factor, max_dt);
 
-        case 3:
-        {
-            sub_step_kernel(0, dt, 1.0);
-            sub_step_kernel(1, dt, 0.25);
-            sub_step_kernel(2, dt, 2.0 / 3.0);
-            break; 
-        }
+    // Block while our children compute.
+    hpx::wait(recursion_is_parallelism); 
 
-        default:
-        {
-            OCTOPUS_ASSERT_FMT_MSG(false,
-                "runge-kutta order (%1%) is unsupported or invalid",
-                config().runge_kutta_order);
-        }
-    };
+    return cfl_dt;
+} // }}}
 
-    communicate_ghost_zones(config().runge_kutta_order/*, l*/);
+void octree_server::step()
+{ // {{{
+    OCTOPUS_ASSERT(0 == level_);
 
-    ++step_;
-    time_ += dt;
+    if (config().batched_stepping)
+        step_batched(get_dt());
+    else
+        step_recurse(get_dt());
 } // }}}
 
-// Two communication phases.
-void octree_server::sub_step_kernel(
-    boost::uint64_t phase
-  , double dt
-  , double beta
-    )
+double octree_server::runge_kutta_beta(boost::uint64_t phase)
 { // {{{
-    communicate_ghost_zones(phase);
+    return octopus::runge_kutta_beta(config().runge_kutta_order, phase);
+} // }}}
 
-    //prepare_differentials_kernel();
+double octree_server::low_storage_runge_kutta_a(boost::uint64_t phase)
+{ // {{{
+    return octopus::low_storage_runge_kutta_a
+        (config().runge_kutta_order, phase);
+} // }}}
 
-    // Operations parallelizes by axis.
-    compute_flux_kernel(phase + 1);
+double octree_server::low_storage_runge_kutta_b(boost::uint64_t phase)
+{ // {{{
+    return octopus::low_storage_runge_kutta_b
+        (config().runge_kutta_order, phase);
+} // }}}
+
+boost::uint64_t octree_server::stencil_width()
+{ // {{{
+    if (config().wide_halos)
+        return science().ghost_zone_length / config().runge_kutta_order;
+    else
+        return science().ghost_zone_length;
+} // }}}
 
-    child_to_parent_flux_injection_kernel(phase);
+boost::uint64_t octree_server::update_extension(boost::uint64_t phase)
+{ // {{{
+    OCTOPUS_ASSERT(phase < config().runge_kutta_order);
 
-    sum_differentials_kernel();
-    add_differentials_kernel(dt, beta);
+    if (!config().wide_halos)
+        return 0;
 
-    child_to_parent_state_injection_kernel(phase + 1);
+    // Each sub step uses up stencil_width() zones of valid ghost zones.
+    return (config().runge_kutta_order - phase - 1) * stencil_width();
 } // }}}
 
-void octree_server::add_differentials_kernel(double dt, double beta)
+bool octree_server::exchanges_ghost_zones(boost::uint64_t phase)
 { // {{{
-    boost::uint64_t const bw = science().ghost_zone_length;
-    boost::uint64_t const gnx = config().grid_node_length;
+    return !config().wide_halos
+        || (0 == phase)
+        || (config().runge_kutta_order == phase);
+} // }}}
 
-    indexer2d<1> const indexer(bw, gnx - bw - 1, bw, gnx - bw - 1);
-    for (boost::uint64_t index = 0; index <= indexer.maximum; ++index)
+void octree_server::begin_step_stage()
+{ // {{{
+    // The low-storage scheme only needs U_ and D. D holds a register between
+    // sub steps there; TVD Runge Kutta clears it in add_differentials_kernel
+    // instead of allocating it for every sub step. Either way the
+    // differentials are kept for the whole step. U0_ is copied by the first
+    // update_stage, once our ghost zones have arrived.
+    if (config().low_storage_runge_kutta)
     {
-        for (boost::uint64_t i = bw; i < gnx - bw; ++i)
-        {
-            boost::uint64_t k = indexer.y(index);
-            boost::uint64_t j = indexer.x(index);
+        U0_.reset();
+        FO0_.reset();
+    }
 
-            array<double, 3> c = center_coords(i, j, k);
+    else
+        FO0_.reset(new state(*FO_));
 
-            D_(i, j, k) += science().source(*this, (*U_)(i, j, k), c);
+    create_differentials();
 
-            // Discretization. 
-            (*U_)(i, j, k) = (*U_)(i, j, k) * beta + D_(i, j, k) * dt * beta
-                           + (*U0_)(i, j, k) * (1.0 - beta); 
+    // The flux kernels take the maximum over the sub steps.
+    max_wave_speed_ = array<double, 3>();
 
-            science().enforce_limits((*U_)(i, j, k), c);
+    prepare_compute_queues();
+} // }}}
 
-            for (boost::uint64_t l = 0; l < DFO_.size(); ++l)
-            {
-                D_(i, j, k)[l] = 0.0;
-            }
-        }
+hpx::future<void> octree_server::ghost_zone_stage_async(boost::uint64_t phase)
+{ // {{{
+    hpx::util::high_resolution_timer t;
+
+    // With wide halos, the ghost zones of the other nodes are still good for
+    // this sub step; only the physical boundaries are mapped again.
+    if (!exchanges_ghost_zones(phase))
+    {
+        map_physical_ghost_zones();
+
+        timings_.add(ghost_zone_phase, t.elapsed());
+
+        hpx::lcos::local::promise<void> p;
+        hpx::future<void> f = p.get_future();
+        p.set_value();
+        return f;
     }
 
-    (*FO_) = ((*FO_) + DFO_ * dt) * beta + (*FO0_) * (1.0 - beta);
+    return communicate_ghost_zones_async(phase).then(
+        boost::bind(&octree_server::add_stage_timing,
+            this, ghost_zone_phase, t, _1));
+} // }}}
 
-    for (boost::uint64_t i = 0; i < DFO_.size(); ++i)
-        DFO_[i] = 0.0;
+void octree_server::add_stage_timing(
+    cost_phase p ///< Bound parameter.
+  , hpx::util::high_resolution_timer const& t ///< Bound parameter.
+  , hpx::future<void> stage
+    )
+{ // {{{
+    // Propagate errors.
+    stage.move();
+
+    timings_.add(p, t.elapsed());
 } // }}}
 
-// REVIEW: Make this run only when debugging is enabled.
-void octree_server::prepare_differentials_kernel() 
+void octree_server::flux_stage(boost::uint64_t phase)
 { // {{{
-    boost::uint64_t const gnx = config().grid_node_length;
+    hpx::util::high_resolution_timer t;
 
-    for (boost::uint64_t i = 0; i < DFO_.size(); ++i)
-        DFO_[i] = 0.0;
+    //prepare_differentials_kernel();
 
-    OCTOPUS_ASSERT(D_.size() == (gnx * gnx * gnx)); 
-    for (boost::uint64_t i = 0; i < gnx; ++i)
-        for (boost::uint64_t j = 0; j < gnx; ++j)
-            for (boost::uint64_t k = 0; k < gnx; ++k)
-                for (boost::uint64_t l = 0; l < DFO_.size(); ++l)
-                {
-                    D_(i, j, k)[l] = 0.0;
-                }
-} // }}}
+    // Created by begin_step_stage.
+    OCTOPUS_ASSERT(differentials_);
 
-void octree_server::compute_flux_kernel(boost::uint64_t phase)
-{ // {{{ 
-    ////////////////////////////////////////////////////////////////////////////    
-    // Compute our own local fluxes locally in parallel. 
+    {
+        // The full fluxes are given back before we wait for anything, so that
+        // nodes waiting for their children do not hold them.
+        flux_scratch_lease f(local_flux_scratch_pool());
 
-    // Do two directions in other threads.
-    boost::array<hpx::future<void>, 2> xy =
-    { {
-        hpx::async(boost::bind
-            (&octree_server::compute_x_flux_kernel, this/*, boost::ref(l)*/))
-      , hpx::async(boost::bind
-            (&octree_server::compute_y_flux_kernel, this/*, boost::ref(l)*/))
-    } };
+        // Operations parallelizes by axis.
+        compute_flux_kernel(phase, *f);
 
-    // And do one here.
-    compute_z_flux_kernel(/*l*/);
+        sum_differentials_kernel(phase, *f);
+    }
 
-    // Wait for the local x and y fluxes to be computed.
-    xy[0].move();
-    xy[1].move();
+    timings_.add(flux_phase, t.elapsed());
 } // }}}
 
-void octree_server::compute_x_flux_kernel()
-{ // {{{ 
-    boost::uint64_t const bw = science().ghost_zone_length;
-    boost::uint64_t const gnx = config().grid_node_length;
+hpx::future<void> octree_server::flux_injection_stage_async(
+    boost::uint64_t phase
+    )
+{ // {{{
+    hpx::util::high_resolution_timer t;
 
-/*
-    vector2d<double> q0(gnx);
-    vector2d<double> ql(gnx);
-    vector2d<double> qr(gnx);
-*/
-    std::vector<state> q0(gnx);
-    std::vector<state> ql(gnx);
-    std::vector<state> qr(gnx);
+    return child_to_parent_flux_injection_kernel_async(phase).then(
+        boost::bind(&octree_server::add_stage_timing,
+            this, injection_phase, t, _1));
+} // }}}
 
-    indexer2d<1> const indexer(bw, gnx - bw - 1, bw, gnx - bw - 1);
-    for (boost::uint64_t index = 0; index <= indexer.maximum; ++index)
-    {
-        boost::uint64_t k = indexer.y(index);
-        boost::uint64_t j = indexer.x(index);
+void octree_server::update_stage(
+    boost::uint64_t phase
+  , double dt
+  , double beta
+    )
+{ // {{{
+    hpx::util::high_resolution_timer t;
 
-        for (boost::uint64_t i = 0; i < gnx; ++i)
-        {
-            q0[i] = (*U_)(i, j, k);
-    
-            array<double, 3> coords = center_coords(i, j, k);
-    
-            science().conserved_to_primitive(q0[i], coords);
-        }
-    
-        science().reconstruct(q0, ql, qr);
+    sum_flow_off_kernel();
 
-        for (boost::uint64_t i = bw; i < gnx - bw + 1; ++i)
-        {
-            array<double, 3> coords = x_face_coords(i, j, k);
-    
-            science().primitive_to_conserved(ql[i], coords);
-            science().primitive_to_conserved(qr[i], coords);
-    
-            double const a = (std::max)
-                (science().max_eigenvalue(*this, ql[i], coords, x_axis)
-               , science().max_eigenvalue(*this, qr[i], coords, x_axis));
-   
-            array<boost::uint64_t, 3> idx;
-            idx[0] = i;
-            idx[1] = j;
-            idx[2] = k;
-    
-            state
-                ql_flux = science().flux(*this, ql[i], coords, idx, x_axis),
-                qr_flux = science().flux(*this, qr[i], coords, idx, x_axis);
+    // With wide halos, the ghost zones of U0_ are the ones that arrived for
+    // the first sub step.
+    if (!config().low_storage_runge_kutta && (0 == phase))
+        U0_.reset(new vector4d<double>(*U_));
 
-            FX_(i, j, k) = ((ql_flux + qr_flux)
-                         - (qr[i] - ql[i]) * a) * 0.5;
-        }
-    }
+    if (config().low_storage_runge_kutta)
+        add_differentials_low_storage_kernel(phase, dt);
+    else
+        add_differentials_kernel(phase, dt, beta);
+
+    timings_.add(differential_phase, t.elapsed());
 } // }}}
 
-void octree_server::compute_y_flux_kernel()
-{ // {{{ 
-    boost::uint64_t const bw = science().ghost_zone_length;
-    boost::uint64_t const gnx = config().grid_node_length;
+hpx::future<void> octree_server::state_injection_stage_async(
+    boost::uint64_t phase
+    )
+{ // {{{
+    hpx::util::high_resolution_timer t;
 
-/*
-    vector2d<double> q0(gnx);
-    vector2d<double> ql(gnx);
-    vector2d<double> qr(gnx);
-*/
-    std::vector<state> q0(gnx);
-    std::vector<state> ql(gnx);
-    std::vector<state> qr(gnx);
+    return child_to_parent_state_injection_kernel_async(phase + 1).then(
+        boost::bind(&octree_server::add_stage_timing,
+            this, injection_phase, t, _1));
+} // }}}
 
-    indexer2d<1> const indexer(bw, gnx - bw - 1, bw, gnx - bw - 1);
-    for (boost::uint64_t index = 0; index <= indexer.maximum; ++index)
-    {
-        boost::uint64_t k = indexer.y(index);
-        boost::uint64_t i = indexer.x(index);
+void octree_server::create_differentials()
+{ // {{{
+    if (!differentials_)
+        differentials_.reset
+            (new flux_differentials(config().grid_node_length));
+} // }}}
 
-        for (boost::uint64_t j = 0; j < gnx; ++j)
-        {
-            q0[j] = (*U_)(i, j, k);
-    
-            array<double, 3> coords = center_coords(i, j, k);
-    
-            science().conserved_to_primitive(q0[j], coords);
-        }
-    
-        science().reconstruct(q0, ql, qr);
-    
-        for (boost::uint64_t j = bw; j < gnx - bw + 1; ++j)
-        {
-            array<double, 3> coords = y_face_coords(i, j, k);
-    
-            science().primitive_to_conserved(ql[j], coords);
-            science().primitive_to_conserved(qr[j], coords);
-    
-            double const a = (std::max)
-                (science().max_eigenvalue(*this, ql[j], coords, y_axis)
-               , science().max_eigenvalue(*this, qr[j], coords, y_axis));
+void octree_server::drop_differentials()
+{ // {{{
+    differentials_.reset();
+} // }}}
 
-            array<boost::uint64_t, 3> idx;
-            idx[0] = i;
-            idx[1] = j;
-            idx[2] = k;
- 
-            state
-                ql_flux = science().flux(*this, ql[j], coords, idx, y_axis)
-              , qr_flux = science().flux(*this, qr[j], coords, idx, y_axis);
+void octree_server::end_step_stage(double dt)
+{ // {{{
+    drop_differentials();
 
-            FY_(i, j, k) = ((ql_flux + qr_flux)
-                         - (qr[j] - ql[j]) * a) * 0.5;
-        }
-    }
-} // }}}
+    ++step_;
+    time_ += dt;
 
-void octree_server::compute_z_flux_kernel()
+    {
+        mutex_type::scoped_lock l(mtx_);
+        timings_.commit();
+    }
+} // }}}
+
+void octree_server::step_kernel(double dt)
+{ // {{{
+    begin_step_stage();
+
+    // We do TVD RK3.
+    for (boost::uint64_t phase = 0; phase < config().runge_kutta_order; ++phase)
+        sub_step_kernel(phase, dt, runge_kutta_beta(phase));
+
+    if (config().final_ghost_zone_exchange)
+        ghost_zone_stage(config().runge_kutta_order);
+
+    end_step_stage(dt);
+} // }}}
+
+double octree_server::step_with_cfl_kernel(
+    double cfl_factor
+  , double max_dt
+    )
+{ // {{{
+    // Started at the end of the last step, from the wave speeds of its flux
+    // sweeps; the reduction runs while we exchange our ghost zones and
+    // compute and inject our first fluxes.
+    hpx::future<double> cfl_dt_f = next_cfl_dt_;
+    next_cfl_dt_ = hpx::future<double>();
+
+    begin_step_stage();
+
+    ghost_zone_stage(0);
+    flux_stage(0);
+
+    // There were no flux sweeps since the last regrid, so the timestep
+    // depends on the wave speeds of the sweep we just did. The reduction
+    // runs while the fluxes of the first sub step are injected.
+    if (!cfl_dt_f.valid())
+        cfl_dt_f = reduce_cfl_dt_async(cfl_factor);
+
+    flux_injection_stage(0);
+
+    // Only the update waits for the timestep.
+    double const cfl_dt = cfl_dt_f.move();
+    double const dt = (std::min)(cfl_dt, max_dt);
+
+    OCTOPUS_ASSERT_MSG(0 < dt, "invalid timestep size");
+
+    if (0 == level_)
+        post_dt(dt);
+
+    sub_step_update_kernel(0, dt, runge_kutta_beta(0));
+
+    for (boost::uint64_t phase = 1; phase < config().runge_kutta_order; ++phase)
+        sub_step_kernel(phase, dt, runge_kutta_beta(phase));
+
+    if (config().final_ghost_zone_exchange)
+        ghost_zone_stage(config().runge_kutta_order);
+
+    end_step_stage(dt);
+
+    // The largest wave speeds of all the sub steps of this step bound the
+    // timestep of the next one.
+    next_cfl_dt_ = reduce_cfl_dt_async(cfl_factor);
+
+    return cfl_dt;
+} // }}}
+
+hpx::future<double> octree_server::step_with_cfl_async(
+    double cfl_factor
+  , double max_dt
+    )
+{ // {{{
+    OCTOPUS_ASSERT(0 == level_);
+
+    return hpx::async(boost::bind(&octree_server::step_with_cfl_recurse,
+        this, cfl_factor, max_dt));
+} // }}}
+
+void octree_server::drop_next_cfl_dt()
+{ // {{{
+    hpx::future<double> cfl_dt_f = next_cfl_dt_;
+    next_cfl_dt_ = hpx::future<double>();
+
+    // Propagate errors.
+    if (cfl_dt_f.valid())
+        cfl_dt_f.move();
+} // }}}
+
+hpx::future<double> octree_server::reduce_cfl_dt_async(
+    double cfl_factor
+    )
+{ // {{{
+    double const cfl_dt
+        = cfl_dt_from_wave_speeds(cfl_factor, dx_, max_wave_speed_);
+
+    std::vector<hpx::future<double> > children_dt;
+    children_dt.reserve(8);
+
+    for (boost::uint64_t i = 0; i < 8; ++i)
+        if (hpx::invalid_id != children_[i])
+            children_dt.push_back(children_dt_deps_[i].get_future());
+
+    hpx::future<double> subtree_dt = hpx::when_all(children_dt).then(
+        boost::bind(&octree_server::combine_cfl_dt, this, cfl_dt, _1));
+
+    if (0 == level_)
+        return unwrap(subtree_dt.then(
+            boost::bind(&octree_server::broadcast_root_dt, this, _1)));
+
+    // Ready once our parent has the CFL timestep of our subtree.
+    subtree_dt = unwrap(subtree_dt.then(
+        boost::bind(&octree_server::push_child_dt, this, _1)));
+
+    std::vector<hpx::future<double> > dependencies;
+    dependencies.reserve(2);
+
+    dependencies.push_back(step_dt_dep_.get_future());
+    dependencies.push_back(subtree_dt);
+
+    return unwrap(hpx::when_all(dependencies).then(
+        boost::bind(&octree_server::receive_step_dt_callback, this, _1)));
+} // }}}
+
+double octree_server::combine_cfl_dt(
+    double cfl_dt ///< Bound parameter.
+  , dt_dependencies_future children_dt
+    )
+{ // {{{
+    std::vector<hpx::future<double> > v = children_dt.move();
+
+    // Propagate errors.
+    for (boost::uint64_t i = 0; i < v.size(); ++i)
+        cfl_dt = (std::min)(cfl_dt, v[i].move());
+
+    for (boost::uint64_t i = 0; i < 8; ++i)
+        if (hpx::invalid_id != children_[i])
+            children_dt_deps_[i].reset();
+
+    return cfl_dt;
+} // }}}
+
+hpx::future<double> octree_server::push_child_dt(
+    hpx::future<double> subtree_dt
+    )
+{ // {{{
+    double const cfl_dt = subtree_dt.move();
+
+    OCTOPUS_ASSERT(0 != level_);
+
+    // Propagate the errors of our parent.
+    return parent_.receive_child_dt_async(step_, get_child_index(), cfl_dt)
+        .then(boost::bind(&octree_server::dt_sent, cfl_dt, _1));
+} // }}}
+
+hpx::future<double> octree_server::broadcast_root_dt(
+    hpx::future<double> cfl_dt
+    )
+{ // {{{
+    double const dt = cfl_dt.move();
+
+    OCTOPUS_ASSERT_MSG(0 < dt, "invalid CFL timestep size");
+
+    return broadcast_step_dt(dt);
+} // }}}
+
+hpx::future<double> octree_server::receive_step_dt_callback(
+    dt_dependencies_future dependencies
+    )
+{ // {{{
+    std::vector<hpx::future<double> > v = dependencies.move();
+
+    OCTOPUS_ASSERT(2 == v.size());
+
+    double const dt = v[0].move();
+
+    // Propagate errors.
+    v[1].move();
+
+    step_dt_dep_.reset();
+
+    OCTOPUS_ASSERT_MSG(0 < dt, "invalid CFL timestep size");
+
+    return broadcast_step_dt(dt);
+} // }}}
+
+hpx::future<double> octree_server::broadcast_step_dt(
+    double dt
+    )
+{ // {{{
+    std::vector<hpx::future<void> > sends;
+    sends.reserve(8);
+
+    for (boost::uint64_t i = 0; i < 8; ++i)
+        if (hpx::invalid_id != children_[i])
+            sends.push_back(children_[i].receive_step_dt_async(step_, dt));
+
+    // Propagate the errors of our children.
+    return when_all_sends(sends).then(
+        boost::bind(&octree_server::dt_sent, dt, _1));
+} // }}}
+
+double octree_server::dt_sent(
+    double dt ///< Bound parameter.
+  , hpx::future<void> sends
+    )
+{ // {{{
+    // Propagate errors.
+    sends.move();
+
+    return dt;
+} // }}}
+
+// Two communication phases.
+void octree_server::sub_step_kernel(
+    boost::uint64_t phase
+  , double dt
+  , double beta
+    )
+{ // {{{
+    sub_step_flux_kernel(phase);
+    sub_step_update_kernel(phase, dt, beta);
+} // }}}
+
+void octree_server::sub_step_flux_kernel(
+    boost::uint64_t phase
+    )
+{ // {{{
+    ghost_zone_stage(phase);
+    flux_stage(phase);
+    flux_injection_stage(phase);
+} // }}}
+
+void octree_server::sub_step_update_kernel(
+    boost::uint64_t phase
+  , double dt
+  , double beta
+    )
+{ // {{{
+    update_stage(phase, dt, beta);
+    state_injection_stage(phase);
+} // }}}
+
+void octree_server::add_differentials_kernel(
+    boost::uint64_t phase
+  , double dt
+  , double beta
+    )
+{ // {{{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    // Our interior, plus the ghost zones that later sub steps read.
+    boost::uint64_t const lo = bw - update_extension(phase);
+    boost::uint64_t const hi = gnx - lo;
+
+    indexer2d<1> const indexer(lo, hi - 1, lo, hi - 1);
+    for (boost::uint64_t index = 0; index <= indexer.maximum; ++index)
+    {
+        for (boost::uint64_t i = lo; i < hi; ++i)
+        {
+            boost::uint64_t k = indexer.y(index);
+            boost::uint64_t j = indexer.x(index);
+
+            array<double, 3> c = center_coords(i, j, k);
+
+            differentials_->D(i, j, k) += science().source(*this, (*U_)(i, j, k), c);
+
+            // Discretization. 
+            (*U_)(i, j, k) = (*U_)(i, j, k) * beta + differentials_->D(i, j, k) * dt * beta
+                           + (*U0_)(i, j, k) * (1.0 - beta); 
+
+            science().enforce_limits((*U_)(i, j, k), c);
+
+            // Consumed; the next sub step sums into it again.
+            differentials_->D(i, j, k) = state();
+        }
+    }
+
+    (*FO_) = ((*FO_) + DFO_ * dt) * beta + (*FO0_) * (1.0 - beta);
+
+    for (boost::uint64_t i = 0; i < DFO_.size(); ++i)
+        DFO_[i] = 0.0;
+} // }}}
+
+/// 2N-storage scheme (see runge_kutta.hpp): D (and DFO_) is the second
+/// register. On
+/// entry it holds A(phase) times the register of the previous sub step plus
+/// the flux differentials of this sub step (see sum_differentials_kernel).
+///
+///     D += source
+///     U += D * dt * B(phase)
+///     D *= A(phase + 1)
+///
+/// A(0) is 0, so D is zero again after the last sub step.
+void octree_server::add_differentials_low_storage_kernel(
+    boost::uint64_t phase
+  , double dt
+    )
+{ // {{{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    double const b = low_storage_runge_kutta_b(phase);
+
+    double const a_next = (phase + 1 < config().runge_kutta_order)
+                        ? low_storage_runge_kutta_a(phase + 1)
+                        : 0.0;
+
+    // See add_differentials_kernel. A zone is updated by the sub steps
+    // 0 through N for some N, so its register stays consistent.
+    boost::uint64_t const lo = bw - update_extension(phase);
+    boost::uint64_t const hi = gnx - lo;
+
+    indexer2d<1> const indexer(lo, hi - 1, lo, hi - 1);
+    for (boost::uint64_t index = 0; index <= indexer.maximum; ++index)
+    {
+        for (boost::uint64_t i = lo; i < hi; ++i)
+        {
+            boost::uint64_t k = indexer.y(index);
+            boost::uint64_t j = indexer.x(index);
+
+            array<double, 3> c = center_coords(i, j, k);
+
+            differentials_->D(i, j, k) += science().source(*this, (*U_)(i, j, k), c);
+
+            // Discretization. 
+            (*U_)(i, j, k) += differentials_->D(i, j, k) * dt * b;
+
+            science().enforce_limits((*U_)(i, j, k), c);
+
+            differentials_->D(i, j, k) = differentials_->D(i, j, k) * a_next;
+        }
+    }
+
+    (*FO_) += DFO_ * dt * b;
+
+    DFO_ = DFO_ * a_next;
+} // }}}
+
+// REVIEW: Make this run only when debugging is enabled.
+void octree_server::prepare_differentials_kernel() 
+{ // {{{
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    for (boost::uint64_t i = 0; i < DFO_.size(); ++i)
+        DFO_[i] = 0.0;
+
+    OCTOPUS_ASSERT(differentials_->D.size() == (gnx * gnx * gnx)); 
+    for (boost::uint64_t i = 0; i < gnx; ++i)
+        for (boost::uint64_t j = 0; j < gnx; ++j)
+            for (boost::uint64_t k = 0; k < gnx; ++k)
+                for (boost::uint64_t l = 0; l < DFO_.size(); ++l)
+                {
+                    differentials_->D(i, j, k)[l] = 0.0;
+                }
+} // }}}
+
+void octree_server::compute_flux_kernel(
+    boost::uint64_t phase
+  , flux_scratch& f
+    )
+{ // {{{ 
+    ////////////////////////////////////////////////////////////////////////////    
+    // Compute our own local fluxes locally in parallel. 
+
+    // Do two directions in other threads.
+    boost::array<hpx::future<void>, 2> xy =
+    { {
+        hpx::async(boost::bind
+            (&octree_server::compute_x_flux_kernel, this, phase, boost::ref(f)))
+      , hpx::async(boost::bind
+            (&octree_server::compute_y_flux_kernel, this, phase, boost::ref(f)))
+    } };
+
+    // And do one here.
+    compute_z_flux_kernel(phase, f);
+
+    // Wait for the local x and y fluxes to be computed.
+    xy[0].move();
+    xy[1].move();
+} // }}}
+
+void octree_server::compute_x_flux_kernel(
+    boost::uint64_t phase
+  , flux_scratch& f
+    )
+{ // {{{ 
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    // The faces of the zones that add_differentials_kernel updates.
+    boost::uint64_t const lo = bw - update_extension(phase);
+    boost::uint64_t const hi = gnx - lo;
+
+/*
+    vector2d<double> q0(gnx);
+    vector2d<double> ql(gnx);
+    vector2d<double> qr(gnx);
+*/
+    std::vector<state> q0(gnx);
+    std::vector<state> ql(gnx);
+    std::vector<state> qr(gnx);
+
+    double max_speed = 0.0;
+
+    indexer2d<1> const indexer(lo, hi - 1, lo, hi - 1);
+    for (boost::uint64_t index = 0; index <= indexer.maximum; ++index)
+    {
+        boost::uint64_t k = indexer.y(index);
+        boost::uint64_t j = indexer.x(index);
+
+        for (boost::uint64_t i = 0; i < gnx; ++i)
+        {
+            q0[i] = (*U_)(i, j, k);
+    
+            array<double, 3> coords = center_coords(i, j, k);
+    
+            science().conserved_to_primitive(q0[i], coords);
+        }
+    
+        science().reconstruct(q0, ql, qr);
+
+        for (boost::uint64_t i = lo; i < hi + 1; ++i)
+        {
+            array<double, 3> coords = x_face_coords(i, j, k);
+    
+            science().primitive_to_conserved(ql[i], coords);
+            science().primitive_to_conserved(qr[i], coords);
+    
+            double const a = (std::max)
+                (science().max_eigenvalue(*this, ql[i], coords, x_axis)
+               , science().max_eigenvalue(*this, qr[i], coords, x_axis));
+
+            max_speed = (std::max)(max_speed, a);
+   
+            array<boost::uint64_t, 3> idx;
+            idx[0] = i;
+            idx[1] = j;
+            idx[2] = k;
+    
+            state
+                ql_flux = science().flux(*this, ql[i], coords, idx, x_axis),
+                qr_flux = science().flux(*this, qr[i], coords, idx, x_axis);
+
+            f.FX(i, j, k) = ((ql_flux + qr_flux)
+                         - (qr[i] - ql[i]) * a) * 0.5;
+        }
+    }
+
+    // Keep the largest speed of all the sub steps of this timestep.
+    max_wave_speed_[x_axis] = (std::max)(max_wave_speed_[x_axis], max_speed);
+} // }}}
+
+void octree_server::compute_y_flux_kernel(
+    boost::uint64_t phase
+  , flux_scratch& f
+    )
+{ // {{{ 
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    // See compute_x_flux_kernel.
+    boost::uint64_t const lo = bw - update_extension(phase);
+    boost::uint64_t const hi = gnx - lo;
+
+/*
+    vector2d<double> q0(gnx);
+    vector2d<double> ql(gnx);
+    vector2d<double> qr(gnx);
+*/
+    std::vector<state> q0(gnx);
+    std::vector<state> ql(gnx);
+    std::vector<state> qr(gnx);
+
+    double max_speed = 0.0;
+
+    indexer2d<1> const indexer(lo, hi - 1, lo, hi - 1);
+    for (boost::uint64_t index = 0; index <= indexer.maximum; ++index)
+    {
+        boost::uint64_t k = indexer.y(index);
+        boost::uint64_t i = indexer.x(index);
+
+        for (boost::uint64_t j = 0; j < gnx; ++j)
+        {
+            q0[j] = (*U_)(i, j, k);
+    
+            array<double, 3> coords = center_coords(i, j, k);
+    
+            science().conserved_to_primitive(q0[j], coords);
+        }
+    
+        science().reconstruct(q0, ql, qr);
+    
+        for (boost::uint64_t j = lo; j < hi + 1; ++j)
+        {
+            array<double, 3> coords = y_face_coords(i, j, k);
+    
+            science().primitive_to_conserved(ql[j], coords);
+            science().primitive_to_conserved(qr[j], coords);
+    
+            double const a = (std::max)
+                (science().max_eigenvalue(*this, ql[j], coords, y_axis)
+               , science().max_eigenvalue(*this, qr[j], coords, y_axis));
+
+            max_speed = (std::max)(max_speed, a);
+
+            array<boost::uint64_t, 3> idx;
+            idx[0] = i;
+            idx[1] = j;
+            idx[2] = k;
+ 
+            state
+                ql_flux = science().flux(*this, ql[j], coords, idx, y_axis)
+              , qr_flux = science().flux(*this, qr[j], coords, idx, y_axis);
+
+            f.FY(i, j, k) = ((ql_flux + qr_flux)
+                         - (qr[j] - ql[j]) * a) * 0.5;
+        }
+    }
+
+    // Keep the largest speed of all the sub steps of this timestep.
+    max_wave_speed_[y_axis] = (std::max)(max_wave_speed_[y_axis], max_speed);
+} // }}}
+
+void octree_server::compute_z_flux_kernel(
+    boost::uint64_t phase
+  , flux_scratch& f
+    )
 { // {{{ 
     boost::uint64_t const bw = science().ghost_zone_length;
     boost::uint64_t const gnx = config().grid_node_length;
 
+    // See compute_x_flux_kernel.
+    boost::uint64_t const lo = bw - update_extension(phase);
+    boost::uint64_t const hi = gnx - lo;
+
 /*
     vector2d<double> q0(gnx);
     vector2d<double> ql(gnx);
@@ -3112,7 +4214,9 @@ void octree_server::compute_z_flux_kernel()
     std::vector<state> ql(gnx);
     std::vector<state> qr(gnx);
 
-    indexer2d<1> const indexer(bw, gnx - bw - 1, bw, gnx - bw - 1);
+    double max_speed = 0.0;
+
+    indexer2d<1> const indexer(lo, hi - 1, lo, hi - 1);
     for (boost::uint64_t index = 0; index <= indexer.maximum; ++index)
     {
         boost::uint64_t j = indexer.y(index);
@@ -3129,7 +4233,7 @@ void octree_server::compute_z_flux_kernel()
     
         science().reconstruct(q0, ql, qr);
     
-        for (boost::uint64_t k = bw; k < gnx - bw + 1; ++k)
+        for (boost::uint64_t k = lo; k < hi + 1; ++k)
         {
             array<double, 3> coords = z_face_coords(i, j, k);
     
@@ -3140,6 +4244,8 @@ void octree_server::compute_z_flux_kernel()
                 (science().max_eigenvalue(*this, ql[k], coords, z_axis)
                , science().max_eigenvalue(*this, qr[k], coords, z_axis));
 
+            max_speed = (std::max)(max_speed, a);
+
             array<boost::uint64_t, 3> idx;
             idx[0] = i;
             idx[1] = j;
@@ -3150,74 +4256,175 @@ void octree_server::compute_z_flux_kernel()
               , qr_flux = science().flux(*this, qr[k], coords, idx, z_axis)
                 ;
      
-            FZ_(i, j, k) = ((ql_flux + qr_flux)
+            f.FZ(i, j, k) = ((ql_flux + qr_flux)
                          - (qr[k] - ql[k]) * a) * 0.5;
         }
     }
+
+    // Keep the largest speed of all the sub steps of this timestep.
+    max_wave_speed_[z_axis] = (std::max)(max_wave_speed_[z_axis], max_speed);
 } // }}}
 
-void octree_server::sum_differentials_kernel()
+void octree_server::sum_differentials_kernel(
+    boost::uint64_t phase
+  , flux_scratch const& f
+    )
 { // {{{ 
     boost::uint64_t const bw = science().ghost_zone_length;
     boost::uint64_t const gnx = config().grid_node_length;
 
+    // See add_differentials_kernel. The flux planes are still those of our
+    // faces.
+    boost::uint64_t const lo = bw - update_extension(phase);
+    boost::uint64_t const hi = gnx - lo;
+
     double const dx_inv = 1.0 / dx_;
 
+    vector4d<double>& D = differentials_->D;
+
     ///////////////////////////////////////////////////////////////////////////
     // Kernel.
     // NOTE: This is probably too tight a loop to parallelize with HPX, but
     // could be vectorized. 
     {
-        indexer2d<1> const indexer(bw, gnx - bw - 1, bw, gnx - bw - 1);
+        indexer2d<1> const indexer(lo, hi - 1, lo, hi - 1);
         for (boost::uint64_t index = 0; index <= indexer.maximum; ++index)
         {
             boost::uint64_t k = indexer.y(index);
             boost::uint64_t j = indexer.x(index);
 
-            for (boost::uint64_t i = bw; i < gnx - bw; ++i)
-                D_(i, j, k) -= FX_(i + 1, j, k) * dx_inv - FX_(i, j, k) * dx_inv;
+            for (boost::uint64_t i = lo; i < hi; ++i)
+                D(i, j, k) -= f.FX(i + 1, j, k) * dx_inv - f.FX(i, j, k) * dx_inv;
     
-            DFO_ += (FX_(gnx - bw, j, k) - FX_(bw, j, k)) * dx_ * dx_;
+            differentials_->FX(0, j, k) = f.FX(bw, j, k);
+            differentials_->FX(1, j, k) = f.FX(gnx / 2, j, k);
+            differentials_->FX(2, j, k) = f.FX(gnx - bw, j, k);
         }
     }
     
     {
-        indexer2d<1> const indexer(bw, gnx - bw - 1, bw, gnx - bw - 1);
+        indexer2d<1> const indexer(lo, hi - 1, lo, hi - 1);
         for (boost::uint64_t index = 0; index <= indexer.maximum; ++index)
         {
             boost::uint64_t k = indexer.y(index);
             boost::uint64_t j = indexer.x(index);
 
-            for (boost::uint64_t i = bw; i < gnx - bw; ++i)
-                D_(i, j, k) -= FY_(i, j + 1, k) * dx_inv - FY_(i, j, k) * dx_inv;
+            for (boost::uint64_t i = lo; i < hi; ++i)
+                D(i, j, k) -= f.FY(i, j + 1, k) * dx_inv - f.FY(i, j, k) * dx_inv;
     
-            DFO_ += (FY_(j, gnx - bw, k) - FY_(j, bw, k)) * dx_ * dx_;
+            differentials_->FY(j, 0, k) = f.FY(j, bw, k);
+            differentials_->FY(j, 1, k) = f.FY(j, gnx / 2, k);
+            differentials_->FY(j, 2, k) = f.FY(j, gnx - bw, k);
         }
     }
 
     {
-        indexer2d<1> const indexer(bw, gnx - bw - 1, bw, gnx - bw - 1);
+        indexer2d<1> const indexer(lo, hi - 1, lo, hi - 1);
         for (boost::uint64_t index = 0; index <= indexer.maximum; ++index)
         {
             boost::uint64_t k = indexer.y(index);
             boost::uint64_t j = indexer.x(index);
 
-            for (boost::uint64_t i = bw; i < gnx - bw; ++i)
-                D_(i, j, k) -= FZ_(i, j, k + 1) * dx_inv - FZ_(i, j, k) * dx_inv;
+            for (boost::uint64_t i = lo; i < hi; ++i)
+                D(i, j, k) -= f.FZ(i, j, k + 1) * dx_inv - f.FZ(i, j, k) * dx_inv;
     
-            if (config().reflect_on_z)
-                DFO_ += (FZ_(j, k, gnx - bw)) * dx_ * dx_;
-            else
-                DFO_ += (FZ_(j, k, gnx - bw) - FZ_(j, k, bw)) * dx_ * dx_;
+            differentials_->FZ(j, k, 0) = f.FZ(j, k, bw);
+            differentials_->FZ(j, k, 1) = f.FZ(j, k, gnx / 2);
+            differentials_->FZ(j, k, 2) = f.FZ(j, k, gnx - bw);
         }
     }
 } // }}}
 
+/// Runs after the fluxes of our children have been injected into the flux
+/// planes, so that the flow off through our faces includes them.
+void octree_server::sum_flow_off_kernel()
+{ // {{{ 
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    flux_differentials const& d = *differentials_;
+
+    indexer2d<1> const indexer(bw, gnx - bw - 1, bw, gnx - bw - 1);
+    for (boost::uint64_t index = 0; index <= indexer.maximum; ++index)
+    {
+        boost::uint64_t k = indexer.y(index);
+        boost::uint64_t j = indexer.x(index);
+
+        DFO_ += (d.FX(2, j, k) - d.FX(0, j, k)) * dx_ * dx_;
+        DFO_ += (d.FY(j, 2, k) - d.FY(j, 0, k)) * dx_ * dx_;
+
+        if (config().reflect_on_z)
+            DFO_ += (d.FZ(j, k, 2)) * dx_ * dx_;
+        else
+            DFO_ += (d.FZ(j, k, 2) - d.FZ(j, k, 0)) * dx_ * dx_;
+    }
+} // }}}
+
 void octree_server::copy_and_regrid()
 { // {{{ IMPLEMENT
     return;
 } // }}}
 
+/// Returns the direction of \a f, e.g. (-1, 0, 0) for XL.
+inline array<boost::int64_t, 3> face_direction(face f)
+{ // {{{
+    array<boost::int64_t, 3> d;
+    d[0] = 0;
+    d[1] = 0;
+    d[2] = 0;
+
+    switch (f)
+    {
+        case XL: d[0] = -1; break;
+        case XU: d[0] = +1; break;
+        case YL: d[1] = -1; break;
+        case YU: d[1] = +1; break;
+        case ZL: d[2] = -1; break;
+        case ZU: d[2] = +1; break;
+        default: OCTOPUS_ASSERT(false); break;
+    }
+
+    return d;
+} // }}}
+
+/// Returns the location of the neighbor of the node at \a location in the
+/// direction \a d, which must be inside of the domain.
+inline array<boost::uint64_t, 3> neighbor_location(
+    array<boost::uint64_t, 3> const& location
+  , array<boost::int64_t, 3> const& d
+    )
+{ // {{{
+    array<boost::uint64_t, 3> n;
+
+    for (std::size_t a = 0; a < 3; ++a)
+        n[a] = boost::uint64_t(boost::int64_t(location[a]) + d[a]);
+
+    return n;
+} // }}}
+
+/// Returns the offset of the node on \a level at \a location; this is the
+/// offset that child_init_data gives it.
+inline array<boost::int64_t, 3> node_offset(
+    boost::uint64_t level
+  , array<boost::uint64_t, 3> const& location
+    )
+{ // {{{
+    boost::int64_t const bw = science().ghost_zone_length;
+    boost::int64_t const gnx = config().grid_node_length;
+
+    boost::int64_t base = 0;
+
+    for (boost::uint64_t l = 0; l < level; ++l)
+        base = base * 2 + bw;
+
+    array<boost::int64_t, 3> o;
+
+    for (std::size_t a = 0; a < 3; ++a)
+        o[a] = base + boost::int64_t(location[a]) * (gnx - 2 * bw);
+
+    return o;
+} // }}}
+
 void octree_server::mark()
 { // {{{
     if (level_ == config().levels_of_refinement)
@@ -3245,7 +4452,7 @@ void octree_server::mark_kernel()
     OCTOPUS_ASSERT(level_ != config().levels_of_refinement);
 
     std::vector<hpx::future<void> > markings;
-    markings.reserve(8*3);
+    markings.reserve(8*7);
 
     mutex_type::scoped_lock l(mtx_);
 
@@ -3269,42 +4476,17 @@ void octree_server::mark_kernel()
 
             relatives r(kid);
 
-            OCTOPUS_ASSERT
-                (invalid_boundary != siblings_[r.exterior_x_face].kind());
-            OCTOPUS_ASSERT
-                (invalid_boundary != siblings_[r.exterior_y_face].kind());
-            OCTOPUS_ASSERT
-                (invalid_boundary != siblings_[r.exterior_z_face].kind());
-
-            if (amr_boundary == siblings_[r.exterior_x_face].kind())
-            {
-//                array<boost::uint64_t, 3> dep_location;
-//                dep_location = siblings_[r.exterior_x_face].get_location() * 2
-//                    + invert(r.exterior_x_face, get_child_index()).get_array();
-                markings.push_back
-                    (siblings_[r.exterior_x_face].require_child_async
-                        (invert(r.exterior_x_face, get_child_index())));
-            }
-
-            if (amr_boundary == siblings_[r.exterior_y_face].kind())
-            {
-//                array<boost::uint64_t, 3> dep_location;
-//                dep_location = siblings_[r.exterior_y_face].get_location() * 2
-//                    + invert(r.exterior_y_face, get_child_index()).get_array();
-                markings.push_back
-                    (siblings_[r.exterior_y_face].require_child_async
-                        (invert(r.exterior_y_face, get_child_index())));
-            }
-
-            if (amr_boundary == siblings_[r.exterior_z_face].kind())
-            {
-//                array<boost::uint64_t, 3> dep_location;
-//                dep_location = siblings_[r.exterior_z_face].get_location() * 2
-//                    + invert(r.exterior_z_face, get_child_index()).get_array();
-                markings.push_back
-                    (siblings_[r.exterior_z_face].require_child_async
-                        (invert(r.exterior_z_face, get_child_index())));
-            }
+            // Our neighbors across the new child's exterior faces must
+            // exist, or the tree would not be 2:1 balanced.
+            require_neighbor(markings, face_direction(r.exterior_x_face));
+            require_neighbor(markings, face_direction(r.exterior_y_face));
+            require_neighbor(markings, face_direction(r.exterior_z_face));
+
+            // Wide halos are exchanged across edges and corners too, so the
+            // tree has to be balanced across them as well (remark_kernel
+            // only does this for the marks that exist before it runs).
+            if (config().wide_halos)
+                require_diagonal_neighbors(markings, kid);
         }
     }
 
@@ -3324,94 +4506,443 @@ void octree_server::propagate_locked(
     OCTOPUS_ASSERT(children_[kid] == hpx::invalid_id);
 
     std::vector<hpx::future<void> > markings;
-    markings.reserve(3);
+    markings.reserve(7);
+
+    relatives r(kid);
+
+    require_neighbor(markings, face_direction(r.exterior_x_face));
+    require_neighbor(markings, face_direction(r.exterior_y_face));
+    require_neighbor(markings, face_direction(r.exterior_z_face));
+
+    // See mark_kernel.
+    if (config().wide_halos)
+        require_diagonal_neighbors(markings, kid);
 
-    array<boost::uint64_t, 3> kid_location;
-    kid_location = location_ * 2 + kid.get_array<boost::uint64_t>();
+    {
+        hpx::util::scoped_unlock<mutex_type::scoped_lock> ul(l);
+        hpx::wait(markings); 
+    }
+} // }}}
+
+void octree_server::require_neighbor(
+    std::vector<hpx::future<void> >& markings
+  , array<boost::int64_t, 3> const& direction
+    ) const
+{ // {{{
+    boost::optional<topology_entry> const n
+        = local_topology_index().find_neighbor(level_, location_, direction);
+
+    if (!n || n->level == level_)
+        return;
+
+    OCTOPUS_ASSERT(n->level < level_);
+
+    // The child of n that covers the neighbor.
+    array<boost::uint64_t, 3> const missing
+        = neighbor_location(location_, direction);
+
+    boost::uint64_t const shift = level_ - n->level - 1;
 
+    child_index const kid((missing[0] >> shift) & 1
+                        , (missing[1] >> shift) & 1
+                        , (missing[2] >> shift) & 1);
+
+    markings.push_back(octree_client(n->gid).require_child_async(kid));
+} // }}}
+
+void octree_server::require_diagonal_neighbors(
+    std::vector<hpx::future<void> >& markings
+  , child_index kid
+    ) const
+{ // {{{
     relatives r(kid);
 
-    if (amr_boundary == siblings_[r.exterior_x_face].kind())
+    array<boost::int64_t, 3> const x = face_direction(r.exterior_x_face);
+    array<boost::int64_t, 3> const y = face_direction(r.exterior_y_face);
+    array<boost::int64_t, 3> const z = face_direction(r.exterior_z_face);
+
+    require_neighbor(markings, x + y);
+    require_neighbor(markings, y + z);
+    require_neighbor(markings, z + x);
+    require_neighbor(markings, x + y + z);
+} // }}}
+
+/// Creates the new children of every node on the calling locality in bulk
+/// (see octree_server::populate_local_nodes).
+struct populate_locally
+{
+    void operator()() const
+    {
+        octree_server::populate_local_nodes();
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int)
+    {}
+};
+
+void octree_server::populate()
+{ // {{{
+    if (level_  == config().levels_of_refinement)
+        return;
+
+    if (config().bulk_child_creation && 0 == level_)
+    {
+        hpx::wait(call_everywhere(populate_locally()));
+        return;
+    }
+
+    std::vector<hpx::future<void> > recursion_is_parallelism;
+    recursion_is_parallelism.reserve(8); 
+
+    populate_kernel();
+
+    //sibling_refinement_signal(2);
+
+    for (std::size_t i = 0; i < 8; ++i)
+        if (  (hpx::invalid_id != children_[i])
+           && (level_ + 1) != config().levels_of_refinement)
+            recursion_is_parallelism.push_back
+                (children_[i].populate_async());
+
+    hpx::wait(recursion_is_parallelism);
+
+    //sibling_refinement_signal(3);
+} // }}}
+
+void octree_server::populate_kernel()
+{ // {{{ 
+    OCTOPUS_ASSERT(level_ != config().levels_of_refinement);
+
+    std::vector<hpx::future<void> > new_children;
+    new_children.reserve(8);
+
+    for (boost::uint64_t i = 0; i < 8; ++i)
+    {
+        child_index const kid(i);
+
+        if (  marked_for_refinement_.test(kid)
+           && children_[i] == hpx::invalid_id)
+        {
+            //OCTOPUS_ASSERT(hpx::invalid_id == children_[i]);
+            // REVIEW: This is a weird way to do this.
+            new_children.push_back(hpx::async(boost::bind
+                (&octree_server::create_child, this, kid)));
+        }
+    }
+
+    hpx::wait(new_children); 
+} // }}}
+
+void octree_server::collect_new_children(
+    std::vector<octree_server*>& parents
+  , std::vector<child_index>& kids
+  , std::vector<octree_init_data>& inits
+  , std::vector<boost::shared_ptr<vector4d<double> > >& parent_octants
+    )
+{ // {{{
+    if (level_ == config().levels_of_refinement)
+        return;
+
+    for (boost::uint64_t i = 0; i < 8; ++i)
+    {
+        child_index const kid(i);
+
+        if (  marked_for_refinement_.test(kid)
+           && children_[i] == hpx::invalid_id)
+        {
+            parents.push_back(this);
+            kids.push_back(kid);
+            inits.push_back(child_init_data(kid));
+            parent_octants.push_back(send_child_octant(kid));
+        }
+    }
+} // }}}
+
+void octree_server::adopt_child(
+    child_index kid
+  , hpx::id_type const& gid
+    )
+{ // {{{
+    OCTOPUS_ASSERT_FMT_MSG(children_[kid] == hpx::invalid_id,
+        "child already exists, child(%1%)", kid);
+    OCTOPUS_ASSERT(gid != hpx::invalid_id);
+
+    children_[kid] = octree_client(gid);
+} // }}}
+
+void octree_server::populate_local_nodes()
+{ // {{{
+    // Marks are only ever set on nodes that already exist, so the children
+    // created here never need children of their own in this pass, and the
+    // levels do not have to be visited in order.
+    std::vector<octree_server*> const nodes = local_octree_registry().nodes();
+
+    std::vector<octree_server*> parents;
+    std::vector<child_index> kids;
+    std::vector<octree_init_data> inits;
+    std::vector<boost::shared_ptr<vector4d<double> > > parent_octants;
+
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+        nodes[i]->collect_new_children(parents, kids, inits, parent_octants);
+
+    if (inits.empty())
+        return;
+
+    // One creation request per destination locality.
+    std::vector<hpx::id_type> const gids = create_octrees(inits, parent_octants);
+
+    OCTOPUS_ASSERT(gids.size() == parents.size());
+
+    for (std::size_t i = 0; i < gids.size(); ++i)
+        parents[i]->adopt_child(kids[i], gids[i]);
+} // }}}
+
+/// Rebuilds the links of every node on the calling locality from the
+/// topology index (see octree_server::link_local_nodes).
+struct link_locally
+{
+    void operator()() const
+    {
+        octree_server::link_local_nodes();
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int)
+    {}
+};
+
+void octree_server::link_local_nodes()
+{ // {{{
+    std::vector<octree_server*> const nodes = local_octree_registry().nodes();
+
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+        nodes[i]->link_from_topology_index();
+} // }}}
+
+void octree_server::link_from_topology_index()
+{ // {{{
+    topology_index const& index = local_topology_index();
+
+    octree_client const self = client_from_this();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Our siblings: the node on our level across each face, the node one
+    // level up that covers it (an AMR boundary), or the edge of the domain.
+    array<octree_client, 6> siblings;
+
+    for (boost::uint64_t i = 0; i < 6 && 0 != level_; ++i)
+    {
+        face const f = face(i);
+
+        boost::optional<topology_entry> const n
+            = index.find_neighbor(level_, location_, face_direction(f));
+
+        if (!n)
+            siblings[f] = octree_client(physical_boundary, self, f);
+
+        else if (n->level == level_)
+            siblings[f] = octree_client(n->gid);
+
+        else
+        {
+            // The tree is 2:1 balanced.
+            OCTOPUS_ASSERT(n->level + 1 == level_);
+
+            array<boost::uint64_t, 3> const missing
+                = neighbor_location(location_, face_direction(f));
+
+            child_index const kid(missing[0] & 1, missing[1] & 1
+                                , missing[2] & 1);
+
+            siblings[f] = octree_client(amr_boundary
+                                      , octree_client(n->gid)
+                                      , invert(f)
+                                      , kid
+                                      , offset_
+                                      , node_offset(n->level, n->location)
+                                        );
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Our nephews: the nodes on our children's level next to one of our
+    // children that does not exist, which we interpolate ghost zones for.
+    // Our exterior nephews: the nodes on our children's level across our
+    // faces.
+    std::set<state_interpolation_data> nephews;
+    std::set<flux_interpolation_data> exterior_nephews;
+
+    bool const may_have_children = level_ != config().levels_of_refinement;
+
+    for (boost::uint64_t i = 0; i < 8 && may_have_children; ++i)
+    {
+        child_index const kid(i);
+
+        array<boost::uint64_t, 3> const kid_location
+            = location_ * 2 + kid.get_array<boost::uint64_t>();
+
+        for (boost::uint64_t j = 0; j < 6; ++j)
+        {
+            face const f = face(j);
+
+            boost::optional<topology_entry> const n
+                = index.find_neighbor(level_ + 1, kid_location
+                                    , face_direction(f));
+
+            if (!n || n->level != level_ + 1)
+                continue;
+
+            octree_client const nephew(n->gid);
+
+            if (children_[kid] == hpx::invalid_id)
+            {
+                octree_client bound(amr_boundary
+                                  , self
+                                  , f
+                                  , kid
+                                  , node_offset(n->level, n->location)
+                                  , offset_
+                                    ); 
+
+                nephews.insert(state_interpolation_data
+                    (nephew, f, bound.offset_));
+            }
+
+            // Is the neighbor outside of us?
+            if (  (n->location[0] >> 1) != location_[0]
+               || (n->location[1] >> 1) != location_[1]
+               || (n->location[2] >> 1) != location_[2])
+                exterior_nephews.insert
+                    (flux_interpolation_data(nephew, f, kid));
+        }
+    }
+
+    mutex_type::scoped_lock l(mtx_);
+
+    if (0 != level_)
+        siblings_ = siblings;
+
+    nephews_.swap(nephews);
+    exterior_nephews_.swap(exterior_nephews);
+} // }}}
+
+/// Rebuilds the edge and corner links of every node on the calling locality
+/// from the topology index (see octree_server::link_local_diagonals).
+struct link_diagonals_locally
+{
+    void operator()() const
     {
-//        array<boost::uint64_t, 3> dep_location;
-//        dep_location = siblings_[r.exterior_x_face].get_location() * 2
-//            + invert(r.exterior_x_face, get_child_index()).get_array();
-        markings.push_back
-            (siblings_[r.exterior_x_face].require_child_async
-                (invert(r.exterior_x_face, get_child_index())));
+        octree_server::link_local_diagonals();
     }
 
-    if (amr_boundary == siblings_[r.exterior_y_face].kind())
-    {
-//        array<boost::uint64_t, 3> dep_location;
-//        dep_location = siblings_[r.exterior_y_face].get_location() * 2
-//            + invert(r.exterior_y_face, get_child_index()).get_array();
-        markings.push_back
-            (siblings_[r.exterior_y_face].require_child_async
-                (invert(r.exterior_y_face, get_child_index())));
-    }
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int)
+    {}
+};
 
-    if (amr_boundary == siblings_[r.exterior_z_face].kind())
-    {
-//        array<boost::uint64_t, 3> dep_location;
-//        dep_location = siblings_[r.exterior_z_face].get_location() * 2
-//            + invert(r.exterior_z_face, get_child_index()).get_array();
-        markings.push_back
-            (siblings_[r.exterior_z_face].require_child_async
-                (invert(r.exterior_z_face, get_child_index())));
-    }
+void octree_server::link_local_diagonals()
+{ // {{{
+    std::vector<octree_server*> const nodes = local_octree_registry().nodes();
 
-    {
-        hpx::util::scoped_unlock<mutex_type::scoped_lock> ul(l);
-        hpx::wait(markings); 
-    }
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+        nodes[i]->link_diagonals();
 } // }}}
 
-void octree_server::populate()
+/// Returns true if \a d has more than one non-zero component.
+inline bool is_diagonal(array<boost::int64_t, 3> const& d)
 { // {{{
-    if (level_  == config().levels_of_refinement)
-        return;
+    return ((0 != d[0]) + (0 != d[1]) + (0 != d[2])) > 1;
+} // }}}
 
-    std::vector<hpx::future<void> > recursion_is_parallelism;
-    recursion_is_parallelism.reserve(8); 
+void octree_server::link_diagonals()
+{ // {{{
+    topology_index const& index = local_topology_index();
 
-    populate_kernel();
+    ///////////////////////////////////////////////////////////////////////////
+    // The edges and corners that we receive ghost zones for: those that are
+    // inside of the domain. Our diagonal siblings are the nodes on our level
+    // there; the rest are covered by a node one level up, which interpolates
+    // for us (as a diagonal nephew of its own).
+    std::vector<array<boost::int64_t, 3> > directions;
+    std::vector<diagonal_interpolation_data> siblings;
+
+    for (boost::int64_t i = 0; i < 27 && 0 != level_; ++i)
+    {
+        array<boost::int64_t, 3> d;
+        d[0] = (i % 3) - 1;
+        d[1] = ((i / 3) % 3) - 1;
+        d[2] = (i / 9) - 1;
 
-    //sibling_refinement_signal(2);
+        if (!is_diagonal(d))
+            continue;
 
-    for (std::size_t i = 0; i < 8; ++i)
-        if (  (hpx::invalid_id != children_[i])
-           && (level_ + 1) != config().levels_of_refinement)
-            recursion_is_parallelism.push_back
-                (children_[i].populate_async());
+        boost::optional<topology_entry> const n
+            = index.find_neighbor(level_, location_, d);
 
-    hpx::wait(recursion_is_parallelism);
+        if (!n)
+            continue;
 
-    //sibling_refinement_signal(3);
-} // }}}
+        // The tree is 2:1 balanced across edges and corners too (see
+        // remark_kernel).
+        OCTOPUS_ASSERT(n->level + 1 >= level_);
 
-void octree_server::populate_kernel()
-{ // {{{ 
-    OCTOPUS_ASSERT(level_ != config().levels_of_refinement);
+        directions.push_back(d);
 
-    std::vector<hpx::future<void> > new_children;
-    new_children.reserve(8);
+        if (n->level == level_)
+            siblings.push_back(diagonal_interpolation_data
+                (octree_client(n->gid), d, array<boost::int64_t, 3>()));
+    }
 
-    for (boost::uint64_t i = 0; i < 8; ++i)
+    ///////////////////////////////////////////////////////////////////////////
+    // Our diagonal nephews: the nodes on our children's level at an edge or
+    // corner of one of our children that does not exist.
+    std::vector<diagonal_interpolation_data> nephews;
+
+    bool const may_have_children = level_ != config().levels_of_refinement;
+
+    for (boost::uint64_t i = 0; i < 8 && may_have_children; ++i)
     {
         child_index const kid(i);
 
-        if (  marked_for_refinement_.test(kid)
-           && children_[i] == hpx::invalid_id)
+        if (children_[kid] != hpx::invalid_id)
+            continue;
+
+        array<boost::uint64_t, 3> const kid_location
+            = location_ * 2 + kid.get_array<boost::uint64_t>();
+
+        for (boost::int64_t j = 0; j < 27; ++j)
         {
-            //OCTOPUS_ASSERT(hpx::invalid_id == children_[i]);
-            // REVIEW: This is a weird way to do this.
-            new_children.push_back(hpx::async(boost::bind
-                (&octree_server::create_child, this, kid)));
+            array<boost::int64_t, 3> d;
+            d[0] = (j % 3) - 1;
+            d[1] = ((j / 3) % 3) - 1;
+            d[2] = (j / 9) - 1;
+
+            if (!is_diagonal(d))
+                continue;
+
+            boost::optional<topology_entry> const n
+                = index.find_neighbor(level_ + 1, kid_location, d);
+
+            if (!n || n->level != level_ + 1)
+                continue;
+
+            array<boost::int64_t, 3> offset
+                = node_offset(n->level, n->location);
+
+            for (std::size_t a = 0; a < 3; ++a)
+                offset[a] -= 2 * offset_[a];
+
+            nephews.push_back(diagonal_interpolation_data
+                (octree_client(n->gid), d, offset));
         }
     }
 
-    hpx::wait(new_children); 
+    mutex_type::scoped_lock l(mtx_);
+
+    diagonal_directions_.swap(directions);
+    diagonal_siblings_.swap(siblings);
+    diagonal_nephews_.swap(nephews);
 } // }}}
 
 void octree_server::link()
@@ -3419,6 +4950,12 @@ void octree_server::link()
     if (level_ == config().levels_of_refinement)
         return;
 
+    if (config().bulk_child_creation && 0 == level_)
+    {
+        hpx::wait(call_everywhere(link_locally()));
+        return;
+    }
+
     std::vector<hpx::future<void> > recursion_is_parallelism;
     recursion_is_parallelism.reserve(8); 
 
@@ -3479,20 +5016,7 @@ void octree_server::link_child(
 { // {{{
     relatives r(kid);
 
-    octree_init_data kid_init;
-
-    boost::uint64_t const bw = science().ghost_zone_length;
-    boost::uint64_t const gnx = config().grid_node_length;
-
-    kid_init.parent   = reference_from_this(); 
-    kid_init.level    = level_ + 1; 
-    kid_init.location = location_ * 2 + kid.get_array<boost::uint64_t>(); 
-    kid_init.dx       = dx_ * 0.5;
-    kid_init.time     = time_;
-    kid_init.offset   = offset_ * 2 + bw
-                      + (kid.get_array<boost::int64_t>() * (gnx - 2 * bw));
-    kid_init.origin   = origin_;
-    kid_init.step     = step_;
+    octree_init_data const kid_init = child_init_data(kid);
 
     OCTOPUS_ASSERT(children_[kid] != hpx::invalid_id);
 
@@ -3574,15 +5098,21 @@ void octree_server::link_child(
     // Create the exterior "family" links.
 
     // These links must exist. They may be non-real (e.g. boundaries), but they
-    // must exist.
+    // must exist. Our neighbors on our level (the new child's uncles) are
+    // found in the topology index, which is current after populate.
+    topology_index const& index = local_topology_index();
 
     // Check if the exterior X uncle (get it? :D) of the new child is real.
-    if (real_boundary == siblings_[r.exterior_x_face].kind())
+    boost::optional<topology_entry> const x_uncle
+        = index.find_neighbor(level_, location_
+                            , face_direction(r.exterior_x_face));
+
+    if (x_uncle && x_uncle->level == level_)
         links.push_back
-            (siblings_[r.exterior_x_face].tie_child_sibling_async
+            (octree_client(x_uncle->gid).tie_child_sibling_async
                 (r.x_sib, r.interior_x_face, kid_client));
 
-    else if (physical_boundary == siblings_[r.exterior_x_face].kind())
+    else if (!x_uncle)
     {
         octree_client bound(physical_boundary
                           , kid_client
@@ -3593,12 +5123,16 @@ void octree_server::link_child(
     }
 
     // Check if the exterior Y uncle (get it? :D) of the new child is real.
-    if (real_boundary == siblings_[r.exterior_y_face].kind())
+    boost::optional<topology_entry> const y_uncle
+        = index.find_neighbor(level_, location_
+                            , face_direction(r.exterior_y_face));
+
+    if (y_uncle && y_uncle->level == level_)
         links.push_back
-            (siblings_[r.exterior_y_face].tie_child_sibling_async
+            (octree_client(y_uncle->gid).tie_child_sibling_async
                 (r.y_sib, r.interior_y_face, kid_client));
 
-    else if (physical_boundary == siblings_[r.exterior_y_face].kind())
+    else if (!y_uncle)
     {
         octree_client bound(physical_boundary
                           , kid_client
@@ -3609,12 +5143,16 @@ void octree_server::link_child(
     }
 
     // Check if the exterior Z uncle (get it? :D) of the new child is real.
-    if (real_boundary == siblings_[r.exterior_z_face].kind())
+    boost::optional<topology_entry> const z_uncle
+        = index.find_neighbor(level_, location_
+                            , face_direction(r.exterior_z_face));
+
+    if (z_uncle && z_uncle->level == level_)
         links.push_back
-            (siblings_[r.exterior_z_face].tie_child_sibling_async
+            (octree_client(z_uncle->gid).tie_child_sibling_async
                 (r.z_sib, r.interior_z_face, kid_client));
 
-    else if (physical_boundary == siblings_[r.exterior_z_face].kind())
+    else if (!z_uncle)
     {
         octree_client bound(physical_boundary
                           , kid_client
@@ -3680,126 +5218,18 @@ void octree_server::remark_kernel()
                 && (amr_boundary != siblings_[r.exterior_z_face].kind()));
 */
 
-            if (0 != level_)
-            {
-
-                // Relative to the X exterior relative.
-                face corner_f0 = invalid_face;
-                face corner_f1 = invalid_face;
-    
-                face xy_edge_f = invalid_face;
-                face yz_edge_f = invalid_face;
-                face zx_edge_f = invalid_face;
-    
-                child_index corner_kid = invert(get_child_index());
-    
-                child_index xy_edge_kid
-                    = invert(r.exterior_x_face, invert(r.exterior_y_face, get_child_index())); 
-//                    = invert(r.exterior_y_face, get_child_index()); 
-                child_index yz_edge_kid
-                    = invert(r.exterior_y_face, invert(r.exterior_z_face, get_child_index())); 
-//                    = invert(r.exterior_z_face, get_child_index()); 
-                child_index zx_edge_kid
-                    = invert(r.exterior_z_face, invert(r.exterior_x_face, get_child_index())); 
-//                    = invert(r.exterior_x_face, get_child_index()); 
-    
-                if      (kid == child_index(0, 0, 0))
-                {
-                    corner_f0 = YL; 
-                    corner_f1 = ZL;
-    
-                    zx_edge_f = XU; 
-                    xy_edge_f = YU;
-                    yz_edge_f = ZU;
-                }
-    
-                else if (kid == child_index(0, 0, 1))
-                {
-                    corner_f0 = YL; 
-                    corner_f1 = ZU;
-    
-                    zx_edge_f = XU; 
-                    xy_edge_f = YU;
-                    yz_edge_f = ZL;
-                }
-     
-                else if (kid == child_index(0, 1, 0))
-                {
-                    corner_f0 = YU; 
-                    corner_f1 = ZL;
-    
-                    zx_edge_f = XU; 
-                    xy_edge_f = YL;
-                    yz_edge_f = ZU;
-                }
-    
-                else if (kid == child_index(0, 1, 1))
-                {
-                    corner_f0 = YU; 
-                    corner_f1 = ZU;
-    
-                    zx_edge_f = XU; 
-                    xy_edge_f = YL;
-                    yz_edge_f = ZL;
-                }
-    
-                else if (kid == child_index(1, 0, 0))
-                {
-                    corner_f0 = YL; 
-                    corner_f1 = ZL;
-    
-                    zx_edge_f = XL; 
-                    xy_edge_f = YU;
-                    yz_edge_f = ZU;
-                }
-    
-                else if (kid == child_index(1, 0, 1))
-                {
-                    corner_f0 = YL; 
-                    corner_f1 = ZU;
-    
-                    zx_edge_f = XL; 
-                    xy_edge_f = YU;
-                    yz_edge_f = ZL;
-                }
-     
-                else if (kid == child_index(1, 1, 0))
-                {
-                    corner_f0 = YU; 
-                    corner_f1 = ZL;
-    
-                    zx_edge_f = XL; 
-                    xy_edge_f = YL;
-                    yz_edge_f = ZU;
-                }
-    
-                else if (kid == child_index(1, 1, 1))
-                {
-                    corner_f0 = YU; 
-                    corner_f1 = ZU;
-    
-                    zx_edge_f = XL; 
-                    xy_edge_f = YL;
-                    yz_edge_f = ZL;
-                }
-    
-                markings.push_back(
-                    siblings_[r.exterior_x_face].require_corner_child_async(
-                        corner_kid, corner_f0, corner_f1));
-    
-                markings.push_back(
-                    siblings_[r.exterior_x_face].require_sibling_child_async
-                        (xy_edge_kid, invert(xy_edge_f)));
-   
-                markings.push_back(
-                    siblings_[r.exterior_y_face].require_sibling_child_async
-                        (yz_edge_kid, invert(yz_edge_f)));
-   
-                markings.push_back(
-                    siblings_[r.exterior_z_face].require_sibling_child_async
-                        (zx_edge_kid, invert(zx_edge_f)));
-            }
-
+            array<boost::int64_t, 3> const x
+                = face_direction(r.exterior_x_face);
+            array<boost::int64_t, 3> const y
+                = face_direction(r.exterior_y_face);
+            array<boost::int64_t, 3> const z
+                = face_direction(r.exterior_z_face);
+
+            // So must our edge and corner neighbors next to the new child.
+            require_neighbor(markings, x + y);
+            require_neighbor(markings, y + z);
+            require_neighbor(markings, z + x);
+            require_neighbor(markings, x + y + z);
         }
     }
 
@@ -3809,18 +5239,70 @@ void octree_server::remark_kernel()
     }
 } // }}}
 
+/// Calls octree_server::drop_next_cfl_dt on every node on the calling
+/// locality.
+struct drop_local_next_cfl_dts
+{
+    void operator()() const
+    {
+        std::vector<octree_server*> const nodes
+            = local_octree_registry().nodes();
+
+        for (std::size_t i = 0; i < nodes.size(); ++i)
+            nodes[i]->drop_next_cfl_dt();
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int)
+    {}
+};
+
+/// Releases the free blocks of the buffer pool on the calling locality.
+struct trim_buffer_pool
+{
+    void operator()() const
+    {
+        local_buffer_pool().trim();
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int)
+    {}
+};
+
 void octree_server::refine()
 { // {{{
     OCTOPUS_ASSERT(0 == level_);
 
+    // New children are interpolated from our ghost zones too, so they have to
+    // be current. The final ghost zone queue is free between timesteps.
+    if (!config().final_ghost_zone_exchange)
+        exchange_ghost_zones(config().runge_kutta_order);
+
+    // The reductions that step_with_cfl started for the next step follow the
+    // shape of the tree, so they have to be done before it changes. The next
+    // step reduces its timestep from its own first flux sweep.
+    hpx::wait(call_everywhere(drop_local_next_cfl_dts()));
+
     //OCTOPUS_DUMP("refine: clearing refinement marks\n");
 
     clear_refinement_marks();
 
+    // Marking finds the neighbors of each node in the topology index, which
+    // does not have the root yet when we are called for the first time.
+    synchronize_topology_index();
+
     //OCTOPUS_DUMP("refine: calling mark\n");
     mark();
+
+    // Place the children that populate is about to create using the costs
+    // of the nodes that exist now.
+    if (config().rebalance_on_refine)
+        rebalance(octree_client(get_gid()));
+
     //OCTOPUS_DUMP("refine: called mark, calling populate\n");
     populate();
+    synchronize_topology_index();
     //OCTOPUS_DUMP("refine: called populate, calling link\n");
     link();
     //OCTOPUS_DUMP("refine: called link, performing remark passes\n");
@@ -3830,16 +5312,31 @@ void octree_server::refine()
         for (boost::uint64_t i = 0; i < config().levels_of_refinement - 1; ++i)
         {
             remark();
+
+            if (config().rebalance_on_refine)
+                rebalance(octree_client(get_gid()));
+
             populate();
+            synchronize_topology_index();
             link();
         }
     }
 
+    // The edge and corner links need the whole tree, so they are only built
+    // once it is done.
+    if (config().wide_halos)
+        hpx::wait(call_everywhere(link_diagonals_locally()));
+
     //OCTOPUS_DUMP("refine: finished remark passes, doing c->p injection\n");
 
     child_to_parent_state_injection(0);
 
     //OCTOPUS_DUMP("refine: c->p injection complete\n");
+
+    // Regridding frees the buffers of the old grid and allocates a different
+    // mix of sizes for the new one, so the free lists now mostly hold blocks
+    // that stepping will not ask for again. The next sub step refills them.
+    hpx::wait(call_everywhere(trim_buffer_pool()));
 } // }}}
 
 void octree_server::sibling_refinement_signal(
@@ -3880,8 +5377,21 @@ void octree_server::slice(slice_function const& f, axis a, double eps)
     std::vector<hpx::future<void> > recursion_is_parallelism;
     recursion_is_parallelism.reserve(8); 
 
+    // Only the children whose octant contains the plane.
+    array<double, 3> lower, upper;
+
+    for (boost::uint64_t d = 0; d < 3; ++d)
+    {
+        lower[d] = -(std::numeric_limits<double>::max)();
+        upper[d] = (std::numeric_limits<double>::max)();
+    }
+
+    lower[a] = eps;
+    upper[a] = eps;
+
     for (std::size_t i = 0; i < 8; ++i)
-        if (hpx::invalid_id != children_[i])
+        if (  hpx::invalid_id != children_[i]
+           && child_intersects(child_index(i), lower, upper))
             recursion_is_parallelism.push_back
                 (children_[i].slice_async(f, a, eps));
 
@@ -3890,22 +5400,37 @@ void octree_server::slice(slice_function const& f, axis a, double eps)
     hpx::wait(recursion_is_parallelism);
 } // }}}
 
-void octree_server::slice_x_kernel(slice_function const& f, double eps)
+bool octree_server::slice_plane_index(
+    axis a
+  , double eps
+  , boost::uint64_t& index
+    ) const
 { // {{{
     boost::uint64_t const bw = science().ghost_zone_length;
     boost::uint64_t const gnx = config().grid_node_length;
 
-    // Make sure we are within epsilon of the equatorial plane.
-    if (!(  (x_center(bw) - 0.5 * dx_ < eps)
-         && (x_center(gnx - bw - 1) + 0.5 * dx_ >= eps)))
-        return;
+    // Make sure the plane goes through our interior.
+    if (!(bounds_lower_[a] <= eps && eps < bounds_upper_[a]))
+        return false;
+
+    index = bw + boost::uint64_t((eps - bounds_lower_[a]) / dx_);
+
+    // Guard against rounding at the upper boundary.
+    if (index > gnx - bw - 1)
+        index = gnx - bw - 1;
+
+    return true;
+} // }}}
+
+void octree_server::slice_x_kernel(slice_function const& f, double eps)
+{ // {{{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
 
     boost::uint64_t i = 0;
 
-    for (boost::uint64_t ii = bw; ii < gnx - bw; ++ii)
-        if (  (eps >= x_center(ii) - 0.5 * dx_) 
-           && (eps < x_center(ii) + 0.5 * dx_))
-            i = ii;
+    if (!slice_plane_index(x_axis, eps, i))
+        return;
 
     // Loop over all the points in this plane.
     for (boost::uint64_t j = bw; j < gnx - bw; ++j)
@@ -3921,17 +5446,10 @@ void octree_server::slice_y_kernel(slice_function const& f, double eps)
     boost::uint64_t const bw = science().ghost_zone_length;
     boost::uint64_t const gnx = config().grid_node_length;
 
-    // Make sure we are within epsilon of the equatorial plane.
-    if (!(  (x_center(bw) - 0.5 * dx_ < eps)
-         && (x_center(gnx - bw - 1) + 0.5 * dx_ >= eps)))
-        return;
-
     boost::uint64_t j = 0;
 
-    for (boost::uint64_t jj = bw; jj < gnx - bw; ++jj)
-        if (  (eps >= y_center(jj) - 0.5 * dx_) 
-           && (eps < y_center(jj) + 0.5 * dx_))
-            j = jj;
+    if (!slice_plane_index(y_axis, eps, j))
+        return;
 
     // Loop over all the points in this plane.
     for (boost::uint64_t i = bw; i < gnx - bw; ++i)
@@ -3947,29 +5465,211 @@ void octree_server::slice_z_kernel(slice_function const& f, double eps)
     boost::uint64_t const bw = science().ghost_zone_length;
     boost::uint64_t const gnx = config().grid_node_length;
 
-    // Make sure we are within epsilon of the equatorial plane.
-    if (!(  (z_center(bw) - 0.5 * dx_ < eps)
-         && (z_center(gnx - bw - 1) + 0.5 * dx_ >= eps)))
-        return;
-
     boost::uint64_t k = 0;
 
-    for (boost::uint64_t kk = bw; kk < gnx - bw; ++kk)
-        if (  (eps >= z_center(kk) - 0.5 * dx_) 
-           && (eps < z_center(kk) + 0.5 * dx_))
-            k = kk;
+    if (!slice_plane_index(z_axis, eps, k))
+        return;
 
     // Loop over all the points in this plane.
     for (boost::uint64_t i = bw; i < gnx - bw; ++i)
         for (boost::uint64_t j = bw; j < gnx - bw; ++j)
-//    for (boost::uint64_t i = 0; i < gnx; ++i)
-//        for (boost::uint64_t j = 0; j < gnx; ++j)
         {
             array<double, 3> c = center_coords(i, j, k);
             f(*this, (*U_)(i, j, k), c);
         } 
 } // }}}
 
+void octree_server::region(
+    slice_function const& f
+  , array<double, 3> const& lower
+  , array<double, 3> const& upper
+    )
+{ // {{{
+    std::vector<hpx::future<void> > recursion_is_parallelism;
+    recursion_is_parallelism.reserve(8); 
+
+    for (std::size_t i = 0; i < 8; ++i)
+        if (  hpx::invalid_id != children_[i]
+           && child_intersects(child_index(i), lower, upper))
+            recursion_is_parallelism.push_back
+                (children_[i].region_async(f, lower, upper));
+
+    region_kernel(f, lower, upper);
+
+    hpx::wait(recursion_is_parallelism);
+} // }}}
+
+void octree_server::region_kernel(
+    slice_function const& f
+  , array<double, 3> const& lower
+  , array<double, 3> const& upper
+    )
+{ // {{{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    // The interior cells whose centers are in [lower, upper], on each axis.
+    boost::uint64_t first[3], last[3];
+
+    for (boost::uint64_t a = 0; a < 3; ++a)
+    {
+        if (upper[a] < bounds_lower_[a] || bounds_upper_[a] <= lower[a])
+            return;
+
+        // Cell i is centered at bounds_lower_ + (i - bw + 0.5) * dx_.
+        double const lo = std::ceil((lower[a] - bounds_lower_[a]) / dx_ - 0.5);
+        double const hi = std::floor((upper[a] - bounds_lower_[a]) / dx_ - 0.5);
+
+        double const n = double(gnx - 2 * bw);
+
+        if (hi < 0.0 || n <= lo || hi < lo)
+            return;
+
+        first[a] = bw + boost::uint64_t((std::max)(lo, 0.0));
+        last[a]  = bw + boost::uint64_t((std::min)(hi, n - 1.0)) + 1;
+    }
+
+    for (boost::uint64_t i = first[0]; i < last[0]; ++i)
+        for (boost::uint64_t j = first[1]; j < last[1]; ++j)
+            for (boost::uint64_t k = first[2]; k < last[2]; ++k)
+            {
+                array<double, 3> c = center_coords(i, j, k);
+                f(*this, (*U_)(i, j, k), c);
+            } 
+} // }}}
+
+child_index octree_server::probe_child(
+    array<double, 3> const& point
+    ) const
+{ // {{{
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    // The children meet at the face between cells gnx/2 - 1 and gnx/2.
+    return child_index(point[0] >= x_face(gnx / 2)
+                     , point[1] >= y_face(gnx / 2)
+                     , point[2] >= z_face(gnx / 2));
+} // }}}
+
+state octree_server::interpolate_state_locked(
+    array<double, 3> const& point
+    ) const
+{ // {{{
+    boost::uint64_t const bw = science().ghost_zone_length;
+    boost::uint64_t const gnx = config().grid_node_length;
+
+    // Between timesteps the ghost zones are only current if the final ghost
+    // zone exchange was done. If it was, the stencil may reach one ghost zone
+    // past the interior; otherwise it stays in the interior.
+    boost::uint64_t const halo = config().final_ghost_zone_exchange ? 1 : 0;
+
+    // Find the cell centers that surround the point. Points within half a
+    // cell of the boundary use the ghost zones (if they are current); points
+    // outside of the stencil's reach are clamped to its edge.
+    boost::uint64_t index[3];
+    double weight[3];
+
+    double const center0[3] = { x_center(0), y_center(0), z_center(0) };
+
+    for (std::size_t a = 0; a < 3; ++a)
+    {
+        double const x = (point[a] - center0[a]) / dx_;
+
+        double const lower = double(bw - halo);
+        double const upper = double(gnx - bw - 1 + halo);
+
+        double const clamped = (std::max)(lower, (std::min)(upper, x));
+
+        index[a] = (std::min)(boost::uint64_t(clamped), gnx - bw - 2 + halo);
+        weight[a] = clamped - double(index[a]);
+    }
+
+    state s;
+
+    for (boost::uint64_t f = 0; f < s.size(); ++f)
+        s[f] = 0.0;
+
+    for (boost::uint64_t di = 0; di < 2; ++di)
+        for (boost::uint64_t dj = 0; dj < 2; ++dj)
+            for (boost::uint64_t dk = 0; dk < 2; ++dk)
+            {
+                double const w = (di ? weight[0] : 1.0 - weight[0])
+                               * (dj ? weight[1] : 1.0 - weight[1])
+                               * (dk ? weight[2] : 1.0 - weight[2]);
+
+                state const& u = (*U_)(index[0] + di
+                                     , index[1] + dj
+                                     , index[2] + dk);
+
+                for (boost::uint64_t f = 0; f < s.size(); ++f)
+                    s[f] += w * u[f];
+            }
+
+    return s;
+} // }}}
+
+std::vector<state> octree_server::probe(
+    std::vector<array<double, 3> > const& points
+    )
+{ // {{{
+    std::vector<state> results(points.size());
+
+    // Indices (into points) of the points that go to each child, and of the
+    // points that we sample ourselves.
+    std::vector<std::size_t> by_child[8];
+    std::vector<std::size_t> here;
+
+    for (std::size_t p = 0; p < points.size(); ++p)
+    {
+        child_index const kid = probe_child(points[p]);
+
+        if (hpx::invalid_id != children_[kid])
+            by_child[kid].push_back(p);
+        else
+            here.push_back(p);
+    }
+
+    std::vector<hpx::future<std::vector<state> > > recursion_is_parallelism;
+    std::vector<child_index> kids;
+
+    recursion_is_parallelism.reserve(8);
+    kids.reserve(8);
+
+    for (boost::uint64_t i = 0; i < 8; ++i)
+    {
+        if (by_child[i].empty())
+            continue;
+
+        std::vector<array<double, 3> > batch;
+        batch.reserve(by_child[i].size());
+
+        for (std::size_t p = 0; p < by_child[i].size(); ++p)
+            batch.push_back(points[by_child[i][p]]);
+
+        recursion_is_parallelism.push_back(children_[i].probe_async(batch));
+        kids.push_back(child_index(i));
+    }
+
+    {
+        mutex_type::scoped_lock l(mtx_);
+
+        for (std::size_t p = 0; p < here.size(); ++p)
+            results[here[p]] = interpolate_state_locked(points[here[p]]);
+    }
+
+    for (std::size_t c = 0; c < recursion_is_parallelism.size(); ++c)
+    {
+        std::vector<state> const batch = recursion_is_parallelism[c].get();
+        std::vector<std::size_t> const& indices = by_child[kids[c]];
+
+        OCTOPUS_ASSERT(batch.size() == indices.size());
+
+        for (std::size_t p = 0; p < batch.size(); ++p)
+            results[indices[p]] = batch[p];
+    }
+
+    return results;
+} // }}}
+
 void octree_server::save()
 { // {{{
     boost::uint64_t const gnx = octopus::config().grid_node_length;
@@ -4005,6 +5705,9 @@ void octree_server::load()
                     checkpoint().read((char*) &u, sizeof(double));
                     (*U_)(i, j, k)(l) = u;
                 }
+
+    // The wave speeds were not computed from this state.
+    max_wave_speed_ = array<double, 3>();
 } // }}}
 
 }
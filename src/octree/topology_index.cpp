@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+#include <hpx/lcos/future_wait.hpp>
+
+#include <octopus/octree/topology_index.hpp>
+#include <octopus/engine/engine_interface.hpp>
+
+#include <boost/serialization/vector.hpp>
+
+namespace octopus
+{
+
+topology_index& local_topology_index()
+{
+    static topology_index index;
+    return index;
+}
+
+/// Adds a batch of entries to the replica on the calling locality.
+struct insert_topology_entries
+{
+  private:
+    std::vector<topology_entry> entries_;
+
+  public:
+    insert_topology_entries() : entries_() {}
+
+    insert_topology_entries(std::vector<topology_entry> const& entries)
+      : entries_(entries)
+    {}
+
+    void operator()() const
+    {
+        local_topology_index().insert(entries_);
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int)
+    {
+        ar & entries_;
+    }
+};
+
+/// Sends the entries that are pending on the calling locality to every
+/// replica, including its own.
+struct publish_topology_entries
+{
+    void operator()() const
+    {
+        std::vector<topology_entry> const pending
+            = local_topology_index().take_pending();
+
+        if (pending.empty())
+            return;
+
+        hpx::wait(call_everywhere(insert_topology_entries(pending)));
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, const unsigned int)
+    {}
+};
+
+void synchronize_topology_index()
+{
+    hpx::wait(call_everywhere(publish_topology_entries()));
+}
+
+}
+
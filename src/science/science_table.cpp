@@ -21,6 +21,8 @@ science_table default_science_table()
 
     sci.initial_dx = initial_dx();
 
+    sci.distribute = space_filling_curve_distribution();
+
     return sci;
 }
 
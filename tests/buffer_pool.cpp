@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2013 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+///////////////////////////////////////////////////////////////////////////////
+
+#include <hpx/hpx_main.hpp>
+#include <hpx/util/lightweight_test.hpp>
+
+#include <octopus/buffer_pool.hpp>
+
+using octopus::buffer_pool;
+
+///////////////////////////////////////////////////////////////////////////////
+void test_size_classes()
+{
+    std::size_t const none = buffer_pool::number_of_size_classes;
+
+    // Small blocks are not pooled.
+    HPX_TEST_EQ(buffer_pool::size_class_of(0), none);
+    HPX_TEST_EQ(buffer_pool::size_class_of(buffer_pool::min_block_size - 1)
+              , none);
+
+    HPX_TEST_EQ(buffer_pool::size_class_of(buffer_pool::min_block_size), 0U);
+    HPX_TEST_EQ(buffer_pool::size_class_of(buffer_pool::min_block_size + 1)
+              , 1U);
+    HPX_TEST_EQ(buffer_pool::size_class_of(2 * buffer_pool::min_block_size)
+              , 4U);
+
+    // Each class holds the sizes that map to it, and wastes at most a fifth
+    // of a block.
+    for (std::size_t c = 0; c < none; ++c)
+    {
+        std::size_t const size = buffer_pool::block_size(c);
+
+        HPX_TEST_EQ(buffer_pool::size_class_of(size), c);
+
+        if (0 != c)
+        {
+            std::size_t const smallest = buffer_pool::block_size(c - 1) + 1;
+
+            HPX_TEST_EQ(buffer_pool::size_class_of(smallest), c);
+            HPX_TEST((size - smallest) * 5 < size);
+        }
+    }
+
+    // Larger blocks are not pooled either.
+    HPX_TEST_EQ(buffer_pool::size_class_of
+        (buffer_pool::block_size(none - 1) + 1), none);
+}
+
+void test_reuse()
+{
+    buffer_pool pool;
+
+    std::size_t const bytes = 3 * buffer_pool::min_block_size;
+    std::size_t const c = buffer_pool::size_class_of(bytes);
+
+    void* p = pool.allocate(bytes);
+
+    HPX_TEST(p);
+    HPX_TEST_EQ(pool.misses(), 1U);
+    HPX_TEST_EQ(pool.hits(), 0U);
+    HPX_TEST_EQ(pool.free_bytes(), 0U);
+
+    pool.deallocate(p, bytes);
+
+    HPX_TEST_EQ(pool.free_bytes(), buffer_pool::block_size(c));
+
+    // A request of a different size in the same class gets the same block.
+    std::size_t const other = buffer_pool::block_size(c);
+
+    HPX_TEST_EQ(buffer_pool::size_class_of(other), c);
+
+    void* q = pool.allocate(other);
+
+    HPX_TEST_EQ(q, p);
+    HPX_TEST_EQ(pool.hits(), 1U);
+    HPX_TEST_EQ(pool.misses(), 1U);
+    HPX_TEST_EQ(pool.free_bytes(), 0U);
+
+    // A request in another class does not.
+    void* r = pool.allocate(2 * bytes);
+
+    HPX_TEST(r != q);
+    HPX_TEST_EQ(pool.misses(), 2U);
+
+    pool.deallocate(q, other);
+    pool.deallocate(r, 2 * bytes);
+
+    HPX_TEST(0 < pool.free_bytes());
+
+    pool.trim();
+
+    HPX_TEST_EQ(pool.free_bytes(), 0U);
+
+    // Unpooled blocks are not counted.
+    void* s = pool.allocate(16);
+    pool.deallocate(s, 16);
+
+    HPX_TEST_EQ(pool.free_bytes(), 0U);
+    HPX_TEST_EQ(pool.hits() + pool.misses(), 3U);
+}
+
+int main()
+{
+    test_size_classes();
+    test_reuse();
+
+    return hpx::util::report_errors();
+}
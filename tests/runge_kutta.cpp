@@ -0,0 +1,184 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2013 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+///////////////////////////////////////////////////////////////////////////////
+
+#include <hpx/hpx_main.hpp>
+#include <hpx/util/lightweight_test.hpp>
+
+#include <octopus/runge_kutta.hpp>
+
+#include <boost/math/constants/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using octopus::runge_kutta_beta;
+using octopus::low_storage_runge_kutta_a;
+using octopus::low_storage_runge_kutta_b;
+
+std::size_t const cells = 64;
+
+///////////////////////////////////////////////////////////////////////////////
+/// Inviscid Burgers' equation, central differences, periodic boundaries.
+std::vector<double> differentials(std::vector<double> const& u)
+{
+    double const dx = 1.0 / cells;
+
+    std::vector<double> d(cells);
+
+    for (std::size_t i = 0; i < cells; ++i)
+    {
+        double const left = u[(i + cells - 1) % cells];
+        double const right = u[(i + 1) % cells];
+
+        d[i] = -(right * right - left * left) / (4.0 * dx);
+    }
+
+    return d;
+}
+
+/// A smooth state, far enough from a shock for the timesteps below.
+std::vector<double> smooth_state()
+{
+    double const pi = boost::math::constants::pi<double>();
+
+    std::vector<double> u(cells);
+
+    for (std::size_t i = 0; i < cells; ++i)
+        u[i] = 1.0 + 0.25 * std::sin(2.0 * pi * (i + 0.5) / cells);
+
+    return u;
+}
+
+/// One step of TVD RK, as octree_server::add_differentials_kernel does it.
+std::vector<double> step_tvd(
+    std::vector<double> u
+  , boost::uint64_t order
+  , double dt
+    )
+{
+    std::vector<double> const u0 = u;
+
+    for (boost::uint64_t phase = 0; phase < order; ++phase)
+    {
+        double const beta = runge_kutta_beta(order, phase);
+
+        std::vector<double> const d = differentials(u);
+
+        for (std::size_t i = 0; i < cells; ++i)
+            u[i] = u[i] * beta + d[i] * dt * beta + u0[i] * (1.0 - beta);
+    }
+
+    return u;
+}
+
+/// One step of low-storage RK, as
+/// octree_server::add_differentials_low_storage_kernel does it.
+std::vector<double> step_low_storage(
+    std::vector<double> u
+  , boost::uint64_t order
+  , double dt
+    )
+{
+    std::vector<double> D(cells, 0.0);
+
+    for (boost::uint64_t phase = 0; phase < order; ++phase)
+    {
+        double const b = low_storage_runge_kutta_b(order, phase);
+
+        double const a_next = (phase + 1 < order)
+                            ? low_storage_runge_kutta_a(order, phase + 1)
+                            : 0.0;
+
+        std::vector<double> const d = differentials(u);
+
+        for (std::size_t i = 0; i < cells; ++i)
+        {
+            D[i] += d[i];
+            u[i] += D[i] * dt * b;
+            D[i] *= a_next;
+        }
+    }
+
+    // The register is zero again after the last sub step.
+    for (std::size_t i = 0; i < cells; ++i)
+        HPX_TEST_EQ(D[i], 0.0);
+
+    return u;
+}
+
+double max_difference(
+    std::vector<double> const& x
+  , std::vector<double> const& y
+    )
+{
+    double d = 0.0;
+
+    for (std::size_t i = 0; i < cells; ++i)
+        d = (std::max)(d, std::fabs(x[i] - y[i]));
+
+    return d;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void test_order(boost::uint64_t order)
+{
+    std::vector<double> const u = smooth_state();
+
+    // The first register weight is always 0, so the low-storage scheme does
+    // not read D before it is written.
+    HPX_TEST_EQ(low_storage_runge_kutta_a(order, 0), 0.0);
+
+    // Consistency: the weights of the differentials add up to one step.
+    {
+        double sum = 0.0;
+        double r = 0.0;
+
+        for (boost::uint64_t phase = 0; phase < order; ++phase)
+        {
+            // Each sub step adds one L(U), which is 1 for a constant L.
+            r = r * low_storage_runge_kutta_a(order, phase) + 1.0;
+            sum += r * low_storage_runge_kutta_b(order, phase);
+        }
+
+        HPX_TEST(std::fabs(sum - 1.0) < 1e-10);
+    }
+
+    double const dt = 0.004;
+
+    double const coarse
+        = max_difference(step_tvd(u, order, dt)
+                       , step_low_storage(u, order, dt));
+
+    double const fine
+        = max_difference(step_tvd(u, order, dt / 2)
+                       , step_low_storage(u, order, dt / 2));
+
+    // Order 1 and 2 are the same scheme.
+    if (order < 3)
+    {
+        HPX_TEST(coarse < 1e-14);
+        HPX_TEST(fine < 1e-14);
+        return;
+    }
+
+    // Both schemes are third order, so after one step they differ by
+    // O(dt^4): halving dt shrinks the difference by about 16.
+    HPX_TEST(coarse < 1e-6);
+    HPX_TEST(0.0 < fine);
+    HPX_TEST(coarse / fine > 10.0);
+}
+
+int main()
+{
+    test_order(1);
+    test_order(2);
+    test_order(3);
+
+    return hpx::util::report_errors();
+}
+
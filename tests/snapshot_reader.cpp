@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+///////////////////////////////////////////////////////////////////////////////
+
+#include <hpx/hpx_main.hpp>
+#include <hpx/util/lightweight_test.hpp>
+
+#include <octopus/io/snapshot_format.hpp>
+#include <octopus/io/snapshot_reader.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using octopus::snapshot::file_header;
+using octopus::snapshot::file_writer;
+using octopus::snapshot::index_entry;
+using octopus::snapshot::node_view;
+using octopus::snapshot::reader;
+
+boost::uint64_t const n = 4;
+boost::uint64_t const state_size = 3;
+
+// A value that is different for every node, cell and component.
+double value(
+    boost::uint64_t level
+  , boost::uint64_t x
+  , boost::uint64_t i
+  , boost::uint64_t j
+  , boost::uint64_t k
+  , boost::uint64_t v
+    )
+{
+    return level * 1e6 + x * 1e4 + i * 1e3 + j * 1e2 + k * 1e1 + v;
+}
+
+void write_node(
+    file_writer& w
+  , boost::uint64_t level
+  , boost::uint64_t x
+    )
+{
+    index_entry e;
+    std::memset(&e, 0, sizeof(e));
+    e.level = level;
+    e.location[0] = x;
+    e.dx = 1.0 / (n << level);
+
+    std::vector<double> faces(n + 1);
+    for (boost::uint64_t i = 0; i < faces.size(); ++i)
+        faces[i] = (x * n + i) * e.dx;
+
+    std::vector<double> U(n * n * n * state_size);
+    for (boost::uint64_t k = 0; k < n; ++k)
+        for (boost::uint64_t j = 0; j < n; ++j)
+            for (boost::uint64_t i = 0; i < n; ++i)
+                for (boost::uint64_t v = 0; v < state_size; ++v)
+                    U[((k * n + j) * n + i) * state_size + v]
+                        = value(level, x, i, j, k, v);
+
+    w.write_node(e, &faces[0], &faces[0], &faces[0], &U[0]);
+}
+
+int main()
+{
+    char const* file_name = "snapshot_reader_test.snap";
+
+    {
+        file_header h;
+        std::memset(&h, 0, sizeof(h));
+        h.step = 42;
+        h.interior_length = n;
+        h.state_size = state_size;
+        std::strcpy(h.science, "test");
+
+        file_writer w(file_name, h);
+
+        // Written out of order; the index is sorted when the file is closed.
+        write_node(w, 1, 1);
+        write_node(w, 0, 0);
+        write_node(w, 1, 0);
+
+        w.close();
+    }
+
+    {
+        reader const r(file_name);
+
+        HPX_TEST_EQ(r.header().step, 42U);
+        HPX_TEST_EQ(std::strcmp(r.header().science, "test"), 0);
+        HPX_TEST_EQ(r.size(), 3U);
+
+        // Sorted by (level, location).
+        HPX_TEST_EQ(r.begin()[0].level, 0U);
+        HPX_TEST_EQ(r.begin()[1].location[0], 0U);
+        HPX_TEST_EQ(r.begin()[2].location[0], 1U);
+
+        HPX_TEST(!r.find(2, 0, 0, 0));
+        HPX_TEST(!r.find(1, 0, 1, 0));
+
+        index_entry const* e = r.find(1, 1, 0, 0);
+
+        HPX_TEST(e);
+
+        if (e)
+        {
+            // Every block starts on a page.
+            HPX_TEST_EQ(e->offset % octopus::snapshot::block_alignment, 0U);
+
+            node_view const v = r.node(*e);
+
+            HPX_TEST_EQ(v.length(), n);
+            HPX_TEST_EQ(v.faces(0)[0], 0.5);
+            HPX_TEST_EQ(v.faces(2)[n], 1.0);
+            HPX_TEST_EQ(v(0, 0, 0, 0), value(1, 1, 0, 0, 0, 0));
+            HPX_TEST_EQ(v(3, 2, 1, 2), value(1, 1, 3, 2, 1, 2));
+        }
+    }
+
+    std::remove(file_name);
+
+    return hpx::util::report_errors();
+}
+
@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2013 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+///////////////////////////////////////////////////////////////////////////////
+
+#include <hpx/hpx_main.hpp>
+#include <hpx/util/lightweight_test.hpp>
+
+#include <octopus/space_filling_curve.hpp>
+#include <octopus/science/space_filling_curve_distribution.hpp>
+
+#include <set>
+#include <vector>
+
+using octopus::array;
+using octopus::space_filling_curve;
+
+///////////////////////////////////////////////////////////////////////////////
+array<boost::uint64_t, 3> make_location(
+    boost::uint64_t x
+  , boost::uint64_t y
+  , boost::uint64_t z
+    )
+{
+    array<boost::uint64_t, 3> a;
+    a[0] = x;
+    a[1] = y;
+    a[2] = z;
+    return a;
+}
+
+void test_curve(space_filling_curve curve, boost::uint64_t max_level)
+{
+    boost::uint64_t const n = boost::uint64_t(1) << max_level;
+
+    std::set<boost::uint64_t> keys;
+    std::vector<array<boost::uint64_t, 3> > by_key(n * n * n);
+
+    for (boost::uint64_t i = 0; i < n; ++i)
+        for (boost::uint64_t j = 0; j < n; ++j)
+            for (boost::uint64_t k = 0; k < n; ++k)
+            {
+                array<boost::uint64_t, 3> const loc = make_location(i, j, k);
+
+                boost::uint64_t const key = octopus::space_filling_curve_key
+                    (curve, loc, max_level, max_level);
+
+                HPX_TEST(key < n * n * n);
+                keys.insert(key);
+                by_key[key] = loc;
+
+                // Every ancestor's range contains the key.
+                for (boost::uint64_t l = 0; l < max_level; ++l)
+                {
+                    boost::uint64_t const s = max_level - l;
+
+                    boost::uint64_t const parent
+                        = octopus::space_filling_curve_key(curve
+                            , make_location(i >> s, j >> s, k >> s)
+                            , l, max_level);
+
+                    HPX_TEST(parent <= key);
+                    HPX_TEST(key < parent + octopus::space_filling_curve_extent
+                                                (l, max_level));
+                }
+            }
+
+    // Keys are a bijection.
+    HPX_TEST_EQ(keys.size(), n * n * n);
+
+    // Consecutive cells on a Hilbert curve are face neighbors.
+    if (octopus::hilbert_curve == curve)
+    {
+        for (boost::uint64_t q = 1; q < by_key.size(); ++q)
+        {
+            boost::uint64_t d = 0;
+
+            for (boost::uint64_t a = 0; a < 3; ++a)
+                d += (by_key[q][a] > by_key[q - 1][a])
+                   ? (by_key[q][a] - by_key[q - 1][a])
+                   : (by_key[q - 1][a] - by_key[q][a]);
+
+            HPX_TEST_EQ(d, 1U);
+        }
+    }
+}
+
+void test_partition()
+{
+    // Level weights of 1 for the root and 4 for level 1.
+    std::vector<double> weights;
+    weights.push_back(1.0);
+    weights.push_back(4.0);
+
+    octopus::space_filling_curve_distribution dist
+        (octopus::hilbert_curve, weights);
+
+    std::vector<octopus::space_filling_curve_node> nodes;
+    nodes.push_back(octopus::space_filling_curve_node(0, make_location(0, 0, 0)));
+
+    for (boost::uint64_t i = 0; i < 2; ++i)
+        for (boost::uint64_t j = 0; j < 2; ++j)
+            for (boost::uint64_t k = 0; k < 2; ++k)
+                nodes.push_back(octopus::space_filling_curve_node
+                    (1, make_location(i, j, k)));
+
+    dist.partition(nodes, 4);
+
+    HPX_TEST_EQ(dist.splitters().size(), 3U);
+
+    std::vector<double> load(4, 0.0);
+
+    for (boost::uint64_t i = 0; i < nodes.size(); ++i)
+    {
+        boost::uint64_t const key
+            = dist.key(nodes[i].level, nodes[i].location);
+        load[dist.owner(key, 4)] += dist.level_weight(nodes[i].level);
+    }
+
+    // 33 units of work, so no locality should have more than 9 or less than 8.
+    for (boost::uint64_t i = 0; i < 4; ++i)
+    {
+        HPX_TEST(load[i] >= 8.0);
+        HPX_TEST(load[i] <= 9.0);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main()
+{
+    for (boost::uint64_t l = 0; l <= 4; ++l)
+    {
+        test_curve(octopus::morton_curve, l);
+        test_curve(octopus::hilbert_curve, l);
+    }
+
+    test_partition();
+
+    return hpx::util::report_errors();
+}
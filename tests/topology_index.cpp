@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2013 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+///////////////////////////////////////////////////////////////////////////////
+
+#include <hpx/hpx_main.hpp>
+#include <hpx/util/lightweight_test.hpp>
+
+#include <octopus/octree/topology_index.hpp>
+
+#include <vector>
+
+using octopus::array;
+using octopus::topology_entry;
+
+///////////////////////////////////////////////////////////////////////////////
+array<boost::uint64_t, 3> make_location(
+    boost::uint64_t x
+  , boost::uint64_t y
+  , boost::uint64_t z
+    )
+{
+    array<boost::uint64_t, 3> a;
+    a[0] = x;
+    a[1] = y;
+    a[2] = z;
+    return a;
+}
+
+array<boost::int64_t, 3> make_offset(
+    boost::int64_t x
+  , boost::int64_t y
+  , boost::int64_t z
+    )
+{
+    array<boost::int64_t, 3> a;
+    a[0] = x;
+    a[1] = y;
+    a[2] = z;
+    return a;
+}
+
+topology_entry make_entry(
+    boost::uint64_t level
+  , boost::uint64_t x
+  , boost::uint64_t y
+  , boost::uint64_t z
+    )
+{
+    return topology_entry(level, make_location(x, y, z)
+                        , hpx::invalid_id, hpx::invalid_id);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main()
+{
+    octopus::topology_index index;
+
+    // The root, two of its children, and one grandchild in the corner of
+    // the first child that touches the second child.
+    std::vector<topology_entry> update;
+    update.push_back(make_entry(1, 1, 0, 0));
+    update.push_back(make_entry(2, 1, 0, 0));
+    update.push_back(make_entry(0, 0, 0, 0));
+    update.push_back(make_entry(1, 0, 0, 0));
+
+    index.insert(update);
+
+    HPX_TEST_EQ(index.size(), 4U);
+
+    // Inserting a node again replaces it.
+    index.insert(std::vector<topology_entry>(1, make_entry(1, 1, 0, 0)));
+
+    HPX_TEST_EQ(index.size(), 4U);
+
+    HPX_TEST(index.find(0, make_location(0, 0, 0)));
+    HPX_TEST(index.find(1, make_location(1, 0, 0)));
+    HPX_TEST(!index.find(1, make_location(0, 1, 0)));
+    HPX_TEST(!index.find(2, make_location(0, 0, 0)));
+
+    HPX_TEST(index.refined(0, make_location(0, 0, 0)));
+    HPX_TEST(index.refined(1, make_location(0, 0, 0)));
+    HPX_TEST(!index.refined(1, make_location(1, 0, 0)));
+    HPX_TEST(!index.refined(2, make_location(1, 0, 0)));
+
+    // A missing node is covered by its closest existing ancestor.
+    boost::optional<topology_entry> e
+        = index.find_covering(2, make_location(3, 3, 3));
+
+    HPX_TEST(e);
+    HPX_TEST_EQ(e->level, 0U);
+
+    e = index.find_covering(2, make_location(0, 1, 1));
+
+    HPX_TEST(e);
+    HPX_TEST_EQ(e->level, 1U);
+
+    // Face neighbor on a coarser level.
+    e = index.find_neighbor(2, make_location(1, 0, 0), make_offset(1, 0, 0));
+
+    HPX_TEST(e);
+    HPX_TEST_EQ(e->level, 1U);
+    HPX_TEST_EQ(e->location[0], 1U);
+
+    // Corner neighbor which does not exist on its level or the level above.
+    e = index.find_neighbor(2, make_location(1, 1, 1), make_offset(1, 1, 1));
+
+    HPX_TEST(e);
+    HPX_TEST_EQ(e->level, 0U);
+
+    // Neighbors outside of the domain.
+    HPX_TEST(!index.find_neighbor(2, make_location(1, 0, 0)
+                                , make_offset(0, -1, 0)));
+    HPX_TEST(!index.find_neighbor(1, make_location(1, 0, 0)
+                                , make_offset(1, 0, 0)));
+
+    return hpx::util::report_errors();
+}
@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+// Converts binary slices (see octopus/io/slice_format.hpp) to the text format
+// of the 3d_torus equatorial plane output: one line per cell with the cell
+// center, the level and the state.
+//
+//     octopus_slice_to_text FILE [OUTPUT]
+//
+// The text is written to standard output if OUTPUT is not given.
+
+#include <octopus/io/slice_format.hpp>
+
+#include <boost/format.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace slice = octopus::slice;
+
+int fail(char const* file_name, char const* what)
+{
+    std::cerr << "octopus_slice_to_text: " << file_name << ": " << what << "\n";
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char** argv)
+{ // {{{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "usage: octopus_slice_to_text FILE [OUTPUT]\n";
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+
+    if (!in)
+        return fail(argv[1], "cannot open");
+
+    slice::file_header h;
+
+    if (!in.read(reinterpret_cast<char*>(&h), sizeof(h)))
+        return fail(argv[1], "too short");
+
+    if (std::memcmp(h.magic, slice::magic, sizeof(slice::magic)) != 0)
+        return fail(argv[1], "not a slice");
+
+    if (h.byte_order != slice::byte_order_mark)
+        return fail(argv[1], "written with a different byte order");
+
+    if (h.version != slice::format_version)
+        return fail(argv[1], "unsupported format version");
+
+    std::ofstream file;
+
+    if (argc == 3)
+    {
+        file.open(argv[2]);
+
+        if (!file)
+            return fail(argv[2], "cannot create");
+    }
+
+    std::ostream& out = (argc == 3) ? file : std::cout;
+
+    boost::uint64_t const size = slice::record_size(h.state_size);
+
+    // Read many records at a time.
+    std::vector<char> buffer(size * 4096);
+
+    while (in)
+    {
+        in.read(&buffer[0], buffer.size());
+
+        std::streamsize const count = in.gcount();
+
+        if (count % size != 0)
+            return fail(argv[1], "truncated record");
+
+        for (std::streamsize r = 0; r < count; r += size)
+        {
+            double c[3];
+            boost::uint64_t level;
+            std::vector<double> u(h.state_size);
+
+            char const* p = &buffer[r];
+
+            std::memcpy(c, p, sizeof(c));
+            std::memcpy(&level, p + sizeof(c), sizeof(level));
+
+            if (!u.empty())
+                std::memcpy(&u[0], p + sizeof(c) + sizeof(level)
+                          , u.size() * sizeof(double));
+
+            out << ( boost::format("%g %g %g %i")
+                   % c[0]
+                   % c[1]
+                   % c[2]
+                   % level);
+
+            for (boost::uint64_t i = 0; i < u.size(); ++i)
+                out << " " << u[i];
+
+            out << "\n";
+        }
+    }
+
+    return EXIT_SUCCESS;
+} // }}}
+
@@ -0,0 +1,146 @@
+////////////////////////////////////////////////////////////////////////////////
+//  Copyright (c) 2012 Bryce Adelstein-Lelbach
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+////////////////////////////////////////////////////////////////////////////////
+
+// Inspects native Octopus snapshots (see octopus/io/snapshot_format.hpp).
+//
+//     octopus_snapshot info FILE
+//     octopus_snapshot list FILE
+//     octopus_snapshot dump FILE LEVEL X Y Z [COMPONENT]
+//
+// Only the parts of the file that are printed are read from disk.
+
+#include <octopus/io/snapshot_reader.hpp>
+
+#include <boost/lexical_cast.hpp>
+
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using octopus::snapshot::reader;
+using octopus::snapshot::index_entry;
+using octopus::snapshot::node_view;
+
+int usage()
+{
+    std::cerr << "usage: octopus_snapshot info FILE\n"
+                 "       octopus_snapshot list FILE\n"
+                 "       octopus_snapshot dump FILE LEVEL X Y Z [COMPONENT]\n";
+    return EXIT_FAILURE;
+}
+
+void info(reader const& r)
+{
+    octopus::snapshot::file_header const& h = r.header();
+
+    std::cout
+        << "science              = " << h.science << "\n"
+        << "locality             = " << h.locality_id << "\n"
+        << "step                 = " << h.step << "\n"
+        << "time                 = " << h.time << "\n"
+        << "grid_node_length     = " << h.grid_node_length << "\n"
+        << "ghost_zone_length    = " << h.ghost_zone_length << "\n"
+        << "state_size           = " << h.state_size << "\n"
+        << "levels_of_refinement = " << h.levels_of_refinement << "\n"
+        << "spatial_domain       = " << h.spatial_domain << "\n"
+        << "nodes                = " << r.size() << "\n";
+}
+
+void list(reader const& r)
+{
+    for (index_entry const* it = r.begin(); it != r.end(); ++it)
+        std::cout << it->level << " "
+                  << it->location[0] << " "
+                  << it->location[1] << " "
+                  << it->location[2] << " "
+                  << it->offset << " "
+                  << it->dx << "\n";
+}
+
+// Prints one line per cell: the cell center followed by the state.
+int dump(reader const& r, int argc, char** argv)
+{ // {{{
+    boost::uint64_t const level = boost::lexical_cast<boost::uint64_t>(argv[3]);
+    boost::uint64_t const x = boost::lexical_cast<boost::uint64_t>(argv[4]);
+    boost::uint64_t const y = boost::lexical_cast<boost::uint64_t>(argv[5]);
+    boost::uint64_t const z = boost::lexical_cast<boost::uint64_t>(argv[6]);
+
+    index_entry const* e = r.find(level, x, y, z);
+
+    if (!e)
+    {
+        std::cerr << "octopus_snapshot: no such node\n";
+        return EXIT_FAILURE;
+    }
+
+    node_view const v = r.node(*e);
+
+    boost::uint64_t first = 0, last = r.header().state_size;
+
+    if (argc > 7)
+    {
+        first = boost::lexical_cast<boost::uint64_t>(argv[7]);
+        last = first + 1;
+
+        if (first >= r.header().state_size)
+        {
+            std::cerr << "octopus_snapshot: no such component\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << std::setprecision(12);
+
+    for (boost::uint64_t k = 0; k < v.length(); ++k)
+        for (boost::uint64_t j = 0; j < v.length(); ++j)
+            for (boost::uint64_t i = 0; i < v.length(); ++i)
+            {
+                std::cout << 0.5 * (v.faces(0)[i] + v.faces(0)[i + 1]) << " "
+                          << 0.5 * (v.faces(1)[j] + v.faces(1)[j + 1]) << " "
+                          << 0.5 * (v.faces(2)[k] + v.faces(2)[k + 1]);
+
+                for (boost::uint64_t c = first; c < last; ++c)
+                    std::cout << " " << v(i, j, k, c);
+
+                std::cout << "\n";
+            }
+
+    return EXIT_SUCCESS;
+} // }}}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+        return usage();
+
+    std::string const command = argv[1];
+
+    try
+    {
+        reader const r(argv[2]);
+
+        if (command == "info" && argc == 3)
+            info(r);
+        else if (command == "list" && argc == 3)
+            list(r);
+        else if (command == "dump" && (argc == 7 || argc == 8))
+            return dump(r, argc, argv);
+        else
+            return usage();
+    }
+
+    catch (std::exception const& e)
+    {
+        std::cerr << "octopus_snapshot: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+